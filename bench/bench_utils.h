@@ -0,0 +1,119 @@
+#ifndef POLYLLA_BENCH_UTILS_H
+#define POLYLLA_BENCH_UTILS_H
+
+#include <benchmark/benchmark.h>
+#include <gpolylla/generator.h>
+#include <gpolylla/polylla.h>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Polylla::Bench
+{
+struct MeshCase
+{
+    std::string name;
+    std::string nodeFile;
+    std::string eleFile;
+    // Synthetic meshes are generated, the meshes in data/ have none
+    std::optional<LatticeGenerator> generator;
+};
+
+inline MeshCase latticeCase(const std::string &name, const LatticeGenerator &generator)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "gpolylla_bench";
+    return {name, (directory / (name + ".node")).string(), (directory / (name + ".ele")).string(), generator};
+}
+
+inline LatticeGenerator lattice(std::size_t tetras, LatticeGenerator::Split split = LatticeGenerator::Split::Six,
+                                Real grading = 1)
+{
+    LatticeGenerator generator;
+    generator.split = split;
+    generator.grading = grading;
+    generator.resize(tetras);
+    return generator;
+}
+
+// Every mesh in data/ followed by synthetic lattices of growing size
+inline const std::vector<MeshCase> &meshCases()
+{
+    static const std::vector<MeshCase> cases = [] {
+        std::vector<MeshCase> cases;
+        for (const char *name : {"basic", "minimal", "3D_100", "socket", "1000points", "1000points07", "mage", "angel"})
+            cases.push_back({name, std::string(DATA_DIR) + name + ".node", std::string(DATA_DIR) + name + ".ele",
+                             std::nullopt});
+        cases.push_back(latticeCase("lattice6k", lattice(6000)));
+        cases.push_back(latticeCase("graded50k", lattice(50000, LatticeGenerator::Split::Five, 20)));
+        cases.push_back(latticeCase("lattice400k", lattice(400000)));
+        return cases;
+    }();
+    return cases;
+}
+
+// Lattices are written on first use so listing the benchmarks stays cheap
+inline const MeshCase &benchFiles(int i)
+{
+    static std::vector<bool> written(meshCases().size(), false);
+    const MeshCase &mesh = meshCases()[i];
+    if (mesh.generator && !written[i])
+    {
+        std::filesystem::create_directories(std::filesystem::path(mesh.nodeFile).parent_path());
+        mesh.generator->writeTetgen(mesh.nodeFile, mesh.eleFile);
+        written[i] = true;
+    }
+    return mesh;
+}
+
+// Meshes are read once and kept for the whole run
+inline const Mesh &benchMesh(int i)
+{
+    static std::vector<Mesh> meshes(meshCases().size());
+    if (meshes[i].tetras.empty())
+    {
+        benchFiles(i);
+        TetgenReader reader;
+        reader.nodeFile = meshCases()[i].nodeFile;
+        reader.eleFile = meshCases()[i].eleFile;
+        meshes[i] = reader.readMesh();
+    }
+    return meshes[i];
+}
+
+inline const PolyMesh &benchPolyMesh(int i)
+{
+    static std::vector<PolyMesh> results(meshCases().size());
+    if (results[i].cells.empty())
+    {
+        CavityAlgorithm algorithm;
+        results[i] = algorithm(benchMesh(i));
+    }
+    return results[i];
+}
+
+// Labels the run with the mesh and reports tetrahedra per second
+inline void reportMesh(benchmark::State &state)
+{
+    const Mesh &mesh = benchMesh(state.range(0));
+    state.SetLabel(meshCases()[state.range(0)].name);
+    state.counters["tetras"] = static_cast<double>(mesh.tetras.size());
+    state.SetItemsProcessed(state.iterations() * mesh.tetras.size());
+}
+
+inline void allMeshes(benchmark::internal::Benchmark *bench)
+{
+    for (int i = 0; i < meshCases().size(); ++i)
+        bench->Arg(i);
+}
+
+// Quality measures run the convex hull and kernel of every polyhedron, the largest lattice is left out
+inline void statMeshes(benchmark::internal::Benchmark *bench)
+{
+    for (int i = 0; i + 1 < meshCases().size(); ++i)
+        bench->Arg(i);
+}
+} // namespace Polylla::Bench
+
+#endif // POLYLLA_BENCH_UTILS_H
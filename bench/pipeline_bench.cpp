@@ -0,0 +1,157 @@
+#include "bench_utils.h"
+#include <cavity.h>
+#include <gpolylla/stat.h>
+#include <io.h>
+
+#include <filesystem>
+
+using namespace Polylla;
+using namespace Polylla::Bench;
+
+static void BM_BuildVertices(benchmark::State &state)
+{
+    const auto &files = benchFiles(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(buildVertices(files.nodeFile));
+    reportMesh(state);
+}
+BENCHMARK(BM_BuildVertices)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_BuildCells(benchmark::State &state)
+{
+    const auto &files = benchFiles(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(buildCells(files.eleFile));
+    reportMesh(state);
+}
+BENCHMARK(BM_BuildCells)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_BuildFaces(benchmark::State &state)
+{
+    const Mesh &mesh = benchMesh(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(buildFaces(mesh.vertices, mesh.tetras));
+    reportMesh(state);
+}
+BENCHMARK(BM_BuildFaces)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_BuildConnectivity(benchmark::State &state)
+{
+    // Every link is overwritten, so the mesh can be reused between iterations
+    Mesh mesh = benchMesh(state.range(0));
+    for (auto _ : state)
+        buildConnectivity(&mesh);
+    reportMesh(state);
+}
+BENCHMARK(BM_BuildConnectivity)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_Circumsphere(benchmark::State &state)
+{
+    const Mesh &mesh = benchMesh(state.range(0));
+    for (auto _ : state)
+    {
+        for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+            benchmark::DoNotOptimize(circumsphere(ti, mesh));
+    }
+    reportMesh(state);
+}
+BENCHMARK(BM_Circumsphere)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_LabelCavities(benchmark::State &state)
+{
+    const Mesh &mesh = benchMesh(state.range(0));
+    for (auto _ : state)
+    {
+        PolyMesh result;
+        CavityInfo info;
+        labelCavities(mesh, &result, &info);
+        benchmark::DoNotOptimize(info.seeds.data());
+    }
+    reportMesh(state);
+}
+BENCHMARK(BM_LabelCavities)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_BuildCavities(benchmark::State &state)
+{
+    const Mesh &mesh = benchMesh(state.range(0));
+    PolyMesh labelled;
+    CavityInfo labels;
+    labelCavities(mesh, &labelled, &labels);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        PolyMesh result;
+        CavityInfo info = labels;
+        state.ResumeTiming();
+        buildCavities(mesh, &result, &info);
+        benchmark::DoNotOptimize(result.cells.data());
+    }
+    reportMesh(state);
+}
+BENCHMARK(BM_BuildCavities)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+// Whole runs of both algorithms, to compare them on the same meshes
+static void BM_CavityAlgorithm(benchmark::State &state)
+{
+    const Mesh &mesh = benchMesh(state.range(0));
+    CavityAlgorithm algorithm;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(algorithm(mesh).cells.data());
+    reportMesh(state);
+}
+BENCHMARK(BM_CavityAlgorithm)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_FaceAlgorithm(benchmark::State &state)
+{
+    const Mesh &mesh = benchMesh(state.range(0));
+    FaceAlgorithm algorithm;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(algorithm(mesh).cells.data());
+    reportMesh(state);
+}
+BENCHMARK(BM_FaceAlgorithm)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_WriteMesh(benchmark::State &state)
+{
+    const PolyMesh &result = benchPolyMesh(state.range(0));
+    VisFWriter writer;
+    writer.outputFile = (std::filesystem::temp_directory_path() / "gpolylla_bench.visf").string();
+    for (auto _ : state)
+        writer.writeMesh(result);
+    std::filesystem::remove(writer.outputFile);
+    reportMesh(state);
+}
+BENCHMARK(BM_WriteMesh)->Apply(allMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_Hull(benchmark::State &state)
+{
+    const PolyMesh &result = benchPolyMesh(state.range(0));
+    for (auto _ : state)
+    {
+        for (const auto &poly : result.cells)
+            benchmark::DoNotOptimize(Hull(poly, result).volume());
+    }
+    reportMesh(state);
+}
+BENCHMARK(BM_Hull)->Apply(statMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_Kernel(benchmark::State &state)
+{
+    const PolyMesh &result = benchPolyMesh(state.range(0));
+    for (auto _ : state)
+    {
+        for (const auto &poly : result.cells)
+            benchmark::DoNotOptimize(Kernel(poly, result).empty());
+    }
+    reportMesh(state);
+}
+BENCHMARK(BM_Kernel)->Apply(statMeshes)->Unit(benchmark::kMillisecond);
+
+static void BM_ComputeStats(benchmark::State &state)
+{
+    const PolyMesh &result = benchPolyMesh(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(computeStats(result));
+    reportMesh(state);
+}
+BENCHMARK(BM_ComputeStats)->Apply(statMeshes)->Unit(benchmark::kMillisecond);
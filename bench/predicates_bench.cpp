@@ -0,0 +1,52 @@
+#include "bench_utils.h"
+#include <predicates.h>
+
+using namespace Polylla;
+using namespace Polylla::Bench;
+
+static void reportFastPath(benchmark::State &state)
+{
+    const auto &counters = predicateCounters();
+    state.counters["fast_path"] = 1.0 - static_cast<double>(counters.exact) / std::max<std::uint64_t>(counters.calls, 1);
+    state.counters["calls"] = benchmark::Counter(static_cast<double>(counters.calls), benchmark::Counter::kIsRate);
+    reportMesh(state);
+}
+
+// Orientation of every face against the opposite vertex, as the writer does
+static void BM_Orient3d(benchmark::State &state)
+{
+    const Mesh &mesh = benchMesh(state.range(0));
+    predicateCounters() = {};
+    for (auto _ : state)
+    {
+        for (const auto &t : mesh.tetras)
+        {
+            const auto &v = t.vertices;
+            benchmark::DoNotOptimize(orient3d(mesh.vertices[v[0]], mesh.vertices[v[1]], mesh.vertices[v[2]],
+                                              mesh.vertices[v[3]]));
+        }
+    }
+    reportFastPath(state);
+}
+BENCHMARK(BM_Orient3d)->Apply(allMeshes);
+
+// Circumcenter of every face neighbour against the circumsphere, as the cavity search does
+static void BM_SphereSide(benchmark::State &state)
+{
+    const Mesh &mesh = benchMesh(state.range(0));
+    CavityAlgorithm algorithm;
+    algorithm(mesh);
+    const auto &cavities = algorithm.cavities();
+    predicateCounters() = {};
+    for (auto _ : state)
+    {
+        for (const auto &f : mesh.faces)
+        {
+            if (f.tetras[0] == -1 || f.tetras[1] == -1)
+                continue;
+            benchmark::DoNotOptimize(cavities[f.tetras[0]].isInside(cavities[f.tetras[1]].center));
+        }
+    }
+    reportFastPath(state);
+}
+BENCHMARK(BM_SphereSide)->Apply(allMeshes);
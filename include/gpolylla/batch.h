@@ -0,0 +1,80 @@
+#ifndef GPOLYLLA_BATCH_H
+#define GPOLYLLA_BATCH_H
+#include "polylla.h"
+#include "report.h"
+#include "stat.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Polylla
+{
+// Runs many meshes in one process. Reading, the algorithm and writing are stages on their own threads, so the
+// next mesh is read and the previous one written while the algorithm runs on the current one.
+class BatchRunner
+{
+  public:
+    struct Job
+    {
+        std::string nodeFile;
+        std::string eleFile;
+        std::string outputFile;
+    };
+
+    struct Result
+    {
+        Job job;
+        // Phases of the mesh, the processor times cover the whole process
+        RunReport report;
+        std::size_t tetras = 0;
+        std::size_t polyhedra = 0;
+        // Empty if the mesh went through every stage
+        std::string error;
+    };
+
+    std::vector<Job> jobs;
+    // CavityAlgorithm if not set, only used from the algorithm stage
+    Algorithm *algorithm = nullptr;
+    // Also computes the stats and writes a JSON report next to every output
+    bool makeStats = false;
+    // Called in job order from the writing stage, also for failed jobs. If it throws, the meshes left are skipped
+    // and run() rethrows once its threads are joined.
+    std::function<void(const Result &)> onDone;
+
+    const std::vector<Result> &run();
+    // Totals and every mesh of the last run as JSON
+    void writeReport(const std::string &file) const;
+
+    // One mesh per line: a path without extension, a .node and an .ele file, or both and the output. Relative
+    // paths are taken from the manifest directory, lines starting with # are skipped.
+    static std::vector<Job> fromManifest(const std::string &file, const std::string &outputDirectory);
+    // Meshes with a .node and an .ele file matching the pattern, * and ? only in the file name
+    static std::vector<Job> fromGlob(const std::string &pattern, const std::string &outputDirectory);
+
+  private:
+    std::vector<Result> results;
+    double wallMs = 0;
+};
+
+// One mesh with its stages overlapped. The vertex section of the output is written while the cavities are grown,
+// and every polyhedron goes to the writer and to the stats as soon as its search finishes. The stats are computed in
+// batches split over the threads of the algorithm context. The write and stats phases of the report only hold what
+// was left after the cavities.
+class PipelineRunner
+{
+  public:
+    std::string nodeFile;
+    std::string eleFile;
+    std::string outputFile;
+    bool makeStats = false;
+    // Its options apply, onPolyhedron is taken by the pipeline
+    CavityAlgorithm algorithm;
+    RunReport report;
+    // Stats of every polyhedron in order, if makeStats
+    std::vector<PolyStat> stats;
+
+    PolyMesh run();
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_BATCH_H
@@ -0,0 +1,188 @@
+#ifndef GPOLYLLA_BVH_H
+#define GPOLYLLA_BVH_H
+#include "scalar.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace Polylla
+{
+// Bounding volume hierarchy over axis aligned boxes, split at the median of the box centers along the
+// longest axis. Items are the indices of the boxes it was built from.
+class Bvh
+{
+  public:
+    struct Node
+    {
+        Box3 box;
+        // Children, -1 on leaves
+        int left = -1;
+        int right = -1;
+        // Range of items() under a leaf
+        int begin = 0;
+        int end = 0;
+    };
+
+    Bvh() = default;
+    // The top levels are built in parallel
+    explicit Bvh(const std::vector<Box3> &boxes, int leafSize = 4);
+
+    bool empty() const
+    {
+        return nodes_.empty();
+    }
+    const std::vector<Node> &nodes() const
+    {
+        return nodes_;
+    }
+    const std::vector<int> &items() const
+    {
+        return items_;
+    }
+
+    // Calls visit(item) for every item under a node whose box is accepted by enter(box)
+    template <typename Enter, typename Visit> void traverse(Enter &&enter, Visit &&visit) const
+    {
+        if (nodes_.empty())
+            return;
+        std::vector<int> stack = {0};
+        while (!stack.empty())
+        {
+            const Node &node = nodes_[stack.back()];
+            stack.pop_back();
+            if (!enter(node.box))
+                continue;
+            if (node.left == -1)
+            {
+                for (int i = node.begin; i < node.end; ++i)
+                    visit(items_[i]);
+                continue;
+            }
+            stack.push_back(node.right);
+            stack.push_back(node.left);
+        }
+    }
+
+    // Up to k items closest to the point, nearest first. distance(item) must not be smaller than the
+    // distance from the point to the item's box.
+    template <typename Distance>
+    std::vector<std::pair<Real, int>> nearest(const Vector3 &point, int k, Distance &&distance) const
+    {
+        std::vector<std::pair<Real, int>> found;
+        if (nodes_.empty() || k <= 0)
+            return found;
+
+        using Entry = std::pair<Real, int>;
+        // Nodes by distance to their box, and the best k items so far with the farthest on top
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+        std::priority_queue<Entry> best;
+        open.emplace(std::sqrt(nodes_[0].box.squaredExteriorDistance(point)), 0);
+        while (!open.empty())
+        {
+            auto [bound, ni] = open.top();
+            open.pop();
+            if (best.size() == k && bound > best.top().first)
+                break;
+
+            const Node &node = nodes_[ni];
+            if (node.left != -1)
+            {
+                for (int child : {node.left, node.right})
+                    open.emplace(std::sqrt(nodes_[child].box.squaredExteriorDistance(point)), child);
+                continue;
+            }
+            for (int i = node.begin; i < node.end; ++i)
+            {
+                const Real d = distance(items_[i]);
+                if (best.size() < k)
+                    best.emplace(d, items_[i]);
+                else if (Entry(d, items_[i]) < best.top())
+                {
+                    best.pop();
+                    best.emplace(d, items_[i]);
+                }
+            }
+        }
+
+        found.resize(best.size());
+        for (auto it = found.rbegin(); it != found.rend(); ++it)
+        {
+            *it = best.top();
+            best.pop();
+        }
+        return found;
+    }
+
+    // Closest item along the ray from origin, with its distance in multiples of direction. hit(item) is the
+    // distance to the item or infinity if the ray misses it, and must not be smaller than the distance to the
+    // item's box. Boxes are visited nearest first, so the search stops at the first box past the best hit.
+    template <typename Hit>
+    std::optional<std::pair<Real, int>> closestHit(const Vector3 &origin, const Vector3 &direction, Hit &&hit) const
+    {
+        constexpr Real INF = std::numeric_limits<Real>::infinity();
+        if (nodes_.empty())
+            return {};
+
+        using Entry = std::pair<Real, int>;
+        const Vector3 inverse = direction.cwiseInverse();
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+        Entry best(INF, -1);
+        if (const Real entry = rayEntry(nodes_[0].box, origin, inverse); entry < INF)
+            open.emplace(entry, 0);
+        while (!open.empty())
+        {
+            auto [bound, ni] = open.top();
+            open.pop();
+            if (bound > best.first)
+                break;
+
+            const Node &node = nodes_[ni];
+            if (node.left != -1)
+            {
+                for (int child : {node.left, node.right})
+                {
+                    if (const Real entry = rayEntry(nodes_[child].box, origin, inverse); entry < INF)
+                        open.emplace(entry, child);
+                }
+                continue;
+            }
+            for (int i = node.begin; i < node.end; ++i)
+            {
+                const Entry candidate(hit(items_[i]), items_[i]);
+                if (candidate.first < INF && candidate < best)
+                    best = candidate;
+            }
+        }
+        if (best.second == -1)
+            return {};
+        return best;
+    }
+
+    // Distance along the ray where it enters the box, 0 from inside and infinity if it misses (slab test)
+    static Real rayEntry(const Box3 &box, const Vector3 &origin, const Vector3 &inverseDirection)
+    {
+        Real enter = 0, leave = std::numeric_limits<Real>::infinity();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            Real t0 = (box.min()[axis] - origin[axis]) * inverseDirection[axis];
+            Real t1 = (box.max()[axis] - origin[axis]) * inverseDirection[axis];
+            if (t0 > t1)
+                std::swap(t0, t1);
+            // NaN from a flat ray in the plane of a slab leaves the bounds as they were
+            enter = std::max(enter, t0);
+            leave = std::min(leave, t1);
+        }
+        return enter <= leave ? enter : std::numeric_limits<Real>::infinity();
+    }
+
+  private:
+    std::vector<Node> nodes_;
+    std::vector<int> items_;
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_BVH_H
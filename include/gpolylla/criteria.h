@@ -0,0 +1,188 @@
+#ifndef GPOLYLLA_CRITERIA_H
+#define GPOLYLLA_CRITERIA_H
+#include "merge.h"
+#include "polylla.h"
+#include <algorithm>
+#include <concepts>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+namespace Polylla
+{
+// Decides on every interior face alone whether its two tetrahedra go together, see MergeAlgorithm. bind is
+// called once per mesh before the faces are tested, the test runs concurrently.
+template <typename C>
+concept FaceCriterion = requires(C criterion, const C &bound, const Mesh &mesh, int fi) {
+    criterion.bind(mesh);
+    { bound(fi) } -> std::convertible_to<bool>;
+};
+
+// Grows polyhedra from seeds, in the order of seeds(), see GrowAlgorithm. A seed keeps every unclaimed
+// neighbouring tetrahedron it accepts.
+template <typename C>
+concept GrowthCriterion = requires(C criterion, const C &bound, const Mesh &mesh, int seed, int ti) {
+    criterion.bind(mesh);
+    { bound.seeds() } -> std::ranges::input_range;
+    { bound.accepts(seed, ti) } -> std::convertible_to<bool>;
+};
+
+// Polylla-Face: a face joins its tetrahedra if it is the largest face of one of them, ties go to the lower index
+class AreaCriterion
+{
+  public:
+    void bind(const Mesh &mesh);
+    bool operator()(int fi) const
+    {
+        const Face &face = mesh->faces[fi];
+        return fittests_[face.tetras[0]] == fi || fittests_[face.tetras[1]] == fi;
+    }
+    // Largest face of every tetrahedron
+    const std::vector<int> &fittests() const
+    {
+        return fittests_;
+    }
+
+  private:
+    const Mesh *mesh = nullptr;
+    std::vector<int> fittests_;
+};
+
+// Joins tetrahedra of similar size, the smaller volume over the larger must be at least ratio
+class VolumeRatioCriterion
+{
+  public:
+    Real ratio = 0.5;
+
+    void bind(const Mesh &mesh);
+    bool operator()(int fi) const
+    {
+        const Face &face = mesh->faces[fi];
+        const Real a = volumes[face.tetras[0]], b = volumes[face.tetras[1]];
+        return std::min(a, b) >= ratio * std::max(a, b);
+    }
+
+  private:
+    const Mesh *mesh = nullptr;
+    std::vector<Real> volumes;
+};
+
+// The criterion of CavityAlgorithm: seeds by circumradius, a seed accepts the tetrahedra whose circumcenter is
+// inside its circumsphere
+class CavityCriterion
+{
+  public:
+    void bind(const Mesh &mesh);
+    const std::vector<int> &seeds() const
+    {
+        return seeds_;
+    }
+    bool accepts(int seed, int ti) const
+    {
+        return cavities[seed].isInside(cavities[ti].center);
+    }
+
+  private:
+    std::vector<CavityAlgorithm::Cavity> cavities;
+    std::vector<int> seeds_;
+};
+
+// Depth first search from seed over the faces, the tetrahedra accepted by the criterion and not yet in owners are
+// claimed for seed. Appends the tetrahedra in the order they are reached, and the faces of the polyhedron on the
+// boundary or against tetrahedra of another owner.
+template <typename Criterion>
+void growPolyhedron(const Mesh &mesh, const Criterion &criterion, int seed, std::vector<int> *owners,
+                    std::vector<int> *tetras, std::vector<int> *faces)
+{
+    // Tetrahedron and the next of its faces to look across, the explicit stack keeps the order of a recursion
+    std::vector<std::pair<int, int>> stack = {{seed, 0}};
+    (*owners)[seed] = seed;
+    tetras->push_back(seed);
+    while (!stack.empty())
+    {
+        auto [ti, k] = stack.back();
+        if (k == 4)
+        {
+            stack.pop_back();
+            continue;
+        }
+        ++stack.back().second;
+
+        const int fi = mesh.tetras[ti].faces[k];
+        const Face &face = mesh.faces[fi];
+        const int next = face.tetras[0] == ti ? face.tetras[1] : face.tetras[0];
+        if (next == -1)
+        {
+            faces->push_back(fi);
+            continue;
+        }
+        if ((*owners)[next] != -1)
+        {
+            if ((*owners)[next] != seed)
+                faces->push_back(fi);
+            continue;
+        }
+        if (criterion.accepts(seed, next))
+        {
+            (*owners)[next] = seed;
+            tetras->push_back(next);
+            stack.emplace_back(next, 0);
+        }
+        else
+        {
+            faces->push_back(fi);
+        }
+    }
+}
+
+// Algorithm for criteria that grow polyhedra from seeds, one polyhedron per seed still unclaimed in its turn
+template <GrowthCriterion Criterion> class GrowAlgorithm : public Algorithm
+{
+  public:
+    Criterion criterion;
+
+    GrowAlgorithm() = default;
+    explicit GrowAlgorithm(Criterion criterion) : criterion(std::move(criterion))
+    {
+    }
+
+    PolyMesh operator()(const Mesh &mesh) override
+    {
+        ExecutionScope scope(context);
+        context.phase("seeds");
+        criterion.bind(mesh);
+        PolyMesh result;
+        result.vertices = mesh.vertices;
+        result.faces = mesh.faces;
+        result.tetras = mesh.tetras;
+
+        std::vector<int> owners(mesh.tetras.size(), -1);
+        context.phase("polyhedra");
+        // Seeds may be any range, so the fraction done is that of the tetrahedra claimed
+        std::size_t visited = 0, claimed = 0;
+        for (int seed : criterion.seeds())
+        {
+            if (visited++ % 4096 == 0)
+                context.report(static_cast<double>(claimed) / std::max<std::size_t>(owners.size(), 1));
+            if (owners[seed] != -1)
+                continue;
+            Polyhedron poly;
+            growPolyhedron(mesh, criterion, seed, &owners, &poly.cells, &poly.faces);
+            claimed += poly.cells.size();
+            for (int ti : poly.cells)
+            {
+                const auto &vertices = mesh.tetras[ti].vertices;
+                poly.vertices.insert(poly.vertices.end(), vertices.begin(), vertices.end());
+                result.tetras[ti].polyhedron = static_cast<int>(result.cells.size());
+            }
+            std::ranges::sort(poly.vertices);
+            poly.vertices.erase(std::unique(poly.vertices.begin(), poly.vertices.end()), poly.vertices.end());
+            result.cells.push_back(std::move(poly));
+        }
+        context.report(1);
+        return result;
+    }
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_CRITERIA_H
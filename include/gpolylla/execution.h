@@ -0,0 +1,55 @@
+#ifndef GPOLYLLA_EXECUTION_H
+#define GPOLYLLA_EXECUTION_H
+#include "progress.h"
+#include <memory_resource>
+#include <stop_token>
+#include <string>
+
+namespace Polylla
+{
+// How a run executes: where it reports, whether it was cancelled, how many threads it may use and where its large
+// temporary buffers come from. Every member is optional, a default context runs as if there was none. Runs check
+// it between phases and every few thousand items of their long loops.
+struct ExecutionContext
+{
+    // Receives the phases and their fraction done, cancelling it cancels the run
+    Progress *progress = nullptr;
+    // Cancels the run, from a std::stop_source the caller keeps
+    std::stop_token stop;
+    // Most threads a parallel loop of the run uses, 0 for every hardware thread
+    int threads = 0;
+    // Scratch arrays over the tetrahedra or faces that do not outlive a call are allocated from it, nullptr for the
+    // default resource. The result, and what an algorithm keeps for index() and update(), use the default one.
+    std::pmr::memory_resource *memory = nullptr;
+
+    bool cancelled() const
+    {
+        return stop.stop_requested() || (progress && progress->cancelled());
+    }
+    // Throws CancelledError if the run was cancelled
+    void check() const;
+    // Starts a phase on the progress, then checks
+    void phase(const std::string &name) const;
+    // Fraction of the current phase done, then checks
+    void report(double fraction) const;
+    // Most threads a parallel loop of a run under this context uses, started from the calling thread
+    int threadCount() const;
+};
+
+// Applies the thread limit and memory resource of a context to the work started on this thread until it is
+// destroyed, parallel loops pass them on to their workers. Scopes nest.
+class ExecutionScope
+{
+  public:
+    explicit ExecutionScope(const ExecutionContext &context);
+    ~ExecutionScope();
+    ExecutionScope(const ExecutionScope &) = delete;
+    ExecutionScope &operator=(const ExecutionScope &) = delete;
+
+  private:
+    int threads;
+    std::pmr::memory_resource *memory;
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_EXECUTION_H
@@ -0,0 +1,53 @@
+#ifndef GPOLYLLA_GENERATOR_H
+#define GPOLYLLA_GENERATOR_H
+#include "polylla.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace Polylla
+{
+// Synthetic tetrahedral mesh of a box split into a lattice of cells, every cell cut into 5 or 6 tetrahedra that
+// conform across cells. Interior vertices are moved by a random fraction of the local spacing, deterministic for
+// a seed, and the spacing can grow geometrically away from the origin corner to get graded meshes.
+class LatticeGenerator : public Reader
+{
+  public:
+    enum class Split
+    {
+        // One central tetrahedron plus four corners, mirrored on alternate cells
+        Five,
+        // Six tetrahedra around the main diagonal of every cell
+        Six,
+    };
+
+    std::array<int, 3> cells = {10, 10, 10};
+    Vector3 size = Vector3::Ones();
+    Split split = Split::Six;
+    // Largest move of a vertex along each axis, relative to the spacing around it. Below 0.15 no tetrahedron
+    // is inverted.
+    Real jitter = 0.1;
+    // Ratio between the largest and the smallest spacing along each axis, 1 for a uniform lattice
+    Real grading = 1;
+    std::uint64_t seed = 0;
+
+    // Cubic lattice with at least the given amount of tetrahedra
+    void resize(std::size_t tetras);
+    std::size_t vertexCount() const;
+    std::size_t tetraCount() const;
+
+    Vertex vertex(int i, int j, int k) const;
+    // Mesh with its faces and connectivity, the lattice is built in parallel
+    Mesh readMesh() override;
+    // Streams the lattice as tetgen .node and .ele files without keeping it in memory
+    void writeTetgen(const std::string &nodeFile, const std::string &eleFile) const;
+
+  private:
+    Real coordinate(int axis, int index) const;
+    int tetrasPerCell() const;
+    // Tetrahedra of the cell at (i, j, k), positively oriented
+    void cellTetras(int i, int j, int k, std::array<std::array<int, 4>, 6> *tetras) const;
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_GENERATOR_H
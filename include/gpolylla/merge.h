@@ -0,0 +1,95 @@
+#ifndef GPOLYLLA_MERGE_H
+#define GPOLYLLA_MERGE_H
+#include "polylla.h"
+#include "union_find.h"
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Polylla
+{
+// Polyhedra as compressed rows, the tetrahedra of polyhedron pi are tetras[tetraOffsets[pi]] up to
+// tetras[tetraOffsets[pi + 1]], and the same for its faces and vertices
+struct PolyhedraCsr
+{
+    std::vector<int> tetraOffsets = {0};
+    std::vector<int> tetras;
+    std::vector<int> faceOffsets = {0};
+    std::vector<int> faces;
+    std::vector<int> vertexOffsets = {0};
+    std::vector<int> vertices;
+    // Polyhedron of every tetrahedron
+    std::vector<int> owners;
+
+    int size() const
+    {
+        return static_cast<int>(tetraOffsets.size()) - 1;
+    }
+    PolyMesh toPolyMesh(const Mesh &mesh) const;
+};
+
+// Polyhedra made of the sets of tetrahedra. A polyhedron holds its tetrahedra in increasing order, the faces of
+// those tetrahedra on the boundary or shared with another polyhedron, and its sorted vertices. order names one
+// tetrahedron of every set, in the order of the polyhedra; if empty they are ordered by their first tetrahedron.
+PolyhedraCsr assemblePolyhedra(const Mesh &mesh, UnionFind &sets, const std::vector<int> &order = {});
+
+// Calls chunk(context, begin, end) over [0, n) split among the threads
+void parallelChunks(int n, void (*chunk)(void *, int, int), void *context);
+
+// Joins the two tetrahedra of every interior face where merge(fi) holds. The faces are split among the threads
+// and merge is called inline, so it must be safe to call concurrently.
+template <typename Predicate> void uniteFaces(const Mesh &mesh, UnionFind &sets, Predicate &&merge)
+{
+    struct Context
+    {
+        const Mesh *mesh;
+        UnionFind *sets;
+        std::remove_reference_t<Predicate> *merge;
+    } context{&mesh, &sets, std::addressof(merge)};
+
+    auto chunk = [](void *data, int begin, int end) {
+        auto &[mesh, sets, merge] = *static_cast<Context *>(data);
+        for (int fi = begin; fi < end; ++fi)
+        {
+            const Face &face = mesh->faces[fi];
+            if (face.tetras[0] != -1 && face.tetras[1] != -1 && (*merge)(fi))
+                sets->unite(face.tetras[0], face.tetras[1]);
+        }
+    };
+    parallelChunks(static_cast<int>(mesh.faces.size()), chunk, &context);
+}
+
+template <typename Predicate> PolyhedraCsr mergeFaces(const Mesh &mesh, Predicate &&merge)
+{
+    UnionFind sets(static_cast<int>(mesh.tetras.size()));
+    uniteFaces(mesh, sets, std::forward<Predicate>(merge));
+    return assemblePolyhedra(mesh, sets);
+}
+
+// Algorithm for any criterion that decides on every face alone whether its two tetrahedra go together. The
+// predicate takes a face index, if it has a bind(mesh) it is called first (see FaceCriterion).
+template <typename Predicate> class MergeAlgorithm : public Algorithm
+{
+  public:
+    Predicate merge;
+
+    MergeAlgorithm() = default;
+    explicit MergeAlgorithm(Predicate merge) : merge(std::move(merge))
+    {
+    }
+
+    PolyMesh operator()(const Mesh &mesh) override
+    {
+        ExecutionScope scope(context);
+        context.phase("merge");
+        if constexpr (requires { merge.bind(mesh); })
+            merge.bind(mesh);
+        PolyMesh result = mergeFaces(mesh, merge).toPolyMesh(mesh);
+        context.report(1);
+        return result;
+    }
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_MERGE_H
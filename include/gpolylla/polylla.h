@@ -1,8 +1,13 @@
 #ifndef POLYLLA_H
 #define POLYLLA_H
+#include "bvh.h"
+#include "execution.h"
+#include "scalar.h"
 #include <Eigen/Dense>
 #include <array>
+#include <fstream>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -11,10 +16,11 @@ namespace Polylla
 
 class PolyMesh;
 class Mesh;
+class CavityIndex;
 
-struct Vertex : Eigen::Vector3f
+struct Vertex : Vector3
 {
-    using Eigen::Vector3f::Vector3f;
+    using Vector3::Vector3;
 };
 
 struct Face
@@ -29,7 +35,7 @@ struct Face
     std::size_t hash() const;
     // Equality operator
     bool operator==(const Face &other) const;
-    float area(const Mesh &mesh) const;
+    Real area(const Mesh &mesh) const;
 };
 
 struct Tetrahedron
@@ -45,8 +51,8 @@ struct Tetrahedron
     std::size_t hash() const;
     // Equality operator
     bool operator==(const Tetrahedron &other) const;
-    float volume(const Mesh &mesh) const;
-    float area(const Mesh &mesh) const;
+    Real volume(const Mesh &mesh) const;
+    Real area(const Mesh &mesh) const;
 };
 
 struct Polyhedron
@@ -61,8 +67,8 @@ struct Polyhedron
     std::size_t hash() const;
     // Equality operator
     bool operator==(const Polyhedron &other) const;
-    float area(const PolyMesh &mesh) const;
-    float volume(const PolyMesh &mesh) const;
+    Real area(const Mesh &mesh) const;
+    Real volume(const Mesh &mesh) const;
 };
 
 class Mesh
@@ -82,6 +88,9 @@ class PolyMesh : public Mesh
 class Reader
 {
   public:
+    // Reports the reading phases, cancels them and bounds their threads
+    ExecutionContext context;
+
     virtual ~Reader() = default;
     virtual Mesh readMesh() = 0;
 };
@@ -97,6 +106,9 @@ class TetgenReader : public Reader
 class Writer
 {
   public:
+    // Reports the writing and cancels it
+    ExecutionContext context;
+
     virtual void writeMesh(PolyMesh mesh) = 0;
     virtual ~Writer() = default;
 };
@@ -105,12 +117,53 @@ class VisFWriter : public Writer
 {
   public:
     std::string outputFile;
+    // Binary VisF in the native byte order, as VisFReader reads it, instead of text
+    bool binary = false;
     void writeMesh(PolyMesh mesh) override;
 };
 
+// Writes a VisF file one polyhedron at a time, so the PolyMesh never has to be resident
+class VisFStreamWriter
+{
+  public:
+    std::string outputFile;
+    void begin(const std::vector<Vertex> &vertices);
+    // Directed faces use the vertex indices given to begin()
+    void write(const std::vector<std::array<int, 3>> &faces);
+    void write(const Polyhedron &poly, const Mesh &mesh);
+    void end();
+    // Instead of end() when the run failed: removes the output and spill files, so no partial file is left
+    void abort();
+
+  private:
+    std::unique_ptr<std::ofstream> file;
+    std::unique_ptr<std::fstream> facesFile;
+    std::unique_ptr<std::fstream> cellsFile;
+    std::size_t faceCount = 0;
+    std::size_t cellCount = 0;
+};
+
+// Reads a VisF polyhedral mesh back, as VisFWriter writes it, text or binary. VisF stores no tetrahedra, so the
+// result has none: its faces are the triangles as stored, directed outwards of their polyhedron, so a face between
+// two polyhedra comes once per side, and every polyhedron has its faces and their vertices. The file is mapped and its
+// sections parsed in parallel. A binary file has the same sections after its "0 2" (big endian) or "1 2" (little
+// endian) header line: counts and indices as 32 bit integers, coordinates as 64 bit floats.
+class VisFReader
+{
+  public:
+    std::string inputFile;
+    // Reports the reading phases, cancels them and bounds their threads
+    ExecutionContext context;
+
+    PolyMesh readMesh();
+};
+
 class Algorithm
 {
   public:
+    // Reports the phases of every run, cancels them, bounds their threads and provides their large buffers
+    ExecutionContext context;
+
     virtual ~Algorithm() = default;
     virtual PolyMesh operator()(const Mesh &mesh) = 0;
 };
@@ -118,15 +171,35 @@ class Algorithm
 class CavityAlgorithm : public Algorithm
 {
   public:
+    // Merge polyhedra of a single tetrahedron into their best neighbour
+    bool mergeLoners = false;
+    // Called by operator() and update() with every polyhedron as soon as it is grown, in order. With mergeLoners
+    // they come after merging.
+    std::function<void(const Polyhedron &)> onPolyhedron;
+
     PolyMesh operator()(const Mesh &mesh) override;
+    // Result of the last run after editing its mesh. previous[ti] is the index in the last mesh of tetrahedron ti
+    // if it did not change (same vertices in the same order), -1 if it was added or moved. Only the polyhedra
+    // affected by the edit are grown again, the others are copied from the last run with their indices mapped; the
+    // result is the same as running on the edited mesh. Linear passes remain to map the indices and emit the
+    // result, the searches only visit the polyhedra reached from the edit.
+    PolyMesh update(const Mesh &mesh, const std::vector<int> &previous);
 
+    // In double whatever Real is: the radius orders the seeds, and nearly flat tetrahedra have spheres too large
+    // for float to keep them apart
     struct Cavity
     {
         double radius;
-        Vertex center;
+        Eigen::Vector3d center;
         int tetra;
 
-        bool isInside(const Vertex &p) const;
+        // Exact with respect to the stored sphere, whose center and radius are rounded. It is not an insphere test
+        // on the four vertices of the tetrahedron: a point within rounding of the true sphere may fall either way.
+        bool isInside(const Eigen::Vector3d &p) const;
+        bool isInside(const Vertex &p) const
+        {
+            return isInside(Eigen::Vector3d(p.cast<double>()));
+        }
     };
 
     const std::vector<Cavity> &cavities() const
@@ -141,11 +214,19 @@ class CavityAlgorithm : public Algorithm
     {
         return seeds_;
     };
+    // Spatial index over cavities(), built on first use after every run. Concurrent calls are safe, but not
+    // concurrent with a run.
+    const CavityIndex &index() const;
 
   private:
     std::vector<Cavity> cavities_;
     std::vector<int> owners_;
     std::vector<int> seeds_;
+    // Polyhedra of the last run for update(), empty with merged loners. Faces are kept as 4 * tetrahedron +
+    // position of the face in it, which does not depend on the numbering of the faces.
+    std::vector<Polyhedron> polyhedra_;
+    struct LazyIndex;
+    std::shared_ptr<LazyIndex> index_;
 
     // struct Information
     // {
@@ -167,6 +248,180 @@ class CavityAlgorithm : public Algorithm
     //
     // Information info;
 };
+
+// Polylla-Face. Every tetrahedron points to its largest face (ties go to the lower face index) and is joined to
+// the tetrahedron across it, so each polyhedron ends on one terminal face: the largest face of both of its
+// tetrahedra, or of a boundary tetrahedron. Polyhedra come in the order of their terminal faces.
+class FaceAlgorithm : public Algorithm
+{
+  public:
+    PolyMesh operator()(const Mesh &mesh) override;
+
+    // Largest face of every tetrahedron in the last run
+    const std::vector<int> &fittests() const
+    {
+        return fittests_;
+    }
+    // Terminal face of every polyhedron in the last run
+    const std::vector<int> &seeds() const
+    {
+        return seeds_;
+    }
+
+  private:
+    std::vector<int> fittests_;
+    std::vector<int> seeds_;
+};
+// Point queries over the circumspheres of a CavityAlgorithm run, backed by a Bvh over their bounding boxes.
+// Flat tetrahedra have an infinite radius: containing() never returns them, withinRadius() and nearest() see them
+// at the first vertex, which stands as their center.
+class CavityIndex
+{
+  public:
+    CavityIndex() = default;
+    explicit CavityIndex(std::vector<CavityAlgorithm::Cavity> cavities);
+
+    // Cavities whose sphere contains the point, as in Cavity::isInside
+    std::vector<int> containing(const Vertex &point) const;
+    // Cavities whose center is at most radius away from the point
+    std::vector<int> withinRadius(const Vertex &point, Real radius) const;
+    // The k cavities with the nearest centers, nearest first
+    std::vector<int> nearest(const Vertex &point, int k) const;
+
+    const std::vector<CavityAlgorithm::Cavity> &cavities() const
+    {
+        return cavities_;
+    }
+    const Bvh &bvh() const
+    {
+        return bvh_;
+    }
+
+  private:
+    std::vector<CavityAlgorithm::Cavity> cavities_;
+    Bvh bvh_;
+};
+
+// Ray picking over the tetrahedra of a mesh, backed by a Bvh over their bounding boxes. The mesh is not copied
+// and must outlive the index.
+class TetraIndex
+{
+  public:
+    struct Hit
+    {
+        int tetra = -1;
+        int face = -1;
+        // Along the ray, in multiples of its direction
+        Real distance = std::numeric_limits<Real>::infinity();
+    };
+
+    TetraIndex() = default;
+    explicit TetraIndex(const Mesh &mesh);
+
+    // Closest tetrahedron crossed by the ray from origin, among those accepted if given. tetra is -1 on a miss.
+    Hit pick(const Vector3 &origin, const Vector3 &direction,
+             const std::function<bool(int)> &accept = nullptr) const;
+
+    const Bvh &bvh() const
+    {
+        return bvh_;
+    }
+
+  private:
+    const Mesh *mesh = nullptr;
+    Bvh bvh_;
+};
+
+// Out-of-core version of CavityAlgorithm that reads TetGen files and writes VisF directly.
+// Tetrahedra are spilled to disk in spatial blocks; each block is processed together with a halo
+// of neighbouring tetrahedra sized by the circumsphere radii, and only its polyhedra are written. The halo grows
+// until the block's polyhedra are bounded, up to one block diagonal; tetrahedra left over are then grown among
+// themselves, again block by block. Only the vertices, one bit per tetrahedron and the current block with its
+// neighbours stay resident.
+// The result is approximate: a seed of smaller radius outside the halo can still reach a block through a chain of
+// seeds, which no halo width rules out, so polyhedra near block boundaries may differ from those of
+// CavityAlgorithm. It is the same when the whole mesh fits in one block. Every tetrahedron still ends in exactly
+// one polyhedron. Loners are not merged.
+class StreamingCavityAlgorithm
+{
+  public:
+    std::string nodeFile;
+    std::string eleFile;
+    std::string outputFile;
+    // Where block files are spilled, defaults to "<outputFile>.blocks"
+    std::string spillDirectory;
+    // Target amount of tetrahedra per block
+    int blockSize = 1 << 16;
+    // Initial halo width in circumsphere radii of the block, at most this many block diagonals
+    float haloFactor = 2.0f;
+    // Called with the (global) tetrahedra of every written polyhedron
+    std::function<void(const std::vector<int> &)> onPolyhedron;
+
+    void operator()();
+};
+
+// Message channel between the processes of a distributed run. Messages between two ranks arrive in order.
+class Transport
+{
+  public:
+    virtual ~Transport() = default;
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+    virtual void send(int to, const std::vector<char> &message) = 0;
+    virtual std::vector<char> receive(int from) = 0;
+};
+
+// Transport over stream sockets in a star around rank 0, workers only talk to rank 0. POSIX only.
+class SocketTransport : public Transport
+{
+  public:
+    ~SocketTransport() override;
+    int rank() const override;
+    int size() const override;
+    void send(int to, const std::vector<char> &message) override;
+    std::vector<char> receive(int from) override;
+
+    // Forks size - 1 local workers connected by socket pairs. Returns in every process, with its own rank.
+    static std::unique_ptr<SocketTransport> spawn(int size);
+    // Rank 0 waits for size - 1 workers on a TCP port
+    static std::unique_ptr<SocketTransport> listen(unsigned short port, int size);
+    // Workers connect to rank 0 on a TCP port
+    static std::unique_ptr<SocketTransport> connect(const std::string &host, unsigned short port, int rank, int size);
+
+  private:
+    SocketTransport(int rank, int size);
+    int rank_;
+    int size_;
+    // Indexed by rank, -1 where there is no connection
+    std::vector<int> sockets;
+    // Processes forked by spawn, waited for on destruction
+    std::vector<int> children;
+};
+
+// CavityAlgorithm over several processes. Rank 0 splits the tetrahedra in Morton ranges, one per rank, and
+// sends each rank its range plus a ghost layer sized by the circumsphere radii. Every rank grows the cavities
+// of its region and returns those seeded in its range that never reach the edge of the ghost layer. Rank 0
+// merges them and grows the tetrahedra left unclaimed (or claimed twice) with the accepted ones held fixed.
+// The result is approximate: a rank only sees the seeds of its region, and the leftovers grow around the accepted
+// polyhedra instead of competing with them, so polyhedra near range boundaries may differ from those of
+// CavityAlgorithm. Claims between ranks are not settled in seed order, the leftovers are grown serially on rank 0.
+// With one rank the result is the same. Every tetrahedron still ends in exactly one polyhedron. Loners are not
+// merged.
+class DistributedCavityAlgorithm : public Algorithm
+{
+  public:
+    Transport *transport = nullptr;
+    // Ghost layer width in circumsphere radii (90th percentile of a sample of the range), capped to the range
+    // diagonal
+    float haloFactor = 2.0f;
+    // If set, every rank also writes the polyhedra it contributed to "<shardPrefix>_<rank>.visf"
+    std::string shardPrefix;
+
+    // Called on rank 0 with the whole mesh
+    PolyMesh operator()(const Mesh &mesh) override;
+    // Called on every other rank, handles one run of rank 0
+    void serve();
+};
 } // namespace Polylla
 
 // Hash function specializations for std::unordered_set and std::unordered_map
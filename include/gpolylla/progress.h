@@ -0,0 +1,46 @@
+#ifndef GPOLYLLA_PROGRESS_H
+#define GPOLYLLA_PROGRESS_H
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace Polylla
+{
+// Thrown by a run whose Progress was cancelled
+class CancelledError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+// Progress of a long run, reported by the run and read from any other thread, and its cooperative cancellation.
+// A run stops at its next report after cancel() by throwing CancelledError.
+class Progress
+{
+  public:
+    // Starts a phase with nothing done yet
+    void phase(const std::string &name);
+    // Fraction of the current phase done, in [0, 1]
+    void report(double fraction);
+    void cancel();
+
+    bool cancelled() const
+    {
+        return cancelled_.load(std::memory_order_relaxed);
+    }
+    double fraction() const
+    {
+        return fraction_.load(std::memory_order_relaxed);
+    }
+    std::string currentPhase() const;
+
+  private:
+    mutable std::mutex mutex;
+    std::string phase_;
+    std::atomic<double> fraction_ = 0;
+    std::atomic<bool> cancelled_ = false;
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_PROGRESS_H
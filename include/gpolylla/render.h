@@ -0,0 +1,173 @@
+#ifndef GPOLYLLA_RENDER_H
+#define GPOLYLLA_RENDER_H
+#include "polylla.h"
+#include "stat.h"
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace Polylla
+{
+// Vertex of the packed cell buffer, laid out for a single vertex array: position, face normal and the
+// tetrahedron the triangle belongs to, which indexes the per cell colors on the GPU
+struct CellVertex
+{
+    float position[3];
+    float normal[3];
+    int cell;
+};
+
+// Triangles of every tetrahedron in one vertex buffer, flat shaded so vertices are not shared. The four faces of
+// tetrahedron ti are the vertices [first(ti), first(ti) + VERTICES_PER_CELL), counter-clockwise seen from outside.
+struct CellBuffer
+{
+    static constexpr int VERTICES_PER_CELL = 12;
+    std::vector<CellVertex> vertices;
+
+    static int first(int ti)
+    {
+        return ti * VERTICES_PER_CELL;
+    }
+    int cellCount() const
+    {
+        return static_cast<int>(vertices.size()) / VERTICES_PER_CELL;
+    }
+};
+
+// Built in parallel over the tetrahedra
+CellBuffer buildCellBuffer(const Mesh &mesh);
+
+// Hue in degrees, saturation and value in [0, 1]
+std::array<float, 3> hsvToRgb(float h, float s, float v);
+// Color of a cell of the given hue, saturated and bright so that neighbours stand apart
+inline std::array<float, 3> cellColor(float hue)
+{
+    return hsvToRgb(hue, 0.8f, 0.8f);
+}
+// One cell color of random hue per cell, the same ones for the same seed
+std::vector<std::array<float, 3>> cellColors(int count, unsigned seed);
+
+// The faces seen when the visible tetrahedra are opaque: those of visible tetrahedra against the boundary or a
+// hidden tetrahedron, and against a visible tetrahedron of another group if groups are given (the polyhedron of
+// every tetrahedron, to see polyhedra apart). A face between two visible groups is kept once per side. Sides are
+// 4 * tetra + the face's index in Tetrahedron::faces, so the face of a side starts at vertex 3 * side of a
+// CellBuffer. Hiding or showing a tetrahedron only updates the sides of its faces. The mesh must outlive it.
+class VisibleSurface
+{
+  public:
+    VisibleSurface() = default;
+    // Every tetrahedron starts visible, built in parallel
+    explicit VisibleSurface(const Mesh &mesh, std::vector<int> groups = {});
+
+    void setVisible(int ti, bool visible);
+    bool visible(int ti) const
+    {
+        return visible_[ti];
+    }
+
+    // Sides on the surface, in no particular order
+    const std::vector<int> &sides() const
+    {
+        return sides_;
+    }
+    // Triangle of every side over the mesh vertices, counter-clockwise seen from outside its tetrahedron
+    const std::vector<std::array<int, 3>> &triangles() const
+    {
+        return triangles_;
+    }
+
+  private:
+    const Mesh *mesh = nullptr;
+    std::vector<int> groups;
+    std::vector<char> visible_;
+    // Where every side is in sides_, -1 if not on the surface
+    std::vector<int> positions;
+    std::vector<int> sides_;
+    std::vector<std::array<int, 3>> triangles_;
+
+    bool seen(int side) const;
+    std::array<int, 3> triangle(int side) const;
+    void update(int side);
+};
+
+// Convex hulls of the polyhedra, to draw distant polyhedra with few triangles. The hull of polyhedron pi is the
+// vertices [offsets[pi], offsets[pi + 1]), counter-clockwise seen from outside, and their cell is the first
+// tetrahedron of the polyhedron so they take its color.
+struct HullBuffer
+{
+    std::vector<CellVertex> vertices;
+    std::vector<int> offsets;
+};
+
+// Built in parallel over the polyhedra, from the hulls of stats when given
+HullBuffer buildHullBuffer(const PolyMesh &mesh, const std::vector<PolyStat> &stats = {});
+
+// The six planes of a view frustum, pointing inwards
+struct Frustum
+{
+    std::array<Eigen::Matrix<Real, 4, 1>, 6> planes;
+
+    // From a column major view projection matrix with OpenGL clip space, as glm builds them
+    static Frustum fromMatrix(const float *viewProjection);
+    // False only if the box is entirely outside one plane, so boxes near the corners may be kept
+    bool intersects(const Box3 &box) const;
+};
+
+// Tetrahedra in spatially compact clusters of about clusterSize, to cull and simplify a cluster at a time. The
+// tetrahedra of a group (the polyhedron of every tetrahedron) are never split. Groups are taken in Morton order
+// of their centers, and a Bvh over the cluster boxes finds those in a frustum.
+class CellClusters
+{
+  public:
+    CellClusters() = default;
+    // Box of every tetrahedron
+    explicit CellClusters(const std::vector<Box3> &boxes, const std::vector<int> &groups = {}, int clusterSize = 256);
+
+    int size() const
+    {
+        return static_cast<int>(boxes_.size());
+    }
+    int clusterOf(int ti) const
+    {
+        return clusters_[ti];
+    }
+    const Box3 &box(int cluster) const
+    {
+        return boxes_[cluster];
+    }
+    // Clusters whose box meets the frustum, in increasing order
+    std::vector<int> visible(const Frustum &frustum) const;
+
+  private:
+    std::vector<int> clusters_;
+    std::vector<Box3> boxes_;
+    Bvh bvh;
+};
+
+// Circumsphere of a tetrahedron as instance attributes of one sphere mesh
+struct SphereInstance
+{
+    float center[3];
+    float radius;
+};
+
+// Which circumspheres are drawn
+struct SphereFilter
+{
+    Real minRadius = 0;
+    Real maxRadius = std::numeric_limits<Real>::infinity();
+    // Only those of the tetrahedra with this owner, if not -1
+    int owner = -1;
+
+    bool operator==(const SphereFilter &other) const = default;
+};
+
+// The circumspheres of cavities (one per tetrahedron, as CavityAlgorithm::cavities()) that pass the filter, in
+// tetrahedron order. owners labels every tetrahedron, by polyhedron or by seed as CavityAlgorithm::owners(), and is
+// only read when the filter has an owner. Spheres of flat tetrahedra are infinite and skipped. Filled in parallel
+// into the storage of instances, so filtering again allocates nothing once it has grown.
+void fillSphereInstances(const std::vector<CavityAlgorithm::Cavity> &cavities, const std::vector<int> &owners,
+                         const SphereFilter &filter, std::vector<SphereInstance> *instances);
+} // namespace Polylla
+
+#endif // GPOLYLLA_RENDER_H
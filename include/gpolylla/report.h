@@ -0,0 +1,95 @@
+#ifndef GPOLYLLA_REPORT_H
+#define GPOLYLLA_REPORT_H
+#include "polylla.h"
+#include "stat.h"
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Polylla
+{
+// Summary of one measure over the polyhedra, the histogram splits [min, max] in equal bins
+struct MeasureSummary
+{
+    double min = 0;
+    double max = 0;
+    double mean = 0;
+    int argMin = -1;
+    int argMax = -1;
+    std::vector<int> histogram;
+
+    static MeasureSummary of(const std::vector<double> &values, int bins = 10);
+};
+
+// Timings, sizes and quality of one run, written as JSON. The total is the wall and processor time from the start
+// of the first measured phase to the end of the last one.
+class RunReport
+{
+  public:
+    struct Phase
+    {
+        std::string name;
+        double wallMs = 0;
+        // Processor time of the whole process while the phase ran: the threads of its parallel loops, but also
+        // any other work that overlapped it, such as the other stages of a pipeline
+        double processCpuMs = 0;
+        // Tetrahedra and bytes handled, for the throughput
+        std::size_t tetras = 0;
+        std::size_t bytes = 0;
+    };
+
+    std::string input;
+    std::string output;
+    // Threads the run may use, see ExecutionContext::threadCount
+    int threads = 1;
+    std::vector<Phase> phases;
+
+    // Runs the work as a new phase and returns its result
+    template <typename Work> auto measure(const std::string &name, Work &&work)
+    {
+        const auto wall = std::chrono::steady_clock::now();
+        const double cpu = cpuTime();
+        if constexpr (std::is_void_v<decltype(work())>)
+        {
+            work();
+            record(name, wall, cpu);
+        }
+        else
+        {
+            auto result = work();
+            record(name, wall, cpu);
+            return result;
+        }
+    }
+    Phase &phase(const std::string &name);
+
+    void setMesh(const Mesh &mesh);
+    void setResult(const PolyMesh &result);
+    void setStats(const std::vector<PolyStat> &stats);
+    void write(const std::string &file) const;
+
+    // Processor time of the whole process and its largest resident size so far
+    static double cpuTime();
+    static std::size_t peakMemory();
+
+  private:
+    std::size_t vertices = 0;
+    std::size_t faces = 0;
+    std::size_t tetras = 0;
+    std::size_t polyhedra = 0;
+    double coverage = 0;
+    MeasureSummary polyhedronTetras;
+    int kernels = 0;
+    std::vector<std::pair<std::string, MeasureSummary>> quality;
+    bool timed = false;
+    std::chrono::steady_clock::time_point firstWall, lastWall;
+    double firstCpu = 0;
+    double lastCpu = 0;
+
+    void record(const std::string &name, std::chrono::steady_clock::time_point wall, double cpu);
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_REPORT_H
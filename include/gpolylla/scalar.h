@@ -0,0 +1,19 @@
+#ifndef GPOLYLLA_SCALAR_H
+#define GPOLYLLA_SCALAR_H
+#include <Eigen/Geometry>
+
+namespace Polylla
+{
+// Scalar of every coordinate and measure. Float keeps large meshes small, GPOLYLLA_DOUBLE (CMake option of the
+// same name) builds the whole library in double for precision sensitive runs. Both share the same code.
+#ifdef GPOLYLLA_DOUBLE
+using Real = double;
+#else
+using Real = float;
+#endif
+
+using Vector3 = Eigen::Matrix<Real, 3, 1>;
+using Box3 = Eigen::AlignedBox<Real, 3>;
+} // namespace Polylla
+
+#endif // GPOLYLLA_SCALAR_H
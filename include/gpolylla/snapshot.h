@@ -0,0 +1,63 @@
+#ifndef GPOLYLLA_SNAPSHOT_H
+#define GPOLYLLA_SNAPSHOT_H
+#include "polylla.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Polylla
+{
+// Perspective camera of a snapshot, fieldOfView is vertical and in degrees
+struct Camera
+{
+    Vector3 eye = Vector3(0, 0, 1);
+    Vector3 target = Vector3::Zero();
+    Vector3 up = Vector3(0, 1, 0);
+    Real fieldOfView = 60;
+
+    // Looks at the center of the mesh from direction, far enough for its bounding sphere to fit
+    static Camera framing(const Mesh &mesh, const Vector3 &direction = Vector3(1, 0.6f, 0.8f));
+    // Unit direction of the ray from the eye through the center of pixel (x, y), y down
+    Vector3 ray(int x, int y, int width, int height) const;
+};
+
+// 8 bit RGB pixels, rows from the top
+struct Image
+{
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> pixels;
+
+    const std::uint8_t *pixel(int x, int y) const
+    {
+        return pixels.data() + 3 * (static_cast<std::size_t>(y) * width + x);
+    }
+    void writePpm(const std::string &file) const;
+    // Uncompressed, so it needs no zlib
+    void writePng(const std::string &file) const;
+    // PNG or PPM, by the extension of the file
+    void write(const std::string &file) const;
+};
+
+// Renders the boundary of a mesh on the CPU, for previews where OpenGL cannot run. Every polyhedron gets a cell
+// color of random hue as in the renderer, a mesh without polyhedra is colored by tetrahedron. Faces are flat shaded
+// by the angle they are seen at. Tiles of the image are rasterized in parallel, each with its own depth buffer.
+// Triangles crossing the plane of the eye are dropped, the camera is meant to be outside the mesh.
+class Snapshot
+{
+  public:
+    Camera camera;
+    int width = 800;
+    int height = 600;
+    std::array<float, 3> background = {1, 1, 1};
+    // Seed of the colors, the same seed paints the same polyhedra alike
+    unsigned seed = 0;
+    // Checked between phases, bounds the threads of the tiles
+    ExecutionContext context;
+
+    Image operator()(const Mesh &mesh) const;
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_SNAPSHOT_H
@@ -13,14 +13,24 @@ namespace Polylla
 class Hull
 {
 
-    std::vector<Face> faces;
-    std::vector<Vertex> vertices;
+    std::vector<Face> faces_;
+    std::vector<Vertex> vertices_;
 
   public:
     Hull() = default;
-    Hull(const Polyhedron &poly, const PolyMesh &mesh);
-    float area() const;
-    float volume() const;
+    Hull(const Polyhedron &poly, const Mesh &mesh);
+    Real area() const;
+    Real volume() const;
+    // Triangles over vertices()
+    const std::vector<Face> &faces() const
+    {
+        return faces_;
+    }
+    // The vertices of the polyhedron, in its order
+    const std::vector<Vertex> &vertices() const
+    {
+        return vertices_;
+    }
 };
 
 class Kernel
@@ -30,17 +40,17 @@ class Kernel
 
   public:
     Kernel() = default;
-    Kernel(const Polyhedron &poly, const PolyMesh &mesh);
-    float area() const;
-    float volume() const;
+    Kernel(const Polyhedron &poly, const Mesh &mesh);
+    Real area() const;
+    Real volume() const;
     bool empty() const;
 };
 
 struct PolyStat
 {
-    float edgeRatio;
-    float volumeRatio;
-    float surfaceRatio;
+    Real edgeRatio;
+    Real volumeRatio;
+    Real surfaceRatio;
     std::optional<Kernel> kernel;
     Hull hull;
 };
@@ -53,7 +63,9 @@ struct PolyStat
 //   std::vector<Hull> hulls;
 // };
 
-std::vector<PolyStat> computeStats(const PolyMesh &mesh);
+// Stats of one polyhedron, the mesh only needs its vertices, faces and tetrahedra
+PolyStat computeStat(const Polyhedron &poly, const Mesh &mesh);
+std::vector<PolyStat> computeStats(const PolyMesh &mesh, const ExecutionContext &context = {});
 
 } // namespace Polylla
 
@@ -0,0 +1,21 @@
+#ifndef GPOLYLLA_TRACE_H
+#define GPOLYLLA_TRACE_H
+#include <cstdint>
+#include <string>
+
+namespace Polylla
+{
+// Spans and counters are only recorded when the library is built with GPOLYLLA_TRACE
+bool tracingEnabled();
+// Both may be called while traced work is running, spans still open are left out
+void clearTrace();
+// Allocations counted so far in the whole process, 0 unless tracing is enabled and the allocation functions call
+// countAllocation, as those of the executable built with GPOLYLLA_COUNT_ALLOCATIONS do
+std::uint64_t allocationTotal();
+// Counts one allocation for the spans of the calling thread and allocationTotal
+void countAllocation() noexcept;
+// Chrome trace event JSON, opens in chrome://tracing and Perfetto
+void writeTrace(const std::string &file);
+} // namespace Polylla
+
+#endif // GPOLYLLA_TRACE_H
@@ -0,0 +1,64 @@
+#ifndef GPOLYLLA_UNION_FIND_H
+#define GPOLYLLA_UNION_FIND_H
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace Polylla
+{
+// Disjoint sets that many threads can unite and find at once without locks. Roots are linked by index, the
+// larger under the smaller, so the smallest element of every set is its root whatever the order of the unions.
+class UnionFind
+{
+  public:
+    explicit UnionFind(int n) : parents(new std::atomic<int>[n]), n(n)
+    {
+        for (int i = 0; i < n; ++i)
+            parents[i].store(i, std::memory_order_relaxed);
+    }
+
+    int size() const
+    {
+        return n;
+    }
+
+    // Path halving, a failed shortcut only means another thread shortened the path first
+    int find(int x)
+    {
+        while (true)
+        {
+            int parent = parents[x].load(std::memory_order_acquire);
+            if (parent == x)
+                return x;
+            const int grandparent = parents[parent].load(std::memory_order_acquire);
+            if (parent != grandparent)
+                parents[x].compare_exchange_weak(parent, grandparent, std::memory_order_acq_rel);
+            x = grandparent;
+        }
+    }
+
+    // Returns false if a and b were already in the same set
+    bool unite(int a, int b)
+    {
+        while (true)
+        {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return false;
+            if (a > b)
+                std::swap(a, b);
+            // b may have been linked by another thread since it was found, then try again from the new roots
+            int expected = b;
+            if (parents[b].compare_exchange_strong(expected, a, std::memory_order_acq_rel))
+                return true;
+        }
+    }
+
+  private:
+    std::unique_ptr<std::atomic<int>[]> parents;
+    int n;
+};
+} // namespace Polylla
+
+#endif // GPOLYLLA_UNION_FIND_H
@@ -0,0 +1,455 @@
+#include "io.h"
+#include "parallel.h"
+#include "pipeline.h"
+#include "trace.h"
+#include <gpolylla/batch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace Polylla;
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace
+{
+// Polyhedra handed to the stats threads at once by the pipeline
+constexpr size_t STATS_BATCH = 256;
+
+struct Loaded
+{
+    int index;
+    Mesh mesh;
+};
+
+struct Computed
+{
+    int index;
+    Mesh mesh;
+    PolyMesh result;
+};
+
+bool wildcardMatch(const string &pattern, const string &name)
+{
+    size_t p = 0, n = 0, star = string::npos, retry = 0;
+    while (n < name.size())
+    {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+        {
+            ++p;
+            ++n;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            retry = n;
+        }
+        else if (star != string::npos)
+        {
+            p = star + 1;
+            n = ++retry;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+    return p == pattern.size();
+}
+
+BatchRunner::Job makeJob(const fs::path &node, const fs::path &ele, const fs::path &output,
+                         const string &outputDirectory)
+{
+    BatchRunner::Job job;
+    job.nodeFile = node.string();
+    job.eleFile = ele.string();
+    job.outputFile = output.empty() ? (fs::path(outputDirectory) / ele.stem()).string() + ".visf" : output.string();
+    return job;
+}
+} // namespace
+
+const vector<BatchRunner::Result> &BatchRunner::run()
+{
+    GPOLYLLA_TRACE_SCOPE("BatchRunner");
+    const auto start = chrono::steady_clock::now();
+    const int count = static_cast<int>(jobs.size());
+    results.assign(count, Result());
+    CavityAlgorithm cavity;
+    Algorithm &compute = algorithm ? *algorithm : cavity;
+    const int threads = compute.context.threadCount();
+
+    // One mesh waiting between stages, so at most one is read ahead and one waits for its writing
+    BoundedQueue<Loaded> toCompute(1);
+    BoundedQueue<Computed> toWrite(1);
+    // Set if onDone throws, the stages then skip the meshes left so they can be joined
+    atomic<bool> stopping = false;
+
+    thread reading([&] {
+        for (int i = 0; i < count && !stopping; ++i)
+        {
+            Result &r = results[i];
+            r.job = jobs[i];
+            r.report.input = jobs[i].eleFile;
+            r.report.output = jobs[i].outputFile;
+            r.report.threads = threads;
+            Loaded loaded{i, {}};
+            try
+            {
+                TetgenReader reader;
+                reader.nodeFile = jobs[i].nodeFile;
+                reader.eleFile = jobs[i].eleFile;
+                loaded.mesh = r.report.measure("read", [&] { return reader.readMesh(); });
+                r.tetras = loaded.mesh.tetras.size();
+                r.report.phase("read").tetras = r.tetras;
+                r.report.phase("read").bytes = fs::file_size(jobs[i].nodeFile) + fs::file_size(jobs[i].eleFile);
+            }
+            catch (const exception &e)
+            {
+                r.error = e.what();
+            }
+            toCompute.push(std::move(loaded));
+        }
+        toCompute.close();
+    });
+
+    thread computing([&] {
+        while (auto loaded = toCompute.pop())
+        {
+            Result &r = results[loaded->index];
+            Computed computed{loaded->index, std::move(loaded->mesh), {}};
+            if (r.error.empty() && !stopping)
+            {
+                try
+                {
+                    computed.result = r.report.measure("cavities", [&] { return compute(computed.mesh); });
+                    r.report.phase("cavities").tetras = r.tetras;
+                    r.polyhedra = computed.result.cells.size();
+                }
+                catch (const exception &e)
+                {
+                    r.error = e.what();
+                }
+            }
+            toWrite.push(std::move(computed));
+        }
+        toWrite.close();
+    });
+
+    try
+    {
+        while (auto computed = toWrite.pop())
+        {
+            Result &r = results[computed->index];
+            if (r.error.empty())
+            {
+                try
+                {
+                    VisFWriter writer;
+                    writer.outputFile = r.job.outputFile;
+                    fs::path parent = fs::path(writer.outputFile).parent_path();
+                    if (!parent.empty())
+                        fs::create_directories(parent);
+                    r.report.measure("write", [&] { writer.writeMesh(computed->result); });
+                    r.report.phase("write").bytes = fs::file_size(writer.outputFile);
+                    if (makeStats)
+                    {
+                        auto stats = r.report.measure("stats", [&] { return computeStats(computed->result); });
+                        r.report.phase("stats").tetras = r.tetras;
+                        r.report.setMesh(computed->mesh);
+                        r.report.setResult(computed->result);
+                        r.report.setStats(stats);
+                        r.report.write(fs::path(writer.outputFile).replace_extension(".json").string());
+                    }
+                }
+                catch (const exception &e)
+                {
+                    r.error = e.what();
+                }
+            }
+            if (onDone)
+                onDone(r);
+        }
+    }
+    catch (...)
+    {
+        stopping = true;
+        while (toWrite.pop())
+        {
+        }
+        reading.join();
+        computing.join();
+        throw;
+    }
+    reading.join();
+    computing.join();
+    wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return results;
+}
+
+void BatchRunner::writeReport(const string &file) const
+{
+    ofstream out(file);
+    if (!out.is_open())
+        throw runtime_error("Unable to create file: " + file);
+    out.precision(9);
+
+    // Phase times summed over the meshes, against the wall time they overlapped in
+    vector<pair<string, double>> phases;
+    size_t tetras = 0;
+    int failed = 0;
+    for (const auto &r : results)
+    {
+        failed += !r.error.empty();
+        if (r.error.empty())
+            tetras += r.tetras;
+        for (const auto &p : r.report.phases)
+        {
+            auto it = ranges::find(phases, p.name, &pair<string, double>::first);
+            if (it == phases.end())
+                phases.emplace_back(p.name, p.wallMs);
+            else
+                it->second += p.wallMs;
+        }
+    }
+
+    out << "{\n";
+    out << "  \"meshes\": " << results.size() << ",\n";
+    out << "  \"failed\": " << failed << ",\n";
+    out << "  \"wallMs\": " << wallMs << ",\n";
+    out << "  \"tetras\": " << tetras << ",\n";
+    out << "  \"tetrasPerSecond\": " << (wallMs > 0 ? tetras / (wallMs / 1e3) : 0) << ",\n";
+    out << "  \"phaseMs\": {";
+    for (int i = 0; i < phases.size(); ++i)
+        out << (i ? ", " : "") << jsonString(phases[i].first) << ": " << phases[i].second;
+    out << "},\n";
+    out << "  \"peakResidentBytes\": " << RunReport::peakMemory() << ",\n";
+    out << "  \"runs\": [";
+    for (int i = 0; i < results.size(); ++i)
+    {
+        const Result &r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"input\": " << jsonString(r.job.eleFile)
+            << ", \"output\": " << jsonString(r.job.outputFile) << ", \"tetras\": " << r.tetras
+            << ", \"polyhedra\": " << r.polyhedra;
+        for (const auto &p : r.report.phases)
+            out << ", " << jsonString(p.name + "Ms") << ": " << p.wallMs;
+        if (!r.error.empty())
+            out << ", \"error\": " << jsonString(r.error);
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+vector<BatchRunner::Job> BatchRunner::fromManifest(const string &file, const string &outputDirectory)
+{
+    ifstream in(file);
+    if (!in.is_open())
+        throw FileNotFoundError("Unable to open file: " + file);
+    const fs::path base = fs::path(file).parent_path();
+    auto resolve = [&](const string &path) { return fs::path(path).is_absolute() ? fs::path(path) : base / path; };
+
+    vector<Job> jobs;
+    string line;
+    int number = 0;
+    while (getline(in, line))
+    {
+        ++number;
+        istringstream fields(line);
+        vector<string> tokens;
+        for (string token; fields >> token;)
+            tokens.push_back(token);
+        if (tokens.empty() || tokens[0][0] == '#')
+            continue;
+
+        if (tokens.size() == 1)
+        {
+            const fs::path mesh = resolve(tokens[0]);
+            jobs.push_back(makeJob(fs::path(mesh).concat(".node"), fs::path(mesh).concat(".ele"), {},
+                                   outputDirectory));
+        }
+        else if (tokens.size() <= 3)
+        {
+            jobs.push_back(makeJob(resolve(tokens[0]), resolve(tokens[1]),
+                                   tokens.size() == 3 ? resolve(tokens[2]) : fs::path(), outputDirectory));
+        }
+        else
+        {
+            throw runtime_error("Manifest " + file + ": too many fields on line " + to_string(number));
+        }
+    }
+    return jobs;
+}
+
+vector<BatchRunner::Job> BatchRunner::fromGlob(const string &pattern, const string &outputDirectory)
+{
+    const fs::path path(pattern);
+    const fs::path directory = path.has_parent_path() ? path.parent_path() : fs::path(".");
+    const string name = path.filename().string();
+    if (!fs::is_directory(directory))
+        throw FileNotFoundError("No such directory: " + directory.string());
+
+    // Meshes are named by their path without extension, sorted so runs are repeatable
+    set<fs::path> meshes;
+    for (const auto &entry : fs::directory_iterator(directory))
+    {
+        const fs::path file = entry.path();
+        const string extension = file.extension().string();
+        if ((extension == ".node" || extension == ".ele") && wildcardMatch(name, file.filename().string()))
+            meshes.insert(fs::path(file).replace_extension());
+    }
+
+    vector<Job> jobs;
+    for (const auto &mesh : meshes)
+    {
+        const fs::path node = fs::path(mesh).concat(".node"), ele = fs::path(mesh).concat(".ele");
+        if (fs::exists(node) && fs::exists(ele))
+            jobs.push_back(makeJob(node, ele, {}, outputDirectory));
+    }
+    if (jobs.empty())
+        throw FileNotFoundError("No meshes match " + pattern);
+    return jobs;
+}
+
+PolyMesh PipelineRunner::run()
+{
+    GPOLYLLA_TRACE_SCOPE("PipelineRunner");
+    report.input = eleFile;
+    report.output = outputFile;
+    report.threads = algorithm.context.threadCount();
+    stats.clear();
+
+    TetgenReader reader;
+    reader.nodeFile = nodeFile;
+    reader.eleFile = eleFile;
+    const Mesh mesh = report.measure("read", [&] { return reader.readMesh(); });
+    report.phase("read").tetras = mesh.tetras.size();
+    report.phase("read").bytes = fs::file_size(nodeFile) + fs::file_size(eleFile);
+
+    // A failed stage keeps draining its queue so the algorithm never waits on it. If the algorithm fails the
+    // writer drops its output.
+    BoundedQueue<Polyhedron> toWrite(1024), toStats(1024);
+    exception_ptr writeError, statsError;
+    atomic<bool> failed = false;
+
+    thread writing([&] {
+        VisFStreamWriter writer;
+        writer.outputFile = outputFile;
+        try
+        {
+            writer.begin(mesh.vertices);
+        }
+        catch (...)
+        {
+            writeError = current_exception();
+        }
+        while (auto poly = toWrite.pop())
+        {
+            if (writeError)
+                continue;
+            try
+            {
+                writer.write(*poly, mesh);
+            }
+            catch (...)
+            {
+                writeError = current_exception();
+            }
+        }
+        try
+        {
+            if (!writeError && !failed)
+                writer.end();
+        }
+        catch (...)
+        {
+            writeError = current_exception();
+        }
+        if (writeError || failed)
+            writer.abort();
+    });
+
+    thread computing;
+    if (makeStats)
+    {
+        // Polyhedra are taken in batches whose stats are split over the threads of the algorithm
+        computing = thread([&] {
+            ExecutionScope scope(algorithm.context);
+            vector<Polyhedron> batch;
+            auto flush = [&] {
+                if (!statsError)
+                {
+                    try
+                    {
+                        const size_t first = stats.size();
+                        stats.resize(first + batch.size());
+                        parallelFor(
+                            static_cast<int>(batch.size()),
+                            [&](int i) { stats[first + i] = computeStat(batch[i], mesh); }, 1);
+                    }
+                    catch (...)
+                    {
+                        statsError = current_exception();
+                    }
+                }
+                batch.clear();
+            };
+            while (auto poly = toStats.pop())
+            {
+                batch.push_back(std::move(*poly));
+                if (batch.size() == STATS_BATCH)
+                    flush();
+            }
+            flush();
+        });
+    }
+
+    algorithm.onPolyhedron = [&](const Polyhedron &poly) {
+        toWrite.push(poly);
+        if (makeStats)
+            toStats.push(poly);
+    };
+    PolyMesh result;
+    try
+    {
+        result = report.measure("cavities", [&] { return algorithm(mesh); });
+    }
+    catch (...)
+    {
+        failed = true;
+        toWrite.close();
+        toStats.close();
+        writing.join();
+        if (computing.joinable())
+            computing.join();
+        algorithm.onPolyhedron = nullptr;
+        throw;
+    }
+    algorithm.onPolyhedron = nullptr;
+    report.phase("cavities").tetras = mesh.tetras.size();
+
+    toWrite.close();
+    toStats.close();
+    report.measure("write", [&] { writing.join(); });
+    if (writeError)
+        rethrow_exception(writeError);
+    report.phase("write").bytes = fs::file_size(outputFile);
+
+    if (makeStats)
+    {
+        report.measure("stats", [&] { computing.join(); });
+        if (statsError)
+            rethrow_exception(statsError);
+        report.setMesh(mesh);
+        report.setResult(result);
+        report.setStats(stats);
+    }
+    return result;
+}
@@ -0,0 +1,97 @@
+#include "parallel.h"
+#include <gpolylla/bvh.h>
+
+#include <algorithm>
+#include <future>
+#include <numeric>
+
+using namespace Polylla;
+using namespace std;
+
+// Subtrees are built into their own node list, with the root first, so they can be built concurrently
+struct BvhBuilder
+{
+    const vector<Box3> &boxes;
+    const vector<Vector3> &centers;
+    vector<int> &items;
+    int leafSize;
+    int parallelDepth;
+
+    static constexpr int PARALLEL_SIZE = 1 << 14;
+
+    vector<Bvh::Node> build(int begin, int end, int depth) const
+    {
+        Bvh::Node node;
+        Box3 centerBounds;
+        for (int i = begin; i < end; ++i)
+        {
+            node.box.extend(boxes[items[i]]);
+            centerBounds.extend(centers[items[i]]);
+        }
+
+        if (end - begin <= leafSize)
+        {
+            node.begin = begin;
+            node.end = end;
+            return {node};
+        }
+
+        int axis;
+        centerBounds.sizes().maxCoeff(&axis);
+        const int mid = begin + (end - begin) / 2;
+        nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+                    [&](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+        vector<Bvh::Node> left, right;
+        if (depth < parallelDepth && end - begin > PARALLEL_SIZE)
+        {
+            auto pending = async(launch::async, [&] { return build(begin, mid, depth + 1); });
+            right = build(mid, end, depth + 1);
+            left = pending.get();
+        }
+        else
+        {
+            left = build(begin, mid, depth + 1);
+            right = build(mid, end, depth + 1);
+        }
+
+        vector<Bvh::Node> nodes;
+        nodes.reserve(1 + left.size() + right.size());
+        node.left = 1;
+        node.right = 1 + static_cast<int>(left.size());
+        nodes.push_back(node);
+        append(&nodes, left, node.left);
+        append(&nodes, right, node.right);
+        return nodes;
+    }
+
+    static void append(vector<Bvh::Node> *nodes, const vector<Bvh::Node> &subtree, int offset)
+    {
+        for (Bvh::Node node : subtree)
+        {
+            if (node.left != -1)
+            {
+                node.left += offset;
+                node.right += offset;
+            }
+            nodes->push_back(node);
+        }
+    }
+};
+
+Bvh::Bvh(const vector<Box3> &boxes, int leafSize)
+{
+    if (boxes.empty())
+        return;
+
+    vector<Vector3> centers(boxes.size());
+    parallelFor(static_cast<int>(boxes.size()), [&](int i) { centers[i] = boxes[i].center(); });
+    items_.resize(boxes.size());
+    iota(items_.begin(), items_.end(), 0);
+
+    int parallelDepth = 0;
+    while ((1 << parallelDepth) < threadCount())
+        parallelDepth++;
+    BvhBuilder builder{boxes, centers, items_, max(1, leafSize), parallelDepth};
+    nodes_ = builder.build(0, static_cast<int>(boxes.size()), 0);
+}
@@ -1,208 +1,200 @@
 #include "QuickHull.hpp"
+#include "cavity.h"
+#include "parallel.h"
+#include "predicates.h"
+#include "trace.h"
 #include "utils.h"
+#include <gpolylla/criteria.h>
 #include <algorithm>
-#include <set>
+#include <cmath>
+#include <limits>
 
 using namespace Polylla;
 using namespace std;
 
-CavityAlgorithm::Cavity circumsphere(int ti, const Mesh &mesh)
+CavityAlgorithm::Cavity Polylla::circumsphere(const Vertex &p0, const Vertex &p1, const Vertex &p2, const Vertex &p3)
 {
     using namespace Eigen;
-    Matrix4d A, X, Y, Z;
-    const Tetrahedron &tetra = mesh.tetras[ti];
-    const Vertex &p0 = mesh.vertices[tetra.vertices[0]];
-    const Vertex &p1 = mesh.vertices[tetra.vertices[1]];
-    const Vertex &p2 = mesh.vertices[tetra.vertices[2]];
-    const Vertex &p3 = mesh.vertices[tetra.vertices[3]];
-
-    A << p0.x(), p0.y(), p0.z(), 1, p1.x(), p1.y(), p1.z(), 1, p2.x(), p2.y(), p2.z(), 1, p3.x(), p3.y(), p3.z(), 1;
-
-    X << p0.squaredNorm(), p0.y(), p0.z(), 1, p1.squaredNorm(), p1.y(), p1.z(), 1, p2.squaredNorm(), p2.y(), p2.z(),
-        1, p3.squaredNorm(), p3.y(), p3.z(), 1;
+    // Relative to p0, so the terms stay on the scale of the tetrahedron
+    const Vector3d b = p1.cast<double>() - p0.cast<double>();
+    const Vector3d c = p2.cast<double>() - p0.cast<double>();
+    const Vector3d d = p3.cast<double>() - p0.cast<double>();
 
-    Y << p0.squaredNorm(), p0.x(), p0.z(), 1, p1.squaredNorm(), p1.x(), p1.z(), 1, p2.squaredNorm(), p2.x(), p2.z(),
-        1, p3.squaredNorm(), p3.x(), p3.z(), 1;
-
-    Z << p0.squaredNorm(), p0.x(), p0.y(), 1, p1.squaredNorm(), p1.x(), p1.y(), 1, p2.squaredNorm(), p2.x(), p2.y(),
-        1, p3.squaredNorm(), p3.x(), p3.y(), 1;
+    CavityAlgorithm::Cavity sphere;
+    sphere.tetra = -1;
+    // The sign of the volume is exact, flat tetrahedra have no circumsphere
+    const double volume = orient3d(p0, p1, p2, p3);
+    if (volume == 0.0)
+    {
+        sphere.center = p0.cast<double>();
+        sphere.radius = numeric_limits<double>::infinity();
+        return sphere;
+    }
 
-    double a = A.determinant();
-    double Dx = X.determinant();
-    double Dy = -Y.determinant();
-    double Dz = Z.determinant();
+    const Vector3d offset =
+        (b.squaredNorm() * c.cross(d) + c.squaredNorm() * d.cross(b) + d.squaredNorm() * b.cross(c)) / (2 * volume);
+    sphere.center = p0.cast<double>() + offset;
+    sphere.radius = offset.norm();
+    return sphere;
+}
 
-    CavityAlgorithm::Cavity sphere;
-    sphere.center = Vertex(Dx / (2 * a), Dy / (2 * a), Dz / (2 * a));
-    sphere.radius = (sphere.center - p0).norm();
+CavityAlgorithm::Cavity Polylla::circumsphere(int ti, const Mesh &mesh)
+{
+    const Tetrahedron &tetra = mesh.tetras[ti];
+    auto sphere = circumsphere(mesh.vertices[tetra.vertices[0]], mesh.vertices[tetra.vertices[1]],
+                               mesh.vertices[tetra.vertices[2]], mesh.vertices[tetra.vertices[3]]);
     sphere.tetra = ti;
     return sphere;
 }
 
-bool CavityAlgorithm::Cavity::isInside(const Vertex &point) const
+bool CavityAlgorithm::Cavity::isInside(const Eigen::Vector3d &point) const
 {
-    return (center - point).norm() < radius + TOLERANCE;
+    return std::isfinite(radius) && sphereSide(center, radius, point) <= 0;
 }
 
-struct CavityInfo
+namespace
 {
-    vector<CavityAlgorithm::Cavity> cavities;
-    vector<int> seeds;
-    vector<int> owners;
-};
-
-struct DepthFirstSearch
+// CavityCriterion over the circumspheres of a CavityInfo
+struct InfoCriterion
 {
-    const Mesh *mesh;
-    CavityInfo *info;
-
-    DepthFirstSearch(const Mesh *mesh, CavityInfo *info) : mesh(mesh), info(info)
-    {
-    }
+    const CavityInfo *info;
 
-    void operator()(const int currentTi, const int seed, set<int> *points, vector<int> *faces, vector<int> *tetras)
+    bool accepts(int seed, int ti) const
     {
-        info->owners[currentTi] = seed;
-        tetras->push_back(currentTi);
-
-        const Tetrahedron &currentTetra = mesh->tetras[currentTi];
-
-        for (int vi : currentTetra.vertices)
-        {
-            points->insert(vi);
-        }
-
-        for (const int fi : currentTetra.faces)
-        {
-            int nextTi = mesh->faces[fi].tetras[0];
-            if (nextTi == currentTi)
-                nextTi = mesh->faces[fi].tetras[1];
-
-            if (nextTi == -1)
-            {
-                faces->push_back(fi);
-                continue;
-            }
-
-            if (info->owners[nextTi] != -1)
-            {
-                // Ya fue asignado a un poly
-                if (info->owners[nextTi] != seed)
-                    faces->push_back(fi);
-                continue;
-            }
-
-            const auto &cavity = info->cavities[seed];
-            if (cavity.isInside(info->cavities[nextTi].center))
-                (*this)(nextTi, seed, points, faces, tetras);
-            else
-                faces->push_back(fi);
-        }
+        return info->cavities[seed].isInside(info->cavities[ti].center);
     }
 };
+} // namespace
 
-void labelCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info)
+void Polylla::labelCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info, const ExecutionContext &context)
 {
+    GPOLYLLA_TRACE_SCOPE("labelCavities");
     for (int ti = 0; ti < mesh.tetras.size(); ++ti)
     {
+        if (ti % 4096 == 0)
+            context.check();
         const auto &sphere = circumsphere(ti, mesh);
         info->cavities.push_back(sphere);
         info->seeds.push_back(ti);
     }
 
-    std::sort(info->seeds.begin(), info->seeds.end(),
-              [&](int i, int j) { return info->cavities[i].radius < info->cavities[j].radius; });
+    // Ties are broken by index so the order does not depend on the sort implementation
+    std::sort(info->seeds.begin(), info->seeds.end(), [&](int i, int j) {
+        const double ri = info->cavities[i].radius;
+        const double rj = info->cavities[j].radius;
+        return ri < rj || (ri == rj && i < j);
+    });
 
     info->owners = vector<int>(mesh.tetras.size(), -1);
 }
 
-void buildCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info)
+void Polylla::buildCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info,
+                            const function<void(const Polyhedron &)> &onPolyhedron, const ExecutionContext &context)
 {
-    DepthFirstSearch dfs(&mesh, info);
+    GPOLYLLA_TRACE_SCOPE("buildCavities");
+    InfoCriterion criterion{info};
 
     // Copy vertices from the original mesh
     result->vertices = mesh.vertices;
     result->faces = mesh.faces;
     result->tetras = mesh.tetras;
 
-    for (int ti : info->seeds)
+    // Work done by the searches, for the trace
+    [[maybe_unused]] size_t visited = 0, emitted = 0;
+    const int seedCount = static_cast<int>(info->seeds.size());
+    for (int si = 0; si < seedCount; ++si)
     {
+        // Every few thousand seeds, so reporting stays off the profile
+        if (si % 4096 == 0)
+            context.report(static_cast<double>(si) / seedCount);
+        const int ti = info->seeds[si];
         if (info->owners[ti] != -1)
             continue;
 
-        set<int> uniquePoints;
         vector<int> faces;
         vector<int> tetras;
-        dfs(ti, ti, &uniquePoints, &faces, &tetras);
+        growPolyhedron(mesh, criterion, ti, &info->owners, &tetras, &faces);
+        visited += tetras.size();
+        emitted += faces.size();
 
-        vector<int> points(uniquePoints.begin(), uniquePoints.end());
+        vector<int> points;
         for (int ti : tetras)
         {
+            const auto &vertices = mesh.tetras[ti].vertices;
+            points.insert(points.end(), vertices.begin(), vertices.end());
             result->tetras[ti].polyhedron = result->cells.size();
         }
+        ranges::sort(points);
+        points.erase(unique(points.begin(), points.end()), points.end());
         result->cells.emplace_back(points, faces, tetras);
+        if (onPolyhedron)
+            onPolyhedron(result->cells.back());
     }
+    GPOLYLLA_TRACE_COUNTER("tetras visited", visited);
+    GPOLYLLA_TRACE_COUNTER("faces emitted", emitted);
 };
 
-void fixCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info) {
-    // Add the loners to the best neighbour
-    for (const auto& p: result->cells)
-    {
-        if (p.cells.size() > 1) continue;
-
-        int ti = p.cells.at(0);
-        const auto& t = result->tetras.at(ti);
-        const auto& cavity = info->cavities.at(ti);
-
-        int best = -1;
-        float bestValue = numeric_limits<float>::max();
-
-        for (int fi : t.faces)
-        {
-            const auto& f = result->faces.at(fi);
-            int nextTi = f.tetras[0];
-            if (nextTi == ti)
-                nextTi = f.tetras[1];
-
-            if (nextTi == -1) continue;
-
-            // const auto& next = result->cells.at(nextTi);
-
-            const auto& nextCavity = info->cavities.at(nextTi);
-
-            float distance = (nextCavity.center - cavity.center).norm();
-            float value = distance / nextCavity.radius;
-
-            if (value < bestValue)
+void Polylla::fixCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info)
+{
+    GPOLYLLA_TRACE_SCOPE("fixCavities");
+    const int polyCount = static_cast<int>(result->cells.size());
+
+    // Neighbour of every loner with the nearest center relative to its radius, -1 for the other polyhedra
+    pmr::vector<int> targets(polyCount, -1, memoryResource());
+    parallelFor(
+        polyCount,
+        [&](int pi) {
+            const auto &poly = result->cells[pi];
+            if (poly.cells.size() != 1)
+                return;
+            const int ti = poly.cells[0];
+            const auto &cavity = info->cavities[ti];
+            Real bestValue = numeric_limits<Real>::max();
+            for (int fi : mesh.tetras[ti].faces)
             {
-                bestValue = value;
-                best = nextTi;
+                const Face &face = mesh.faces[fi];
+                const int nextTi = face.tetras[0] == ti ? face.tetras[1] : face.tetras[0];
+                if (nextTi == -1)
+                    continue;
+                const auto &nextCavity = info->cavities[nextTi];
+                const Real value = static_cast<Real>((nextCavity.center - cavity.center).norm() / nextCavity.radius);
+                if (value < bestValue)
+                {
+                    bestValue = value;
+                    targets[pi] = nextTi;
+                }
             }
-        }
-
-        if (best != -1)
+        },
+        256);
+
+    // Every tetrahedron joins the seed of its polyhedron, and every loner its target
+    UnionFind sets(static_cast<int>(mesh.tetras.size()));
+    parallelFor(static_cast<int>(mesh.tetras.size()), [&](int ti) {
+        sets.unite(ti, result->cells[result->tetras[ti].polyhedron].cells[0]);
+    });
+    parallelFor(polyCount, [&](int pi) {
+        if (targets[pi] != -1)
+            sets.unite(result->cells[pi].cells[0], targets[pi]);
+    });
+
+    // Merged polyhedra take the place of the first one among them
+    vector<int> order;
+    pmr::vector<char> seen(mesh.tetras.size(), 0, memoryResource());
+    for (const auto &poly : result->cells)
+    {
+        const int root = sets.find(poly.cells[0]);
+        if (!seen[root])
         {
-            int pi = result->tetras.at(best).polyhedron;
-            result->cells.at(pi).cells.push_back(ti);
-            result->tetras.at(ti).polyhedron = pi;
+            seen[root] = 1;
+            order.push_back(poly.cells[0]);
         }
     }
 
-    vector<Polyhedron> newPolys;
-    for (auto& t: result->tetras)
-    {
-        int idx = newPolys.size();
-        newPolys.push_back(result->cells.at(t.polyhedron));
-        t.polyhedron = idx;
-    }
-    result->cells = newPolys;
-    // For now, this function is a placeholder
-    // In a complete implementation, it would handle:
-    // - Boundary face identification
-    // - Cavity validation
-    // - Edge case handling
-    // - Quality checks
-};
+    PolyhedraCsr csr = assemblePolyhedra(mesh, sets, order);
+    parallelFor(static_cast<int>(mesh.tetras.size()), [&](int ti) { info->owners[ti] = order[csr.owners[ti]]; });
+    *result = csr.toPolyMesh(mesh);
+}
+
 //
 // CavityAlgorithm::Information getInfo(const CavityInfo &src, const PolyMesh &mesh)
 // {
@@ -234,18 +226,68 @@ void fixCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info) {
 
 PolyMesh CavityAlgorithm::operator()(const Mesh &mesh)
 {
+    GPOLYLLA_TRACE_SCOPE("CavityAlgorithm");
+    ExecutionScope scope(context);
     PolyMesh result;
     CavityInfo info;
-    labelCavities(mesh, &result, &info);
-    buildCavities(mesh, &result, &info);
-    // fixCavities(mesh, &result, &info);
+    context.phase("circumspheres");
+    labelCavities(mesh, &result, &info, context);
+    context.phase("cavities");
+    if (mergeLoners)
+    {
+        buildCavities(mesh, &result, &info, nullptr, context);
+        context.phase("loners");
+        fixCavities(mesh, &result, &info);
+        if (onPolyhedron)
+            ranges::for_each(result.cells, onPolyhedron);
+    }
+    else
+    {
+        buildCavities(mesh, &result, &info, onPolyhedron, context);
+    }
+    context.report(1);
     // if (withInfo)
     // {
     //     this->info = getInfo(info, result);
     // }
     // owners = info.owners;
+    polyhedra_.clear();
+    if (!mergeLoners)
+    {
+        polyhedra_.resize(result.cells.size());
+        parallelFor(
+            static_cast<int>(result.cells.size()),
+            [&](int pi) { polyhedra_[pi] = portablePolyhedron(result.cells[pi], mesh, info.owners); }, 256);
+    }
     cavities_ = info.cavities;
     seeds_ = info.seeds;
     owners_ = info.owners;
+    index_ = make_shared<LazyIndex>();
+    return result;
+}
+
+Polyhedron Polylla::portablePolyhedron(const Polyhedron &poly, const Mesh &mesh, const vector<int> &owners)
+{
+    Polyhedron result = poly;
+    const int seed = poly.cells.front();
+    for (int &fi : result.faces)
+    {
+        // The side of the face inside the polyhedron, the other one may be the boundary
+        const auto [a, b] = mesh.faces[fi].tetras;
+        const int ti = a != -1 && owners[a] == seed ? a : b;
+        const auto &faces = mesh.tetras[ti].faces;
+        fi = 4 * ti + static_cast<int>(ranges::find(faces, fi) - faces.begin());
+    }
     return result;
+}
+
+const CavityIndex &CavityAlgorithm::index() const
+{
+    if (!index_)
+    {
+        static const CavityIndex empty;
+        return empty;
+    }
+    call_once(index_->built, [&] { index_->index = CavityIndex(cavities_); });
+    return index_->index;
 }
\ No newline at end of file
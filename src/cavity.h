@@ -0,0 +1,44 @@
+#ifndef CAVITY_H
+#define CAVITY_H
+#include <functional>
+#include <gpolylla/polylla.h>
+#include <mutex>
+#include <vector>
+
+namespace Polylla
+{
+// Owner value used for tetrahedra that were already assigned outside the mesh being processed
+constexpr int FOREIGN_OWNER = -2;
+
+struct CavityInfo
+{
+    std::vector<CavityAlgorithm::Cavity> cavities;
+    std::vector<int> seeds;
+    std::vector<int> owners;
+};
+
+// Index of a run, built once by the first call of CavityAlgorithm::index()
+struct CavityAlgorithm::LazyIndex
+{
+    std::once_flag built;
+    CavityIndex index;
+};
+
+CavityAlgorithm::Cavity circumsphere(const Vertex &p0, const Vertex &p1, const Vertex &p2, const Vertex &p3);
+CavityAlgorithm::Cavity circumsphere(int ti, const Mesh &mesh);
+
+// Computes the circumspheres and the seed order (by radius, ties broken by index)
+void labelCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info, const ExecutionContext &context = {});
+// Grows one polyhedron per unassigned seed, onPolyhedron is called with each one as soon as it is done. Reports
+// the fraction of seeds done on the context.
+void buildCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info,
+                   const std::function<void(const Polyhedron &)> &onPolyhedron = nullptr,
+                   const ExecutionContext &context = {});
+// Merges every polyhedron of a single tetrahedron into the neighbour whose center is nearest relative to its
+// radius, owners are moved to the seed of the polyhedron they end in
+void fixCavities(const Mesh &mesh, PolyMesh *result, CavityInfo *info);
+// Copy of a polyhedron of owners with its faces as 4 * tetrahedron + position of the face in it
+Polyhedron portablePolyhedron(const Polyhedron &poly, const Mesh &mesh, const std::vector<int> &owners);
+} // namespace Polylla
+
+#endif // CAVITY_H
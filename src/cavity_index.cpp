@@ -0,0 +1,67 @@
+#include "parallel.h"
+#include "utils.h"
+#include <gpolylla/polylla.h>
+
+#include <cmath>
+#include <limits>
+
+using namespace Polylla;
+using namespace std;
+
+// Bounding box of the sphere rounded outwards, so every point accepted by isInside is inside it
+static Box3 sphereBox(const CavityAlgorithm::Cavity &cavity)
+{
+    // Flat tetrahedra have no sphere and contain nothing, but the center queries still find them at their center
+    const double reach = isfinite(cavity.radius) ? cavity.radius + TOLERANCE : 0.0;
+    Vector3 lo, hi;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        lo[axis] = nextafter(static_cast<Real>(cavity.center[axis] - reach), -numeric_limits<Real>::infinity());
+        hi[axis] = nextafter(static_cast<Real>(cavity.center[axis] + reach), numeric_limits<Real>::infinity());
+    }
+    return {lo, hi};
+}
+
+CavityIndex::CavityIndex(vector<CavityAlgorithm::Cavity> cavities) : cavities_(std::move(cavities))
+{
+    vector<Box3> boxes(cavities_.size());
+    parallelFor(static_cast<int>(cavities_.size()), [&](int i) { boxes[i] = sphereBox(cavities_[i]); });
+    bvh_ = Bvh(boxes);
+}
+
+vector<int> CavityIndex::containing(const Vertex &point) const
+{
+    vector<int> found;
+    bvh_.traverse([&](const Box3 &box) { return box.contains(point); },
+                  [&](int ci) {
+                      if (cavities_[ci].isInside(point))
+                          found.push_back(ci);
+                  });
+    return found;
+}
+
+vector<int> CavityIndex::withinRadius(const Vertex &point, Real radius) const
+{
+    vector<int> found;
+    const double squared = static_cast<double>(radius) * radius;
+    const Eigen::Vector3d p = point.cast<double>();
+    bvh_.traverse([&](const Box3 &box) { return box.squaredExteriorDistance(point) <= squared; },
+                  [&](int ci) {
+                      if ((cavities_[ci].center - p).squaredNorm() <= squared)
+                          found.push_back(ci);
+                  });
+    return found;
+}
+
+vector<int> CavityIndex::nearest(const Vertex &point, int k) const
+{
+    // Centers are inside their boxes, so the box distance is a lower bound
+    const Eigen::Vector3d p = point.cast<double>();
+    auto found =
+        bvh_.nearest(point, k, [&](int ci) { return static_cast<Real>((cavities_[ci].center - p).norm()); });
+    vector<int> result;
+    result.reserve(found.size());
+    for (auto [distance, ci] : found)
+        result.push_back(ci);
+    return result;
+}
@@ -0,0 +1,43 @@
+#include "cavity.h"
+#include "parallel.h"
+#include <gpolylla/criteria.h>
+#include <cmath>
+
+using namespace Polylla;
+using namespace std;
+
+void AreaCriterion::bind(const Mesh &mesh)
+{
+    this->mesh = &mesh;
+    pmr::vector<Real> areas(mesh.faces.size(), memoryResource());
+    parallelFor(static_cast<int>(mesh.faces.size()), [&](int fi) { areas[fi] = mesh.faces[fi].area(mesh); });
+
+    // A total order on the faces, so the joins never close a cycle of more than two tetrahedra
+    fittests_.assign(mesh.tetras.size(), -1);
+    parallelFor(static_cast<int>(mesh.tetras.size()), [&](int ti) {
+        int best = -1;
+        for (int fi : mesh.tetras[ti].faces)
+        {
+            if (best == -1 || areas[fi] > areas[best] || (areas[fi] == areas[best] && fi < best))
+                best = fi;
+        }
+        fittests_[ti] = best;
+    });
+}
+
+void VolumeRatioCriterion::bind(const Mesh &mesh)
+{
+    this->mesh = &mesh;
+    volumes.resize(mesh.tetras.size());
+    parallelFor(static_cast<int>(mesh.tetras.size()),
+                [&](int ti) { volumes[ti] = abs(mesh.tetras[ti].volume(mesh)); });
+}
+
+void CavityCriterion::bind(const Mesh &mesh)
+{
+    PolyMesh unused;
+    CavityInfo info;
+    labelCavities(mesh, &unused, &info);
+    cavities = std::move(info.cavities);
+    seeds_ = std::move(info.seeds);
+}
@@ -0,0 +1,580 @@
+#include "cavity.h"
+#include "logger.h"
+#include "parallel.h"
+#include "partition.h"
+#include "utils.h"
+#include <gpolylla/criteria.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <set>
+
+using namespace Polylla;
+using namespace std;
+
+// Circumspheres per rank used to size its ghost layer
+constexpr size_t RADIUS_SAMPLES = 1024;
+
+class MessageWriter
+{
+  public:
+    vector<char> data;
+
+    template <typename T> void put(const T &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T> void put(const vector<T> &values)
+    {
+        put<uint64_t>(values.size());
+        const char *bytes = reinterpret_cast<const char *>(values.data());
+        data.insert(data.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+};
+
+class MessageReader
+{
+  public:
+    explicit MessageReader(vector<char> data) : data(std::move(data))
+    {
+    }
+
+    template <typename T> T get()
+    {
+        T value;
+        read(&value, sizeof(T));
+        return value;
+    }
+
+    template <typename T> vector<T> getVector()
+    {
+        vector<T> values(get<uint64_t>());
+        read(values.data(), values.size() * sizeof(T));
+        return values;
+    }
+
+  private:
+    vector<char> data;
+    size_t offset = 0;
+
+    void read(void *target, size_t size)
+    {
+        if (offset + size > data.size())
+            throw runtime_error("Truncated message");
+        memcpy(target, data.data() + offset, size);
+        offset += size;
+    }
+};
+
+// Tetrahedra of one rank plus its ghost layer. Vertices are numbered within the domain.
+struct Domain
+{
+    vector<Vertex> vertices;
+    vector<RegionTetra> region;
+    Box3 safe;
+    bool whole = false;
+    string shardFile;
+
+    vector<char> encode() const
+    {
+        MessageWriter writer;
+        vector<array<Real, 3>> points;
+        points.reserve(vertices.size());
+        for (const auto &v : vertices)
+            points.push_back({v.x(), v.y(), v.z()});
+        writer.put(points);
+        writer.put(region);
+        writer.put(safe.min().x());
+        writer.put(safe.min().y());
+        writer.put(safe.min().z());
+        writer.put(safe.max().x());
+        writer.put(safe.max().y());
+        writer.put(safe.max().z());
+        writer.put(whole);
+        writer.put(vector<char>(shardFile.begin(), shardFile.end()));
+        return std::move(writer.data);
+    }
+
+    static Domain decode(const vector<char> &message)
+    {
+        MessageReader reader(message);
+        Domain domain;
+        for (auto [x, y, z] : reader.getVector<array<Real, 3>>())
+            domain.vertices.emplace_back(x, y, z);
+        domain.region = reader.getVector<RegionTetra>();
+        Vector3 lo, hi;
+        lo.x() = reader.get<Real>();
+        lo.y() = reader.get<Real>();
+        lo.z() = reader.get<Real>();
+        hi.x() = reader.get<Real>();
+        hi.y() = reader.get<Real>();
+        hi.z() = reader.get<Real>();
+        domain.safe = Box3(lo, hi);
+        domain.whole = reader.get<bool>();
+        auto shard = reader.getVector<char>();
+        domain.shardFile.assign(shard.begin(), shard.end());
+        return domain;
+    }
+};
+
+// Cavities of a domain, the accepted ones are kept to write the shard
+struct DomainSolution
+{
+    LocalMesh local;
+    PolyMesh result;
+    vector<int> accepted;
+
+    // Global tetrahedra of every accepted polyhedron, the seed first
+    vector<vector<int>> polyhedra() const
+    {
+        vector<vector<int>> polys;
+        for (int pi : accepted)
+        {
+            vector<int> tetras;
+            for (int ti : result.cells[pi].cells)
+                tetras.push_back(local.tetras[ti]);
+            polys.push_back(std::move(tetras));
+        }
+        return polys;
+    }
+
+    // Circumradius of the seed of every accepted polyhedron
+    vector<double> radii() const
+    {
+        vector<double> radii;
+        for (int pi : accepted)
+            radii.push_back(circumsphere(result.cells[pi].cells.front(), local.mesh).radius);
+        return radii;
+    }
+
+    void writeShard(const string &file, const vector<bool> &kept) const
+    {
+        PolyMesh shard;
+        shard.vertices = result.vertices;
+        shard.faces = result.faces;
+        shard.tetras = result.tetras;
+        for (int i = 0; i < accepted.size(); ++i)
+        {
+            if (kept[i])
+                shard.cells.push_back(result.cells[accepted[i]]);
+        }
+        VisFWriter writer;
+        writer.outputFile = file;
+        writer.writeMesh(shard);
+    }
+};
+
+// Grows the cavities of a domain, accepting those seeded in the core that stay inside the safe box
+DomainSolution solve(Domain domain)
+{
+    DomainSolution solution;
+    solution.local = buildLocalMesh(std::move(domain.region), domain.vertices);
+    solution.result = localCavities(solution.local, [](int) { return false; });
+    for (int pi = 0; pi < solution.result.cells.size(); ++pi)
+    {
+        const auto &poly = solution.result.cells[pi];
+        if (!solution.local.core[poly.cells.front()])
+            continue;
+        bool bounded = domain.whole || ranges::all_of(poly.cells, [&](int ti) {
+                           return isBounded(solution.local, ti, domain.safe);
+                       });
+        if (bounded)
+            solution.accepted.push_back(pi);
+    }
+    return solution;
+}
+
+// Seed circumradius and global tetrahedra of every polyhedron a rank contributes. The radii are computed on the
+// domain, with the same coordinates and vertex order as in the whole mesh, so they order the polyhedra exactly as
+// CavityAlgorithm.
+struct Contribution
+{
+    vector<vector<int>> polyhedra;
+    vector<double> radii;
+
+    vector<char> encode() const
+    {
+        MessageWriter writer;
+        writer.put<uint64_t>(polyhedra.size());
+        for (const auto &tetras : polyhedra)
+            writer.put(tetras);
+        writer.put(radii);
+        return std::move(writer.data);
+    }
+
+    static Contribution decode(const vector<char> &message)
+    {
+        MessageReader reader(message);
+        Contribution contribution;
+        contribution.polyhedra.resize(reader.get<uint64_t>());
+        for (auto &tetras : contribution.polyhedra)
+            tetras = reader.getVector<int>();
+        contribution.radii = reader.getVector<double>();
+        return contribution;
+    }
+};
+
+// Cavity criterion over the leftover tetrahedra only, which are the only ones growPolyhedron tests once the
+// accepted polyhedra are owned
+class LeftoverCriterion
+{
+  public:
+    LeftoverCriterion(vector<int> tetras, const Mesh &mesh) : tetras(std::move(tetras))
+    {
+        cavities.resize(this->tetras.size());
+        parallelFor(static_cast<int>(this->tetras.size()),
+                    [&](int i) { cavities[i] = circumsphere(this->tetras[i], mesh); });
+        seeds_ = this->tetras;
+        ranges::sort(seeds_, [&](int i, int j) {
+            const double ri = cavity(i).radius;
+            const double rj = cavity(j).radius;
+            return ri < rj || (ri == rj && i < j);
+        });
+    }
+
+    const vector<int> &seeds() const
+    {
+        return seeds_;
+    }
+    bool accepts(int seed, int ti) const
+    {
+        return cavity(seed).isInside(cavity(ti).center);
+    }
+    const CavityAlgorithm::Cavity &cavity(int ti) const
+    {
+        return cavities[ranges::lower_bound(tetras, ti) - tetras.begin()];
+    }
+
+  private:
+    vector<int> tetras; // sorted
+    vector<CavityAlgorithm::Cavity> cavities;
+    vector<int> seeds_;
+};
+
+// Faces and vertices of a polyhedron given by its tetrahedra
+Polyhedron assemble(const vector<int> &tetras, const Mesh &mesh, const vector<int> &owners, int owner)
+{
+    set<int> points;
+    vector<int> faces;
+    for (int ti : tetras)
+    {
+        const Tetrahedron &t = mesh.tetras[ti];
+        points.insert(t.vertices.begin(), t.vertices.end());
+        for (int fi : t.faces)
+        {
+            int nextTi = mesh.faces[fi].tetras[0];
+            if (nextTi == ti)
+                nextTi = mesh.faces[fi].tetras[1];
+            if (nextTi == -1 || owners[nextTi] != owner)
+                faces.push_back(fi);
+        }
+    }
+    return {vector<int>(points.begin(), points.end()), faces, tetras};
+}
+
+string shardName(const string &prefix, int rank)
+{
+    return prefix + "_" + to_string(rank) + ".visf";
+}
+
+PolyMesh DistributedCavityAlgorithm::operator()(const Mesh &mesh)
+{
+    const int ranks = transport ? transport->size() : 1;
+    if (transport && transport->rank() != 0)
+        throw runtime_error("DistributedCavityAlgorithm must be called on rank 0, other ranks call serve()");
+
+    ExecutionScope scope(context);
+    context.phase("partition");
+    const int tetraCount = static_cast<int>(mesh.tetras.size());
+
+    // Morton order of the centroids splits the mesh in compact ranges
+    Box3 bounds;
+    for (const auto &v : mesh.vertices)
+        bounds.extend(v);
+    const Vector3 size = bounds.sizes().cwiseMax(TOLERANCE);
+    // Arrays over every tetrahedron that do not outlive the call come from the memory resource of the run
+    pmr::vector<Vector3> centroids(tetraCount, memoryResource());
+    pmr::vector<pair<uint64_t, int>> codes(tetraCount, memoryResource());
+    Real maxExtent = 0;
+    for (int ti = 0; ti < tetraCount; ++ti)
+    {
+        const auto &vertices = mesh.tetras[ti].vertices;
+        centroids[ti] = centroid(vertices, mesh.vertices);
+        maxExtent = std::max(maxExtent, Polylla::extent(vertices, mesh.vertices));
+        Vector3 cell = (centroids[ti] - bounds.min()).cwiseQuotient(size) * Real(1023);
+        codes[ti] = {mortonCode(static_cast<uint32_t>(cell.x()), static_cast<uint32_t>(cell.y()),
+                                static_cast<uint32_t>(cell.z())),
+                     ti};
+    }
+    ranges::sort(codes);
+
+    pmr::vector<int> rankOf(tetraCount, memoryResource());
+    for (size_t i = 0; i < codes.size(); ++i)
+        rankOf[codes[i].second] = static_cast<int>(i * ranks / codes.size());
+    codes.clear();
+
+    vector<Domain> domains(ranks);
+    vector<vector<int>> cores(ranks);
+    vector<Box3> boxes(ranks);
+    for (int ti = 0; ti < tetraCount; ++ti)
+    {
+        cores[rankOf[ti]].push_back(ti);
+        for (int vi : mesh.tetras[ti].vertices)
+            boxes[rankOf[ti]].extend(mesh.vertices[vi]);
+    }
+
+    // A few slivers have huge circumspheres, so the halo follows the bulk of the radii, estimated on an even
+    // sample of every range. The ranks compute the circumspheres of their own region. Cavities that still reach
+    // the edge of the ghost layer are not accepted and end up in the leftovers.
+    vector<Real> radius(ranks, 0);
+    for (int r = 0; r < ranks; ++r)
+    {
+        if (cores[r].empty())
+            continue;
+        const size_t step = std::max<size_t>(1, cores[r].size() / RADIUS_SAMPLES);
+        vector<double> radii;
+        for (size_t i = 0; i < cores[r].size(); i += step)
+            radii.push_back(circumsphere(cores[r][i], mesh).radius);
+        auto quantile = radii.begin() + radii.size() * 9 / 10;
+        ranges::nth_element(radii, quantile);
+        radius[r] = static_cast<Real>(*quantile);
+    }
+
+    vector<Box3> expanded(ranks);
+    for (int r = 0; r < ranks; ++r)
+    {
+        if (boxes[r].isEmpty())
+            continue;
+        Real halo = haloFactor * std::min(radius[r], boxes[r].diagonal().norm());
+        expanded[r] = Box3(boxes[r].min().array() - halo, boxes[r].max().array() + halo);
+        // Every tetrahedron sharing a face with one inside the safe box has its centroid in the expanded box
+        domains[r].safe = Box3(expanded[r].min().array() + maxExtent, expanded[r].max().array() - maxExtent);
+        domains[r].whole = expanded[r].contains(bounds);
+        if (!shardPrefix.empty())
+            domains[r].shardFile = shardName(shardPrefix, r);
+    }
+
+    // Ghost layers grow from the faces between ranks over the tetrahedra whose centroid is inside the expanded
+    // box, so only the layers are visited. A neighbour of a region tetrahedron inside the safe box has its
+    // centroid there, so it is reached.
+    vector<vector<int>> frontiers(ranks);
+    for (const Face &face : mesh.faces)
+    {
+        auto [a, b] = face.tetras;
+        if (a == -1 || b == -1 || rankOf[a] == rankOf[b])
+            continue;
+        frontiers[rankOf[a]].push_back(b);
+        frontiers[rankOf[b]].push_back(a);
+    }
+
+    // Shared by the domains, built one after the other: the last rank that reached every tetrahedron, and the
+    // domain index of every vertex, reset once a domain is done
+    pmr::vector<int> reached(tetraCount, -1, memoryResource());
+    pmr::vector<int> lookup(mesh.vertices.size(), -1, memoryResource());
+    for (int r = 0; r < ranks; ++r)
+    {
+        Domain &domain = domains[r];
+        vector<int> used;
+        auto add = [&](int ti, bool core) {
+            RegionTetra t{ti, {}, core};
+            for (int i = 0; i < 4; ++i)
+            {
+                int vi = mesh.tetras[ti].vertices[i];
+                if (lookup[vi] == -1)
+                {
+                    lookup[vi] = static_cast<int>(domain.vertices.size());
+                    domain.vertices.push_back(mesh.vertices[vi]);
+                    used.push_back(vi);
+                }
+                t.vertices[i] = lookup[vi];
+            }
+            domain.region.push_back(t);
+        };
+
+        for (int ti : cores[r])
+            add(ti, true);
+        vector<int> stack;
+        auto visit = [&](int ti) {
+            if (ti == -1 || rankOf[ti] == r || reached[ti] == r || !expanded[r].contains(centroids[ti]))
+                return;
+            reached[ti] = r;
+            stack.push_back(ti);
+        };
+        for (int ti : frontiers[r])
+            visit(ti);
+        while (!stack.empty())
+        {
+            const int ti = stack.back();
+            stack.pop_back();
+            add(ti, false);
+            for (int fi : mesh.tetras[ti].faces)
+            {
+                const Face &face = mesh.faces[fi];
+                visit(face.tetras[0] == ti ? face.tetras[1] : face.tetras[0]);
+            }
+        }
+        for (int vi : used)
+            lookup[vi] = -1;
+    }
+    frontiers.clear();
+    cores.clear();
+
+    // The last check, once the domains are sent the other ranks wait for the merge
+    context.phase("domains");
+    for (int r = 1; r < ranks; ++r)
+    {
+        transport->send(r, domains[r].encode());
+        domains[r] = Domain();
+    }
+    DomainSolution own = solve(std::move(domains[0]));
+
+    // Merge: a tetrahedron claimed by two ranks drops both polyhedra back to the leftovers
+    vector<Contribution> contributed(ranks);
+    contributed[0] = {own.polyhedra(), own.radii()};
+    for (int r = 1; r < ranks; ++r)
+        contributed[r] = Contribution::decode(transport->receive(r));
+
+    pmr::vector<int> claims(tetraCount, 0, memoryResource());
+    for (const auto &contribution : contributed)
+    {
+        for (const auto &tetras : contribution.polyhedra)
+        {
+            for (int ti : tetras)
+                claims[ti]++;
+        }
+    }
+
+    vector<int> owners(tetraCount, -1);
+    vector<vector<bool>> kept(ranks);
+    for (int r = 0; r < ranks; ++r)
+    {
+        for (const auto &tetras : contributed[r].polyhedra)
+        {
+            bool unique = ranges::all_of(tetras, [&](int ti) { return claims[ti] == 1; });
+            kept[r].push_back(unique);
+            if (!unique)
+                continue;
+            for (int ti : tetras)
+                owners[ti] = tetras.front();
+        }
+    }
+    claims.clear();
+
+    // Accepted polyhedra are held fixed while the leftovers grow in the same seed order, which only needs the
+    // circumspheres of the leftovers. They do not compete with the accepted ones, which is where the result may
+    // depart from CavityAlgorithm.. A leftover seed that would have claimed part of an accepted polyhedron in
+    // the sequential order cannot, this is where the result departs from CavityAlgorithm.
+    pmr::vector<int> seedOf(owners.begin(), owners.end(), memoryResource());
+    vector<int> rest;
+    for (int ti = 0; ti < tetraCount; ++ti)
+    {
+        if (owners[ti] == -1)
+            rest.push_back(ti);
+        else
+            owners[ti] = FOREIGN_OWNER;
+    }
+    if (!rest.empty())
+        log("Distributed cavities: " + to_string(rest.size()) + " leftover tetrahedra");
+    LeftoverCriterion criterion(std::move(rest), mesh);
+    vector<vector<int>> regrown;
+    for (int seed : criterion.seeds())
+    {
+        if (owners[seed] != -1)
+            continue;
+        vector<int> tetras, faces;
+        growPolyhedron(mesh, criterion, seed, &owners, &tetras, &faces);
+        regrown.push_back(std::move(tetras));
+    }
+    for (int ti = 0; ti < tetraCount; ++ti)
+    {
+        if (seedOf[ti] != -1)
+            owners[ti] = seedOf[ti];
+    }
+    seedOf.clear();
+
+    // Same order of polyhedra as CavityAlgorithm, by the radius of their seed. Origin is the contributing rank,
+    // -1 for the leftovers.
+    vector<vector<int>> polys;
+    vector<double> radii;
+    vector<int> origin;
+    for (int r = 0; r < ranks; ++r)
+    {
+        for (int i = 0; i < contributed[r].polyhedra.size(); ++i)
+        {
+            if (!kept[r][i])
+                continue;
+            polys.push_back(std::move(contributed[r].polyhedra[i]));
+            radii.push_back(contributed[r].radii[i]);
+            origin.push_back(r);
+        }
+    }
+    for (auto &tetras : regrown)
+    {
+        radii.push_back(criterion.cavity(tetras.front()).radius);
+        polys.push_back(std::move(tetras));
+        origin.push_back(-1);
+    }
+
+    vector<int> order(polys.size());
+    iota(order.begin(), order.end(), 0);
+    ranges::sort(order, [&](int a, int b) {
+        return radii[a] < radii[b] || (radii[a] == radii[b] && polys[a].front() < polys[b].front());
+    });
+
+    PolyMesh result;
+    result.vertices = mesh.vertices;
+    result.faces = mesh.faces;
+    result.tetras = mesh.tetras;
+    for (int pi : order)
+    {
+        for (int ti : polys[pi])
+            result.tetras[ti].polyhedron = static_cast<int>(result.cells.size());
+        result.cells.push_back(assemble(polys[pi], mesh, owners, owners[polys[pi].front()]));
+    }
+
+    if (!shardPrefix.empty())
+    {
+        for (int r = 1; r < ranks; ++r)
+        {
+            MessageWriter writer;
+            writer.put(vector<char>(kept[r].begin(), kept[r].end()));
+            transport->send(r, writer.data);
+        }
+
+        // Rank 0 also writes the leftovers, with the vertices of the whole mesh
+        PolyMesh shard;
+        shard.vertices = mesh.vertices;
+        shard.faces = mesh.faces;
+        shard.tetras = result.tetras;
+        for (int i = 0; i < order.size(); ++i)
+        {
+            if (origin[order[i]] <= 0)
+                shard.cells.push_back(result.cells[i]);
+        }
+        VisFWriter writer;
+        writer.outputFile = shardName(shardPrefix, 0);
+        writer.writeMesh(shard);
+    }
+    return result;
+}
+
+void DistributedCavityAlgorithm::serve()
+{
+    if (!transport || transport->rank() == 0)
+        throw runtime_error("DistributedCavityAlgorithm::serve must be called on a worker rank");
+
+    Domain domain = Domain::decode(transport->receive(0));
+    const string shardFile = domain.shardFile;
+    DomainSolution solution = solve(std::move(domain));
+    transport->send(0, Contribution{solution.polyhedra(), solution.radii()}.encode());
+
+    if (!shardFile.empty())
+    {
+        MessageReader reader(transport->receive(0));
+        auto flags = reader.getVector<char>();
+        solution.writeShard(shardFile, vector<bool>(flags.begin(), flags.end()));
+    }
+}
@@ -0,0 +1,145 @@
+// Replaces the global allocation functions of the executable so the trace counts every allocation. Only built with
+// GPOLYLLA_COUNT_ALLOCATIONS, the library itself never replaces them.
+#include <gpolylla/trace.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+void *allocate(std::size_t size)
+{
+    Polylla::countAllocation();
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *allocate(std::size_t size, std::align_val_t alignment)
+{
+    Polylla::countAllocation();
+    const auto align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+    return _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+    // aligned_alloc wants a multiple of the alignment
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+}
+
+void release(void *p) noexcept
+{
+    std::free(p);
+}
+
+void releaseAligned(void *p) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    if (void *p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void *p = allocate(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return ::operator new(size, alignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate(size, alignment);
+}
+
+void operator delete(void *p) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    release(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+    release(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    releaseAligned(p);
+}
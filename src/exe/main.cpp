@@ -1,10 +1,17 @@
 //
 // Created by vigb9 on 01-06-2025.
 //
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <gpolylla/batch.h>
 #include <gpolylla/polylla.h>
+#include <gpolylla/report.h>
+#include <gpolylla/snapshot.h>
 #include <gpolylla/stat.h>
+#include <gpolylla/trace.h>
 #include <iostream>
+#include <memory>
 #include <polyhedron_kernel.h>
 #include <string>
 #include <vector>
@@ -12,121 +19,6 @@
 using namespace Polylla;
 
 
-struct Times
-{
-    float execution;
-    float read;
-    float write;
-};
-
-
-void createStats(const std::string& file, const std::vector<PolyStat>& stats, const Times& times, const PolyMesh& polyMesh, const Mesh& mesh)
-{
-
-    std::vector<bool> points(mesh.vertices.size());
-    for (const auto& poly : polyMesh.cells)
-    {
-        for (const int vi : poly.vertices)
-        {
-            points[vi] = true;
-        }
-    }
-
-    float conversionRatio = static_cast<float>(std::ranges::count(points, true)) / static_cast<float>(points.size());
-    float totalTime = times.execution + times.read + times.write;
-    float avgVolumeRatio = .0f;
-    float minVolumeRatio = std::numeric_limits<float>::max();
-    int idxMinVolumeRatio = -1;
-    float maxVolumeRatio = std::numeric_limits<float>::min();
-    int idxMaxVolumeRatio = -1;
-    float avgSurfaceRatio = .0f;
-    float minSurfaceRatio = std::numeric_limits<float>::max();
-    int idxMinSurfaceRatio = -1;
-    float maxSurfaceRatio = std::numeric_limits<float>::min();
-    int idxMaxSurfaceRatio = -1;
-    float avgEdgeRatio = .0f;
-    float minEdgeRatio = std::numeric_limits<float>::max();
-    int idxMinEdgeRatio = -1;
-    float maxEdgeRatio = std::numeric_limits<float>::min();
-    int idxMaxEdgeRatio = -1;
-
-    int i = 0;
-    for (const auto& stat : stats)
-    {
-        avgVolumeRatio += stat.volumeRatio;
-        if (stat.volumeRatio < minVolumeRatio)
-        {
-            minVolumeRatio = stat.volumeRatio;
-            idxMinVolumeRatio = i;
-        }
-        if (stat.volumeRatio > maxVolumeRatio)
-        {
-            maxVolumeRatio = stat.volumeRatio;
-            idxMaxVolumeRatio = i;
-        }
-
-        avgSurfaceRatio += stat.surfaceRatio;
-        if (stat.surfaceRatio < minSurfaceRatio)
-        {
-            minSurfaceRatio = stat.surfaceRatio;
-            idxMinSurfaceRatio = i;
-        }
-        if (stat.surfaceRatio > maxSurfaceRatio)
-        {
-            maxSurfaceRatio = stat.surfaceRatio;
-            idxMaxSurfaceRatio = i;
-        }
-
-        avgEdgeRatio += stat.edgeRatio;
-        if (stat.edgeRatio < minEdgeRatio)
-        {
-            minEdgeRatio = stat.edgeRatio;
-            idxMinEdgeRatio = i;
-        }
-        if (stat.edgeRatio > maxEdgeRatio)
-        {
-            maxEdgeRatio = stat.edgeRatio;
-            idxMaxEdgeRatio = i;
-        }
-
-        i++;
-    }
-
-    avgVolumeRatio /= stats.size();
-    avgSurfaceRatio /= stats.size();
-    avgEdgeRatio /= stats.size();
-
-
-    std::ofstream csv(file);
-
-    if (!csv.is_open())
-    {
-        throw std::runtime_error("Unable to create file: " + file);
-    }
-
-    csv << "tetras,cells,points coverage,";
-    csv << "execution time,read time,write time,total time,";
-    csv << "volume ratio (min),volume ratio (max),volume ratio (avg),";
-    csv << "idx volume ratio (min),idx volume ratio (max),";
-    csv << "surface ratio (min),surface ratio (max),surface ratio (avg),";
-    csv << "idx surface ratio (min),idx surface ratio (max),";
-    csv << "edge ratio (min),edge ratio (max),edge ratio (avg),";
-    csv << "idx edge ratio (min),idx edge ratio (max)";
-    csv << std::endl;
-
-    csv << mesh.tetras.size() << "," << polyMesh.cells.size() << "," << conversionRatio << ",";
-    csv << times.execution << "," << times.read << "," << times.write << "," << totalTime << ",";
-    csv << minVolumeRatio << "," << maxVolumeRatio << "," << avgVolumeRatio << ",";
-    csv << idxMinVolumeRatio << "," << idxMaxVolumeRatio << ",";
-    csv << minSurfaceRatio << "," << maxSurfaceRatio << "," << avgSurfaceRatio;
-    csv << idxMinSurfaceRatio << "," << idxMaxSurfaceRatio << ",";
-    csv << minSurfaceRatio << "," << maxSurfaceRatio << "," << avgEdgeRatio;
-    csv << idxMinEdgeRatio << "," << idxMaxEdgeRatio;
-    csv << std::endl;
-
-    csv.close();
-}
-
 void createOFF(const std::string& file, const Polyhedron& poly, const PolyMesh& mesh)
 {
     std::ofstream off(file);
@@ -223,7 +115,10 @@ void displayHelp()
 
 void displayUsage(const char *prog_name)
 {
-    std::cerr << "Usage: " << prog_name << " -n <node_file> -e <ele_file> -o <output_file>" << std::endl;
+    std::cerr << "Usage: " << prog_name << " -n <node_file> -e <ele_file> -o <output_file> [--stream [block_size]] [--ranks <n>] [--algorithm cavity|face] [--merge-loners] [--trace <file>] [--snapshot <png|ppm>]"
+              << std::endl;
+    std::cerr << "       " << prog_name << " --batch <manifest|glob> -o <output_dir> [--make-stats] [--algorithm cavity|face] [--merge-loners] [--trace <file>]"
+              << std::endl;
 }
 
 int main(int argc, char *argv[])
@@ -233,6 +128,14 @@ int main(int argc, char *argv[])
     std::string outputFile;
     bool makeStats = false;
     bool detailStats = false;
+    bool streaming = false;
+    int blockSize = StreamingCavityAlgorithm().blockSize;
+    int ranks = 1;
+    std::string algorithmName = "cavity";
+    bool mergeLoners = false;
+    std::string batch;
+    std::string traceFile;
+    std::string snapshotFile;
 
     for (int i = 1; i < argc; ++i)
     {
@@ -289,49 +192,245 @@ int main(int argc, char *argv[])
             continue;
         }
 
+        if (arg == "--stream")
+        {
+            streaming = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+            {
+                blockSize = std::stoi(argv[++i]);
+            }
+            continue;
+        }
+
+        if (arg == "--ranks")
+        {
+            if (i + 1 < argc)
+            {
+                ranks = std::max(1, std::stoi(argv[++i]));
+                continue;
+            }
+            std::cerr << "--ranks option requires one argument." << std::endl;
+            displayUsage(argv[0]);
+            return 1;
+        }
+
+        if (arg == "--algorithm")
+        {
+            if (i + 1 < argc && (std::string(argv[i + 1]) == "cavity" || std::string(argv[i + 1]) == "face"))
+            {
+                algorithmName = argv[++i];
+                continue;
+            }
+            std::cerr << "--algorithm option requires cavity or face." << std::endl;
+            displayUsage(argv[0]);
+            return 1;
+        }
+
+        if (arg == "--batch")
+        {
+            if (i + 1 < argc)
+            {
+                batch = argv[++i];
+                continue;
+            }
+            std::cerr << "--batch option requires one argument." << std::endl;
+            displayUsage(argv[0]);
+            return 1;
+        }
+
+        if (arg == "--merge-loners")
+        {
+            mergeLoners = true;
+            continue;
+        }
+
+        if (arg == "--trace")
+        {
+            if (i + 1 < argc)
+            {
+                traceFile = argv[++i];
+                continue;
+            }
+            std::cerr << "--trace option requires one argument." << std::endl;
+            displayUsage(argv[0]);
+            return 1;
+        }
+
+        if (arg == "--snapshot")
+        {
+            if (i + 1 < argc)
+            {
+                snapshotFile = argv[++i];
+                continue;
+            }
+            std::cerr << "--snapshot option requires one argument." << std::endl;
+            displayUsage(argv[0]);
+            return 1;
+        }
+
         std::cerr << "Unknown option: " << arg << std::endl;
         displayUsage(argv[0]);
         return 1;
     }
 
+    if (!batch.empty())
+    {
+        if (outputFile.empty() || !nodeFile.empty() || !eleFile.empty() || streaming || ranks > 1 || !snapshotFile.empty())
+        {
+            std::cerr << "--batch takes its meshes from the manifest or glob, the output is a directory and it cannot be used with --stream, --ranks or --snapshot." << std::endl;
+            displayUsage(argv[0]);
+            return 1;
+        }
+
+        CavityAlgorithm cavity;
+        cavity.mergeLoners = mergeLoners;
+        FaceAlgorithm face;
+        BatchRunner runner;
+        runner.algorithm = algorithmName == "face" ? static_cast<Algorithm *>(&face) : &cavity;
+        runner.makeStats = makeStats;
+        bool isGlob = batch.find_first_of("*?") != std::string::npos;
+        runner.jobs = isGlob ? BatchRunner::fromGlob(batch, outputFile) : BatchRunner::fromManifest(batch, outputFile);
+        runner.onDone = [&](const BatchRunner::Result &r) {
+            if (r.error.empty())
+                std::cout << "Created file: " << r.job.outputFile << std::endl;
+            else
+                std::cerr << "Failed " << r.job.eleFile << ": " << r.error << std::endl;
+        };
+
+        std::filesystem::create_directories(outputFile);
+        int failed = 0;
+        for (const auto &r : runner.run())
+            failed += !r.error.empty();
+        std::string report = (std::filesystem::path(outputFile) / "batch.json").string();
+        runner.writeReport(report);
+        if (!traceFile.empty())
+            writeTrace(traceFile);
+        std::cout << "Done " << runner.jobs.size() - failed << " of " << runner.jobs.size() << " meshes, report: " << report << std::endl;
+        return failed == 0 ? 0 : 1;
+    }
+
     if (nodeFile.empty() || eleFile.empty() || outputFile.empty())
     {
         displayUsage(argv[0]);
         return 1;
     }
 
-    Times times;
-
-
-    TetgenReader reader;
-    reader.nodeFile = nodeFile;
-    reader.eleFile = eleFile;
-    auto t0 = std::chrono::high_resolution_clock::now();
-    Mesh mesh = reader.readMesh();
-    auto t1 = std::chrono::high_resolution_clock::now();
-    times.read = std::chrono::duration<float, std::milli>(t1 - t0).count();
+    if (algorithmName != "cavity" && (streaming || ranks > 1))
+    {
+        std::cerr << "--stream and --ranks only run the cavity algorithm." << std::endl;
+        return 1;
+    }
+    if (mergeLoners && streaming)
+    {
+        std::cerr << "--merge-loners cannot be used with --stream, polyhedra are written as soon as a block is done." << std::endl;
+        return 1;
+    }
+    if (mergeLoners && ranks > 1)
+    {
+        std::cerr << "--merge-loners cannot be used with --ranks, the ranks only build the cavities." << std::endl;
+        return 1;
+    }
 
+    if (!traceFile.empty() && !tracingEnabled())
+    {
+        std::cerr << "--trace needs a build with GPOLYLLA_TRACE, no spans will be recorded." << std::endl;
+    }
 
+    if (streaming)
+    {
+        if (makeStats)
+        {
+            std::cerr << "--make-stats needs the whole mesh in memory and cannot be used with --stream." << std::endl;
+            return 1;
+        }
+        if (!snapshotFile.empty())
+        {
+            std::cerr << "--snapshot needs the whole mesh in memory and cannot be used with --stream." << std::endl;
+            return 1;
+        }
 
-    t0 = std::chrono::high_resolution_clock::now();
-    PolyMesh polyMesh = CavityAlgorithm()(mesh);
-    t1 = std::chrono::high_resolution_clock::now();
-    times.execution = std::chrono::duration<float, std::milli>(t1 - t0).count();
+        StreamingCavityAlgorithm algorithm;
+        algorithm.nodeFile = nodeFile;
+        algorithm.eleFile = eleFile;
+        algorithm.outputFile = outputFile;
+        algorithm.blockSize = blockSize;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        algorithm();
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::cout << "Done in " << std::chrono::duration<float, std::milli>(t1 - t0).count() << " ms" << std::endl;
+        std::cout << "Created file: " << outputFile << std::endl;
+        if (!traceFile.empty())
+            writeTrace(traceFile);
+        return 0;
+    }
 
+    // Workers are forked before reading, they receive their part of the mesh from rank 0
+    std::unique_ptr<SocketTransport> transport;
+    DistributedCavityAlgorithm distributed;
+    if (ranks > 1)
+    {
+        transport = SocketTransport::spawn(ranks);
+        distributed.transport = transport.get();
+        if (transport->rank() != 0)
+        {
+            distributed.serve();
+            return 0;
+        }
+    }
 
-    VisFWriter writer;
-    writer.outputFile = outputFile;
-    t0 = std::chrono::high_resolution_clock::now();
-    writer.writeMesh(polyMesh);
-    t1 = std::chrono::high_resolution_clock::now();
-    times.write = std::chrono::duration<float, std::milli>(t1 - t0).count();
+    RunReport report;
+    PolyMesh polyMesh;
+    std::vector<PolyStat> stats;
+    if (ranks == 1 && algorithmName == "cavity")
+    {
+        // Reading, growing, writing and stats overlap
+        PipelineRunner pipeline;
+        pipeline.nodeFile = nodeFile;
+        pipeline.eleFile = eleFile;
+        pipeline.outputFile = outputFile;
+        pipeline.makeStats = makeStats;
+        pipeline.algorithm.mergeLoners = mergeLoners;
+        polyMesh = pipeline.run();
+        report = pipeline.report;
+        stats = std::move(pipeline.stats);
+    }
+    else
+    {
+        report.input = eleFile;
+        report.output = outputFile;
+        FaceAlgorithm face;
+        Algorithm *algorithm = ranks > 1 ? static_cast<Algorithm *>(&distributed) : &face;
+        report.threads = algorithm->context.threadCount();
+
+        TetgenReader reader;
+        reader.nodeFile = nodeFile;
+        reader.eleFile = eleFile;
+        Mesh mesh = report.measure("read", [&] { return reader.readMesh(); });
+        report.phase("read").tetras = mesh.tetras.size();
+        report.phase("read").bytes = std::filesystem::file_size(nodeFile) + std::filesystem::file_size(eleFile);
+
+        polyMesh = report.measure("cavities", [&] { return (*algorithm)(mesh); });
+        report.phase("cavities").tetras = mesh.tetras.size();
+
+        VisFWriter writer;
+        writer.outputFile = outputFile;
+        report.measure("write", [&] { writer.writeMesh(polyMesh); });
+        report.phase("write").bytes = std::filesystem::file_size(outputFile);
+
+        if (makeStats)
+        {
+            stats = report.measure("stats", [&] { return computeStats(polyMesh); });
+            report.phase("stats").tetras = mesh.tetras.size();
+            report.setMesh(mesh);
+            report.setResult(polyMesh);
+            report.setStats(stats);
+        }
+    }
 
     if (makeStats)
     {
-        std::vector<PolyStat> stats = computeStats(polyMesh);
         std::string basename = outputFile.substr(0, outputFile.find_last_of('.'));
-        std::string statsFile = basename + ".csv";
-        createStats(statsFile, stats, times, polyMesh, mesh);
+        report.write(basename + ".json");
 
         if (detailStats)
         {
@@ -341,6 +440,14 @@ int main(int argc, char *argv[])
 
     }
 
+    if (!snapshotFile.empty())
+    {
+        Snapshot snapshot;
+        snapshot.camera = Camera::framing(polyMesh);
+        snapshot(polyMesh).write(snapshotFile);
+        std::cout << "Created snapshot: " << snapshotFile << std::endl;
+    }
+
     // auto stats = computeStats(polyMesh);
     // PolyhedronKernel k;
     // std::vector<cinolib::vec3d> kVertices;
@@ -405,7 +512,10 @@ int main(int argc, char *argv[])
     // k.compute(kMesh.vector_verts(), kMesh.vector_polys(), kMesh.vector_poly_normals());
 
 
-    std::cout << "Done in " << times.execution << " ms" << std::endl;
-    std::cout << "Created file: " << writer.outputFile << std::endl;
+    if (!traceFile.empty())
+        writeTrace(traceFile);
+
+    std::cout << "Done in " << report.phase("cavities").wallMs << " ms" << std::endl;
+    std::cout << "Created file: " << outputFile << std::endl;
     return 0;
 }
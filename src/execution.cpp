@@ -0,0 +1,68 @@
+#include "parallel.h"
+#include <gpolylla/execution.h>
+
+using namespace Polylla;
+using namespace std;
+
+namespace
+{
+thread_local int currentThreads = 0;
+thread_local pmr::memory_resource *currentMemory = nullptr;
+} // namespace
+
+void ExecutionContext::check() const
+{
+    if (cancelled())
+        throw CancelledError(progress ? "Cancelled during " + progress->currentPhase() : "Cancelled");
+}
+
+void ExecutionContext::phase(const string &name) const
+{
+    if (progress)
+        progress->phase(name);
+    check();
+}
+
+void ExecutionContext::report(double fraction) const
+{
+    if (progress)
+        progress->report(fraction);
+    check();
+}
+
+int ExecutionContext::threadCount() const
+{
+    ExecutionScope scope(*this);
+    return Polylla::threadCount();
+}
+
+ExecutionScope::ExecutionScope(const ExecutionContext &context) : threads(currentThreads), memory(currentMemory)
+{
+    // A scope inside another only narrows the thread limit
+    if (context.threads > 0)
+        currentThreads = currentThreads > 0 ? min(currentThreads, context.threads) : context.threads;
+    if (context.memory)
+        currentMemory = context.memory;
+}
+
+ExecutionScope::~ExecutionScope()
+{
+    currentThreads = threads;
+    currentMemory = memory;
+}
+
+int Polylla::threadLimit()
+{
+    return currentThreads;
+}
+
+pmr::memory_resource *Polylla::memoryResource()
+{
+    return currentMemory ? currentMemory : pmr::get_default_resource();
+}
+
+void Polylla::inheritExecution(int threads, pmr::memory_resource *memory)
+{
+    currentThreads = threads;
+    currentMemory = memory;
+}
@@ -0,0 +1,46 @@
+#include "parallel.h"
+#include "trace.h"
+#include <gpolylla/criteria.h>
+
+using namespace Polylla;
+using namespace std;
+
+PolyMesh FaceAlgorithm::operator()(const Mesh &mesh)
+{
+    GPOLYLLA_TRACE_SCOPE("FaceAlgorithm");
+    ExecutionScope scope(context);
+    const int tetraCount = static_cast<int>(mesh.tetras.size());
+    const int faceCount = static_cast<int>(mesh.faces.size());
+
+    context.phase("fittest faces");
+    AreaCriterion criterion;
+    criterion.bind(mesh);
+    fittests_ = criterion.fittests();
+    UnionFind sets(tetraCount);
+    uniteFaces(mesh, sets, criterion);
+
+    vector<char> terminal(faceCount, 0);
+    parallelFor(faceCount, [&](int fi) {
+        const Face &face = mesh.faces[fi];
+        bool isTerminal = face.tetras[0] != -1 || face.tetras[1] != -1;
+        for (int ti : face.tetras)
+            isTerminal = isTerminal && (ti == -1 || fittests_[ti] == fi);
+        terminal[fi] = isTerminal;
+    });
+    seeds_.clear();
+    vector<int> order;
+    for (int fi = 0; fi < faceCount; ++fi)
+    {
+        if (!terminal[fi])
+            continue;
+        const Face &face = mesh.faces[fi];
+        seeds_.push_back(fi);
+        order.push_back(face.tetras[0] != -1 ? face.tetras[0] : face.tetras[1]);
+    }
+
+    // Every set holds exactly one terminal face, its polyhedron is numbered after it
+    context.phase("polyhedra");
+    PolyMesh result = assemblePolyhedra(mesh, sets, order).toPolyMesh(mesh);
+    context.report(1);
+    return result;
+}
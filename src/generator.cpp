@@ -0,0 +1,215 @@
+#include "io.h"
+#include "parallel.h"
+#include <gpolylla/generator.h>
+
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+using namespace Polylla;
+using namespace std;
+
+namespace
+{
+// Corners of a cell are numbered by their offsets, bit 0 along x, bit 1 along y and bit 2 along z
+constexpr int KUHN_PATHS[6][3] = {{1, 2, 4}, {1, 4, 2}, {2, 1, 4}, {2, 4, 1}, {4, 1, 2}, {4, 2, 1}};
+
+uint64_t splitMix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Uniform in [-1, 1), only depends on the seed and the key so vertices can be generated in any order
+double uniform(uint64_t seed, uint64_t key)
+{
+    return static_cast<double>(splitMix(splitMix(seed) ^ key) >> 11) * 0x1.0p-52 - 1.0;
+}
+
+int cornerOffset(int corner, int axis)
+{
+    return (corner >> axis) & 1;
+}
+
+// Swaps two corners if the tetrahedron is negative on the unit cell, every cell is a scaled unit cell
+array<int, 4> oriented(array<int, 4> corners)
+{
+    int e[3][3];
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+            e[r][axis] = cornerOffset(corners[r + 1], axis) - cornerOffset(corners[0], axis);
+    }
+    int det = e[0][0] * (e[1][1] * e[2][2] - e[1][2] * e[2][1]) - e[0][1] * (e[1][0] * e[2][2] - e[1][2] * e[2][0]) +
+              e[0][2] * (e[1][0] * e[2][1] - e[1][1] * e[2][0]);
+    if (det < 0)
+        swap(corners[2], corners[3]);
+    return corners;
+}
+} // namespace
+
+void LatticeGenerator::resize(size_t tetras)
+{
+    const double perCell = static_cast<double>(tetras) / tetrasPerCell();
+    const int n = max(1, static_cast<int>(ceil(cbrt(perCell) - 1e-9)));
+    cells = {n, n, n};
+}
+
+size_t LatticeGenerator::vertexCount() const
+{
+    return static_cast<size_t>(cells[0] + 1) * (cells[1] + 1) * (cells[2] + 1);
+}
+
+size_t LatticeGenerator::tetraCount() const
+{
+    return static_cast<size_t>(cells[0]) * cells[1] * cells[2] * tetrasPerCell();
+}
+
+int LatticeGenerator::tetrasPerCell() const
+{
+    return split == Split::Five ? 5 : 6;
+}
+
+Real LatticeGenerator::coordinate(int axis, int index) const
+{
+    const int n = cells[axis];
+    const double t = static_cast<double>(index) / n;
+    if (grading == 1 || n == 1)
+        return static_cast<Real>(size[axis] * t);
+    // Consecutive spacings grow by a constant factor, the last one is grading times the first
+    const double a = log(static_cast<double>(grading)) * n / (n - 1);
+    return static_cast<Real>(size[axis] * expm1(a * t) / expm1(a));
+}
+
+Vertex LatticeGenerator::vertex(int i, int j, int k) const
+{
+    const int index[3] = {i, j, k};
+    const uint64_t key = (static_cast<uint64_t>(k) * (cells[1] + 1) + j) * (cells[0] + 1) + i;
+    Vertex v;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const int c = index[axis];
+        Real x = coordinate(axis, c);
+        // Vertices on the boundary stay on the faces of the box
+        if (c > 0 && c < cells[axis] && jitter > 0)
+        {
+            Real spacing = min(x - coordinate(axis, c - 1), coordinate(axis, c + 1) - x);
+            x += static_cast<Real>(jitter * spacing * uniform(seed, key * 3 + axis));
+        }
+        v[axis] = x;
+    }
+    return v;
+}
+
+void LatticeGenerator::cellTetras(int i, int j, int k, array<array<int, 4>, 6> *tetras) const
+{
+    auto vertexIndex = [&](int corner) {
+        return ((k + cornerOffset(corner, 2)) * (cells[1] + 1) + j + cornerOffset(corner, 1)) * (cells[0] + 1) + i +
+               cornerOffset(corner, 0);
+    };
+    auto emit = [&](int t, array<int, 4> corners) {
+        corners = oriented(corners);
+        for (int c = 0; c < 4; ++c)
+            (*tetras)[t][c] = vertexIndex(corners[c]);
+    };
+
+    if (split == Split::Six)
+    {
+        for (int t = 0; t < 6; ++t)
+        {
+            const auto &path = KUHN_PATHS[t];
+            emit(t, {0, path[0], path[0] | path[1], 7});
+        }
+        return;
+    }
+
+    // The central tetrahedron joins the corners of even global parity, so neighbouring cells cut their shared
+    // face along the same diagonal
+    const int parity = (i + j + k) & 1;
+    array<int, 4> central;
+    int t = 0, c = 0;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        if (((popcount(static_cast<unsigned>(corner)) + parity) & 1) == 0)
+            central[c++] = corner;
+        else
+            emit(t++, {corner, corner ^ 1, corner ^ 2, corner ^ 4});
+    }
+    emit(t, central);
+}
+
+Mesh LatticeGenerator::readMesh()
+{
+    if (cells[0] < 1 || cells[1] < 1 || cells[2] < 1)
+        throw invalid_argument("Lattice needs at least one cell per axis");
+    if (tetraCount() > static_cast<size_t>(numeric_limits<int>::max()))
+        throw invalid_argument("Lattice has more tetrahedra than can be indexed");
+
+    Mesh mesh;
+    const int sx = cells[0] + 1, sy = cells[1] + 1;
+    mesh.vertices.resize(vertexCount());
+    parallelFor(static_cast<int>(vertexCount()), [&](int vi) {
+        mesh.vertices[vi] = vertex(vi % sx, (vi / sx) % sy, vi / (sx * sy));
+    });
+
+    const int perCell = tetrasPerCell();
+    const int cellCount = cells[0] * cells[1] * cells[2];
+    mesh.tetras.resize(tetraCount());
+    parallelFor(cellCount, [&](int ci) {
+        array<array<int, 4>, 6> tetras;
+        cellTetras(ci % cells[0], (ci / cells[0]) % cells[1], ci / (cells[0] * cells[1]), &tetras);
+        for (int t = 0; t < perCell; ++t)
+            mesh.tetras[static_cast<size_t>(ci) * perCell + t] = Tetrahedron(tetras[t]);
+    });
+
+    mesh.faces = buildFaces(mesh.vertices, mesh.tetras);
+    buildConnectivity(&mesh);
+    return mesh;
+}
+
+void LatticeGenerator::writeTetgen(const string &nodeFile, const string &eleFile) const
+{
+    ofstream node(nodeFile);
+    if (!node.is_open())
+        throw runtime_error("Unable to create file: " + nodeFile);
+    node.precision(numeric_limits<Real>::max_digits10);
+    node << vertexCount() << " 3 0 0\n";
+    size_t vi = 0;
+    for (int k = 0; k <= cells[2]; ++k)
+    {
+        for (int j = 0; j <= cells[1]; ++j)
+        {
+            for (int i = 0; i <= cells[0]; ++i)
+            {
+                const Vertex v = vertex(i, j, k);
+                node << vi++ << " " << v.x() << " " << v.y() << " " << v.z() << "\n";
+            }
+        }
+    }
+
+    ofstream ele(eleFile);
+    if (!ele.is_open())
+        throw runtime_error("Unable to create file: " + eleFile);
+    ele << tetraCount() << " 4 0\n";
+    size_t ti = 0;
+    array<array<int, 4>, 6> tetras;
+    for (int k = 0; k < cells[2]; ++k)
+    {
+        for (int j = 0; j < cells[1]; ++j)
+        {
+            for (int i = 0; i < cells[0]; ++i)
+            {
+                cellTetras(i, j, k, &tetras);
+                for (int t = 0; t < tetrasPerCell(); ++t)
+                {
+                    const auto &v = tetras[t];
+                    ele << ti++ << " " << v[0] << " " << v[1] << " " << v[2] << " " << v[3] << "\n";
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,389 @@
+#include "cavity.h"
+#include "logger.h"
+#include "parallel.h"
+#include "trace.h"
+#include <gpolylla/criteria.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace Polylla;
+using namespace std;
+
+namespace
+{
+int neighbour(int ti, int fi, const Mesh &mesh)
+{
+    const Face &f = mesh.faces[fi];
+    return f.tetras[0] == ti ? f.tetras[1] : f.tetras[0];
+}
+
+bool before(const vector<CavityAlgorithm::Cavity> &cavities, int i, int j)
+{
+    const double ri = cavities[i].radius;
+    const double rj = cavities[j].radius;
+    return ri < rj || (ri == rj && i < j);
+}
+
+// Same order as labelCavities, merging the sorted unchanged tetrahedra with the new ones. Tetrahedra whose tie
+// with another one is broken differently under the new indices are appended to reordered.
+vector<int> seedOrder(const vector<CavityAlgorithm::Cavity> &cavities, const vector<int> &oldSeeds,
+                      const pmr::vector<int> &oldToNew, const vector<int> &previous, vector<int> *reordered)
+{
+    vector<int> kept;
+    kept.reserve(oldSeeds.size());
+    for (int s : oldSeeds)
+    {
+        if (oldToNew[s] != -1)
+            kept.push_back(oldToNew[s]);
+    }
+    for (size_t begin = 0; begin < kept.size();)
+    {
+        size_t end = begin + 1;
+        while (end < kept.size() && cavities[kept[end]].radius == cavities[kept[begin]].radius)
+            ++end;
+        auto run = span(kept).subspan(begin, end - begin);
+        if (!ranges::is_sorted(run))
+        {
+            ranges::sort(run);
+            reordered->insert(reordered->end(), run.begin(), run.end());
+        }
+        begin = end;
+    }
+
+    vector<int> added;
+    for (int ti = 0; ti < previous.size(); ++ti)
+    {
+        if (previous[ti] == -1)
+            added.push_back(ti);
+    }
+    ranges::sort(added, [&](int i, int j) { return before(cavities, i, j); });
+
+    vector<int> seeds(kept.size() + added.size());
+    ranges::merge(kept, added, seeds.begin(), [&](int i, int j) { return before(cavities, i, j); });
+    return seeds;
+}
+
+// Gives back to every seed the tetrahedra it owns, for growPolyhedron
+struct OwnerCriterion
+{
+    const vector<int> *owners;
+
+    bool accepts(int seed, int ti) const
+    {
+        return (*owners)[ti] == seed;
+    }
+};
+
+// Replays the seeds in order, growing again only the polyhedra that may differ from the last run. A polyhedron
+// keeps its shape while its tetrahedra and their neighbours are unchanged, no earlier seed claims one of them and
+// every neighbour inside its sphere stays owned by an earlier polyhedron. Only the polyhedra reached from the edit
+// are visited.
+class Replay
+{
+  public:
+    // split holds the tetrahedra left of every polyhedron that lost some, they may no longer be connected
+    Replay(const Mesh &mesh, const CavityInfo &info, unordered_map<int, vector<int>> split,
+           const ExecutionContext &context)
+        : owners(info.owners), mesh(mesh), info(info), context(context), marks(owners.size(), -1),
+          known(std::move(split))
+    {
+    }
+
+    void release(int ti)
+    {
+        release(ti, -1);
+    }
+
+    void invalidate(int seed)
+    {
+        if (invalid.insert(seed).second)
+            push(seed);
+    }
+
+    void push(int ti)
+    {
+        queue.emplace(info.cavities[ti].radius, ti);
+    }
+
+    // Returns the amount of polyhedra grown again, owners holds the result
+    int run()
+    {
+        int grown = 0;
+        for (int popped = 0; !queue.empty(); ++popped)
+        {
+            if (popped % 4096 == 0)
+                context.check();
+            const int seed = queue.top().second;
+            queue.pop();
+            int owner = owners[seed];
+            if (owner != -1 && owner != seed && before(info.cavities, owner, seed))
+            {
+                // Claimed by an earlier polyhedron, whatever is left of its own is free again
+                if (invalid.erase(seed))
+                {
+                    for (int ti : members(seed))
+                    {
+                        if (owners[ti] == seed)
+                            release(ti, seed);
+                    }
+                }
+                continue;
+            }
+            if (owner == seed && !invalid.contains(seed))
+                continue;
+            grow(seed);
+            ++grown;
+        }
+        return grown;
+    }
+
+    // Whether the polyhedron of seed was looked at, the others kept their tetrahedra
+    bool touched(int seed) const
+    {
+        return known.contains(seed) || invalid.contains(seed);
+    }
+
+    vector<int> owners;
+
+  private:
+    const Mesh &mesh;
+    const CavityInfo &info;
+    const ExecutionContext &context;
+    unordered_set<int> invalid;
+    vector<int> marks;
+    // Members of the polyhedra already looked at, in the last run or grown again
+    unordered_map<int, vector<int>> known;
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> queue;
+
+    // Tetrahedra of the polyhedron of seed in the last run, found from the seed unless it lost some
+    const vector<int> &members(int seed)
+    {
+        auto [it, inserted] = known.try_emplace(seed);
+        if (inserted)
+        {
+            vector<int> faces;
+            growPolyhedron(mesh, OwnerCriterion{&info.owners}, seed, &marks, &it->second, &faces);
+            for (int ti : it->second)
+                marks[ti] = -1;
+        }
+        return it->second;
+    }
+
+    // A later polyhedron next to a free tetrahedron inside its sphere would claim it. current is the seed being
+    // replayed, -1 before any.
+    void release(int ti, int current)
+    {
+        owners[ti] = -1;
+        push(ti);
+        const Eigen::Vector3d &center = info.cavities[ti].center;
+        for (int fi : mesh.tetras[ti].faces)
+        {
+            int next = neighbour(ti, fi, mesh);
+            if (next == -1)
+                continue;
+            int owner = owners[next];
+            if (owner != -1 && (current == -1 || before(info.cavities, current, owner)) &&
+                info.cavities[owner].isInside(center))
+                invalidate(owner);
+        }
+    }
+
+    void claim(int ti, int seed)
+    {
+        int owner = owners[ti];
+        if (owner != -1 && owner != seed)
+            invalidate(owner);
+        owners[ti] = seed;
+        marks[ti] = seed;
+    }
+
+    void grow(int seed)
+    {
+        const vector<int> last = members(seed);
+        vector<int> tetras;
+        vector<int> stack;
+        claim(seed, seed);
+        stack.push_back(seed);
+        while (!stack.empty())
+        {
+            int ti = stack.back();
+            stack.pop_back();
+            tetras.push_back(ti);
+            for (int fi : mesh.tetras[ti].faces)
+            {
+                int next = neighbour(ti, fi, mesh);
+                if (next == -1 || marks[next] == seed)
+                    continue;
+                // Tetrahedra of later polyhedra are free when this seed is reached
+                int owner = owners[next];
+                if (owner != -1 && owner != seed && before(info.cavities, owner, seed))
+                    continue;
+                if (!info.cavities[seed].isInside(info.cavities[next].center))
+                    continue;
+                claim(next, seed);
+                stack.push_back(next);
+            }
+        }
+
+        for (int ti : last)
+        {
+            if (owners[ti] == seed && marks[ti] != seed)
+                release(ti, seed);
+        }
+        for (int ti : tetras)
+            marks[ti] = -1;
+        known[seed] = std::move(tetras);
+        invalid.erase(seed);
+    }
+};
+} // namespace
+
+PolyMesh CavityAlgorithm::update(const Mesh &mesh, const std::vector<int> &previous)
+{
+    GPOLYLLA_TRACE_SCOPE("CavityAlgorithm::update");
+    if (previous.size() != mesh.tetras.size())
+        throw runtime_error("Incremental cavities: expected one previous index per tetrahedron");
+    // Merged loners make the replay depend on polyhedra far from the edit
+    if (owners_.empty() || mergeLoners)
+        return (*this)(mesh);
+
+    ExecutionScope scope(context);
+    context.phase("circumspheres");
+    pmr::vector<int> oldToNew(owners_.size(), -1, memoryResource());
+    for (int ti = 0; ti < previous.size(); ++ti)
+    {
+        if (previous[ti] == -1)
+            continue;
+        if (previous[ti] < 0 || previous[ti] >= owners_.size() || oldToNew[previous[ti]] != -1)
+            throw runtime_error("Incremental cavities: invalid previous index " + to_string(previous[ti]));
+        oldToNew[previous[ti]] = ti;
+    }
+
+    // Polyhedra that lost a tetrahedron
+    unordered_map<int, vector<int>> split;
+    for (int ti = 0; ti < owners_.size(); ++ti)
+    {
+        if (oldToNew[ti] == -1 && oldToNew[owners_[ti]] != -1)
+            split.try_emplace(oldToNew[owners_[ti]]);
+    }
+
+    CavityInfo info;
+    info.cavities.resize(mesh.tetras.size());
+    info.owners.assign(mesh.tetras.size(), -1);
+    for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+    {
+        if (ti % 4096 == 0)
+            context.check();
+        if (previous[ti] == -1)
+        {
+            info.cavities[ti] = circumsphere(ti, mesh);
+            continue;
+        }
+        info.cavities[ti] = cavities_[previous[ti]];
+        info.cavities[ti].tetra = ti;
+        info.owners[ti] = oldToNew[owners_[previous[ti]]];
+        if (auto it = split.find(info.owners[ti]); it != split.end())
+            it->second.push_back(ti);
+    }
+    vector<int> reordered;
+    info.seeds = seedOrder(info.cavities, seeds_, oldToNew, previous, &reordered);
+
+    context.phase("cavities");
+    vector<int> lost;
+    for (const auto &entry : split)
+        lost.push_back(entry.first);
+    Replay replay(mesh, info, std::move(split), context);
+    for (int seed : lost)
+        replay.invalidate(seed);
+    for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+    {
+        // New tetrahedra and those whose seed is gone
+        if (info.owners[ti] == -1)
+            replay.release(ti);
+    }
+    for (int ti : reordered)
+    {
+        if (info.owners[ti] == ti)
+            replay.invalidate(ti);
+        replay.push(ti);
+    }
+    int grown = replay.run();
+    GPOLYLLA_TRACE_COUNTER("polyhedra grown", grown);
+    info.owners = std::move(replay.owners);
+
+    // The polyhedra are taken back from the owners in the order and with the faces of buildCavities. Those the
+    // replay did not touch have the same tetrahedra, reached in the same order, so they are copied from the last
+    // run with their indices mapped.
+    pmr::vector<int> last(owners_.size(), -1, memoryResource());
+    for (int pi = 0; pi < polyhedra_.size(); ++pi)
+        last[polyhedra_[pi].cells.front()] = pi;
+
+    PolyMesh result;
+    result.vertices = mesh.vertices;
+    result.faces = mesh.faces;
+    result.tetras = mesh.tetras;
+    const OwnerCriterion criterion{&info.owners};
+    vector<int> taken(mesh.tetras.size(), -1);
+    vector<Polyhedron> polyhedra;
+    int copied = 0;
+    const int seedCount = static_cast<int>(info.seeds.size());
+    for (int si = 0; si < seedCount; ++si)
+    {
+        if (si % 4096 == 0)
+            context.report(static_cast<double>(si) / seedCount);
+        const int ti = info.seeds[si];
+        if (info.owners[ti] != ti)
+            continue;
+
+        const int pi = previous[ti] == -1 || replay.touched(ti) ? -1 : last[previous[ti]];
+        Polyhedron poly;
+        if (pi != -1)
+        {
+            Polyhedron &kept = polyhedra_[pi];
+            for (int &tj : kept.cells)
+                tj = oldToNew[tj];
+            for (int &fi : kept.faces)
+                fi = 4 * oldToNew[fi / 4] + fi % 4;
+            poly = kept;
+            for (int &fi : poly.faces)
+                fi = mesh.tetras[fi / 4].faces[fi % 4];
+            polyhedra.push_back(std::move(kept));
+            ++copied;
+        }
+        else
+        {
+            growPolyhedron(mesh, criterion, ti, &taken, &poly.cells, &poly.faces);
+            for (int tj : poly.cells)
+            {
+                const auto &vertices = mesh.tetras[tj].vertices;
+                poly.vertices.insert(poly.vertices.end(), vertices.begin(), vertices.end());
+            }
+            ranges::sort(poly.vertices);
+            poly.vertices.erase(unique(poly.vertices.begin(), poly.vertices.end()), poly.vertices.end());
+            polyhedra.push_back(portablePolyhedron(poly, mesh, info.owners));
+        }
+
+        for (int tj : poly.cells)
+            result.tetras[tj].polyhedron = result.cells.size();
+        result.cells.push_back(std::move(poly));
+        if (onPolyhedron)
+            onPolyhedron(result.cells.back());
+    }
+    context.report(1);
+    GPOLYLLA_TRACE_COUNTER("polyhedra copied", copied);
+    log("Incremental cavities: " + to_string(grown) + " of " + to_string(result.cells.size()) +
+        " polyhedra grown again, " + to_string(copied) + " copied");
+
+    polyhedra_ = std::move(polyhedra);
+    cavities_ = std::move(info.cavities);
+    seeds_ = std::move(info.seeds);
+    owners_ = std::move(info.owners);
+    index_ = make_shared<LazyIndex>();
+    return result;
+}
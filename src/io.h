@@ -0,0 +1,28 @@
+#ifndef IO_H
+#define IO_H
+#include <gpolylla/polylla.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Polylla
+{
+class FileNotFoundError : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+std::vector<Vertex> buildVertices(const std::string &file);
+std::vector<Tetrahedron> buildCells(const std::string &file);
+std::vector<Face> buildFaces(const std::vector<Vertex> &vertices, const std::vector<Tetrahedron> &tetrahedrons);
+void buildConnectivity(Mesh *mesh);
+
+// Boundary faces of a polyhedron, oriented as the VisF writer expects them: the normal (v1 - v0) x (v2 - v0)
+// points into the polyhedron
+std::vector<std::array<int, 3>> directedFaces(const Polyhedron &poly, const Mesh &mesh);
+
+// JSON string of a path or name, quotes, backslashes and control characters are escaped
+std::string jsonString(const std::string &text);
+} // namespace Polylla
+
+#endif // IO_H
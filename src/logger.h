@@ -3,7 +3,7 @@
 #include <string>
 
 namespace Polylla {
-using LogLevel = enum { INFO };
+enum LogLevel { INFO };
 
 void log(const std::string& message, LogLevel level = INFO);
 }  // namespace Polylla
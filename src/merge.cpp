@@ -0,0 +1,141 @@
+#include "parallel.h"
+#include "trace.h"
+#include <gpolylla/merge.h>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace Polylla;
+using namespace std;
+
+namespace
+{
+constexpr int CHUNK_SIZE = 4096;
+
+int neighbour(const Mesh &mesh, int ti, int fi)
+{
+    const Face &face = mesh.faces[fi];
+    return face.tetras[0] == ti ? face.tetras[1] : face.tetras[0];
+}
+
+// Concatenates the rows into one array, rows are moved out
+void compress(vector<vector<int>> *rows, vector<int> *offsets, vector<int> *values)
+{
+    offsets->assign(rows->size() + 1, 0);
+    for (int i = 0; i < rows->size(); ++i)
+        (*offsets)[i + 1] = (*offsets)[i] + static_cast<int>((*rows)[i].size());
+    values->resize(offsets->back());
+    parallelFor(
+        static_cast<int>(rows->size()),
+        [&](int i) {
+            ranges::copy((*rows)[i], values->begin() + (*offsets)[i]);
+            vector<int>().swap((*rows)[i]);
+        },
+        256);
+}
+} // namespace
+
+void Polylla::parallelChunks(int n, void (*chunk)(void *, int, int), void *context)
+{
+    const int chunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    parallelFor(
+        chunks, [&](int c) { chunk(context, c * CHUNK_SIZE, min(n, (c + 1) * CHUNK_SIZE)); }, 1);
+}
+
+PolyhedraCsr Polylla::assemblePolyhedra(const Mesh &mesh, UnionFind &sets, const vector<int> &order)
+{
+    GPOLYLLA_TRACE_SCOPE("assemblePolyhedra");
+    const int tetraCount = static_cast<int>(mesh.tetras.size());
+    if (sets.size() != tetraCount)
+        throw invalid_argument("Sets do not match the tetrahedra of the mesh");
+
+    // Scratch arrays come from the memory resource of the run
+    pmr::vector<int> roots(tetraCount, memoryResource());
+    parallelFor(tetraCount, [&](int ti) { roots[ti] = sets.find(ti); });
+
+    // Roots are the smallest tetrahedron of their set
+    pmr::vector<int> labels(tetraCount, -1, memoryResource());
+    int polyCount = 0;
+    if (order.empty())
+    {
+        for (int ti = 0; ti < tetraCount; ++ti)
+        {
+            if (roots[ti] == ti)
+                labels[ti] = polyCount++;
+        }
+    }
+    else
+    {
+        for (int ti : order)
+        {
+            if (ti < 0 || ti >= tetraCount || labels[roots[ti]] != -1)
+                throw invalid_argument("Order must name every set once");
+            labels[roots[ti]] = polyCount++;
+        }
+    }
+
+    PolyhedraCsr csr;
+    csr.owners.resize(tetraCount);
+    for (int ti = 0; ti < tetraCount; ++ti)
+    {
+        csr.owners[ti] = labels[roots[ti]];
+        if (csr.owners[ti] == -1)
+            throw invalid_argument("Order must name every set once");
+    }
+
+    csr.tetraOffsets.assign(polyCount + 1, 0);
+    for (int pi : csr.owners)
+        ++csr.tetraOffsets[pi + 1];
+    for (int pi = 0; pi < polyCount; ++pi)
+        csr.tetraOffsets[pi + 1] += csr.tetraOffsets[pi];
+    csr.tetras.resize(tetraCount);
+    pmr::vector<int> cursor(csr.tetraOffsets.begin(), csr.tetraOffsets.end() - 1, memoryResource());
+    for (int ti = 0; ti < tetraCount; ++ti)
+        csr.tetras[cursor[csr.owners[ti]]++] = ti;
+
+    vector<vector<int>> faces(polyCount), vertices(polyCount);
+    parallelFor(
+        polyCount,
+        [&](int pi) {
+            for (int k = csr.tetraOffsets[pi]; k < csr.tetraOffsets[pi + 1]; ++k)
+            {
+                const int ti = csr.tetras[k];
+                const Tetrahedron &tetra = mesh.tetras[ti];
+                vertices[pi].insert(vertices[pi].end(), tetra.vertices.begin(), tetra.vertices.end());
+                for (int fi : tetra.faces)
+                {
+                    const int next = neighbour(mesh, ti, fi);
+                    if (next == -1 || csr.owners[next] != pi)
+                        faces[pi].push_back(fi);
+                }
+            }
+            ranges::sort(vertices[pi]);
+            vertices[pi].erase(unique(vertices[pi].begin(), vertices[pi].end()), vertices[pi].end());
+        },
+        256);
+    compress(&faces, &csr.faceOffsets, &csr.faces);
+    compress(&vertices, &csr.vertexOffsets, &csr.vertices);
+    GPOLYLLA_TRACE_COUNTER("polyhedra", polyCount);
+    return csr;
+}
+
+PolyMesh PolyhedraCsr::toPolyMesh(const Mesh &mesh) const
+{
+    PolyMesh result;
+    result.vertices = mesh.vertices;
+    result.faces = mesh.faces;
+    result.tetras = mesh.tetras;
+    for (int ti = 0; ti < result.tetras.size(); ++ti)
+        result.tetras[ti].polyhedron = owners[ti];
+
+    result.cells.resize(size());
+    parallelFor(
+        size(),
+        [&](int pi) {
+            Polyhedron &poly = result.cells[pi];
+            poly.cells.assign(tetras.begin() + tetraOffsets[pi], tetras.begin() + tetraOffsets[pi + 1]);
+            poly.faces.assign(faces.begin() + faceOffsets[pi], faces.begin() + faceOffsets[pi + 1]);
+            poly.vertices.assign(vertices.begin() + vertexOffsets[pi], vertices.begin() + vertexOffsets[pi + 1]);
+        },
+        256);
+    return result;
+}
@@ -169,22 +169,22 @@ bool Polyhedron::operator==(const Polyhedron &other) const
 
 // Areas and volumes
 
-float Face::area(const Mesh &mesh) const
+Real Face::area(const Mesh &mesh) const
 {
     const Vertex &v0 = mesh.vertices[vertices[0]];
     const Vertex &v1 = mesh.vertices[vertices[1]];
     const Vertex &v2 = mesh.vertices[vertices[2]];
-    return 0.5f * normal(v0, v1, v2).norm();
+    return Real(0.5) * normal(v0, v1, v2).norm();
 }
 
-float Tetrahedron::volume(const Mesh &mesh) const
+Real Tetrahedron::volume(const Mesh &mesh) const
 {
-    return signedSixthVolume(mesh.vertices[vertices[0]], mesh.vertices[vertices[1]], mesh.vertices[vertices[2]], mesh.vertices[vertices[3]]) / 6.0f;
+    return signedSixthVolume(mesh.vertices[vertices[0]], mesh.vertices[vertices[1]], mesh.vertices[vertices[2]], mesh.vertices[vertices[3]]) / 6;
 }
 
-float Tetrahedron::area(const Mesh &mesh) const
+Real Tetrahedron::area(const Mesh &mesh) const
 {
-    float totalArea = 0.0f;
+    Real totalArea = 0;
     for (int fi: faces)
     {
         const Face &f = mesh.faces.at(fi);
@@ -193,9 +193,9 @@ float Tetrahedron::area(const Mesh &mesh) const
     return totalArea;
 }
 
-float Polyhedron::volume(const PolyMesh &mesh) const
+Real Polyhedron::volume(const Mesh &mesh) const
 {
-    float volume = 0.0f;
+    Real volume = 0;
     for (int ti: cells)
     {
         const Tetrahedron &t = mesh.tetras.at(ti);
@@ -205,9 +205,9 @@ float Polyhedron::volume(const PolyMesh &mesh) const
     return volume;
 }
 
-float Polyhedron::area(const PolyMesh &mesh) const
+Real Polyhedron::area(const Mesh &mesh) const
 {
-    float totalArea = 0.0f;
+    Real totalArea = 0;
     for (int fi: faces)
     {
         const Face &f = mesh.faces.at(fi);
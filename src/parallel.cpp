@@ -0,0 +1,158 @@
+#include "parallel.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+using namespace Polylla;
+using namespace std;
+
+namespace
+{
+// One call of runTasks, with the scope of the thread that made it
+struct Job
+{
+    const function<void(int)> *task;
+    int tasks;
+    int threads;
+    pmr::memory_resource *memory;
+    int next = 1;
+    int pending;
+    exception_ptr error;
+};
+
+// Threads started when a call needs more of them and kept until the process exits. The pool is never destroyed,
+// so its threads may still wait on it during exit. A forked child has none of them, its calls run every task on
+// the calling thread.
+class Pool
+{
+  public:
+    static Pool &instance()
+    {
+        static Pool *pool = new Pool;
+        return *pool;
+    }
+
+    void run(int tasks, const function<void(int)> &task)
+    {
+        auto job = make_shared<Job>();
+        job->task = &task;
+        job->tasks = tasks;
+        job->threads = threadLimit();
+        job->memory = memoryResource();
+        job->pending = tasks;
+        {
+            lock_guard lock(guard);
+            for (; started < tasks - 1; ++started)
+                thread([this] { work(); }).detach();
+            jobs.push_back(job);
+        }
+        queued.notify_all();
+
+        execute(*job, 0);
+        unique_lock lock(guard);
+        finish(*job);
+        while (job->pending > 0)
+        {
+            // Helps with the queued tasks, of this job or of any other
+            auto [other, t] = take();
+            if (!other)
+            {
+                finished.wait(lock);
+                continue;
+            }
+            lock.unlock();
+            execute(*other, t);
+            lock.lock();
+            finish(*other);
+        }
+        if (job->error)
+            rethrow_exception(job->error);
+    }
+
+  private:
+    mutex guard;
+    condition_variable queued;
+    condition_variable finished;
+    deque<shared_ptr<Job>> jobs;
+    int started = 0;
+
+    void work()
+    {
+        unique_lock lock(guard);
+        while (true)
+        {
+            queued.wait(lock, [&] { return !jobs.empty(); });
+            auto [job, t] = take();
+            if (!job)
+                continue;
+            lock.unlock();
+            execute(*job, t);
+            lock.lock();
+            finish(*job);
+        }
+    }
+
+    // Next task of the oldest job, with the lock held. A failed job gives up the tasks it has not started.
+    pair<shared_ptr<Job>, int> take()
+    {
+        while (!jobs.empty())
+        {
+            shared_ptr<Job> job = jobs.front();
+            if (job->error)
+            {
+                job->pending -= job->tasks - job->next;
+                job->next = job->tasks;
+                jobs.pop_front();
+                if (job->pending == 0)
+                    finished.notify_all();
+                continue;
+            }
+            const int t = job->next++;
+            if (job->next == job->tasks)
+                jobs.pop_front();
+            return {job, t};
+        }
+        return {nullptr, -1};
+    }
+
+    // Runs a task under the scope of its job, without the lock
+    void execute(Job &job, int t)
+    {
+        const int threads = threadLimit();
+        pmr::memory_resource *memory = memoryResource();
+        inheritExecution(job.threads, job.memory);
+        try
+        {
+            (*job.task)(t);
+        }
+        catch (...)
+        {
+            lock_guard lock(guard);
+            if (!job.error)
+                job.error = current_exception();
+        }
+        inheritExecution(threads, memory);
+    }
+
+    // With the lock held
+    void finish(Job &job)
+    {
+        if (--job.pending == 0)
+            finished.notify_all();
+    }
+};
+} // namespace
+
+void Polylla::runTasks(int tasks, const function<void(int)> &task)
+{
+    if (tasks <= 1)
+    {
+        if (tasks == 1)
+            task(0);
+        return;
+    }
+    Pool::instance().run(tasks, task);
+}
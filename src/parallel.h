@@ -0,0 +1,53 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include "trace.h"
+#include <algorithm>
+#include <functional>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+namespace Polylla
+{
+// Thread limit of the ExecutionScope on this thread, 0 if none
+int threadLimit();
+// Memory resource of the ExecutionScope on this thread, the default resource if none
+std::pmr::memory_resource *memoryResource();
+// Sets the scope of a worker thread to that of the thread that started it
+void inheritExecution(int threads, std::pmr::memory_resource *memory);
+
+inline int threadCount()
+{
+    const int hardware = std::max(1u, std::thread::hardware_concurrency());
+    const int limit = threadLimit();
+    return limit > 0 ? std::min(hardware, limit) : hardware;
+}
+
+// Runs task(t) for every t in [0, tasks), task 0 on the calling thread and the others on a pool of threads kept
+// for the whole process, under the thread limit and memory resource of the calling thread. Returns once every
+// task is done; the first exception thrown by a task is rethrown here, tasks not started by then are skipped. A
+// thread waiting for its tasks runs queued ones, so tasks may start parallel loops of their own.
+void runTasks(int tasks, const std::function<void(int)> &task);
+
+// Calls body(i) for every i in [0, n), in contiguous chunks of at least minChunk indices per thread
+template <typename Body> void parallelFor(int n, Body &&body, int minChunk = 1024)
+{
+    const int threads = std::min(threadCount(), std::max(1, n / std::max(1, minChunk)));
+    if (threads <= 1)
+    {
+        for (int i = 0; i < n; ++i)
+            body(i);
+        return;
+    }
+
+    runTasks(threads, [&](int t) {
+        GPOLYLLA_TRACE_SCOPE("parallelFor");
+        const int begin = static_cast<int>(static_cast<long long>(n) * t / threads);
+        const int end = static_cast<int>(static_cast<long long>(n) * (t + 1) / threads);
+        for (int i = begin; i < end; ++i)
+            body(i);
+    });
+}
+} // namespace Polylla
+
+#endif // PARALLEL_H
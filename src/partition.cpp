@@ -0,0 +1,87 @@
+#include "partition.h"
+#include "cavity.h"
+#include "io.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace Polylla;
+using namespace std;
+
+LocalMesh Polylla::buildLocalMesh(vector<RegionTetra> region, const vector<Vertex> &vertices)
+{
+    ranges::sort(region, [](const RegionTetra &a, const RegionTetra &b) { return a.index < b.index; });
+
+    LocalMesh local;
+    unordered_map<int, int> lookup;
+    local.mesh.tetras.reserve(region.size());
+    for (const auto &t : region)
+    {
+        array<int, 4> ids;
+        for (int i = 0; i < 4; ++i)
+        {
+            auto [it, inserted] = lookup.try_emplace(t.vertices[i], static_cast<int>(local.vertices.size()));
+            if (inserted)
+            {
+                local.vertices.push_back(t.vertices[i]);
+                local.mesh.vertices.push_back(vertices[t.vertices[i]]);
+            }
+            ids[i] = it->second;
+        }
+        local.mesh.tetras.emplace_back(ids);
+        local.tetras.push_back(t.index);
+        local.core.push_back(t.core);
+    }
+    local.mesh.faces = buildFaces(local.mesh.vertices, local.mesh.tetras);
+    buildConnectivity(&local.mesh);
+    return local;
+}
+
+PolyMesh Polylla::localCavities(const LocalMesh &local, const function<bool(int)> &foreign)
+{
+    CavityInfo info;
+    PolyMesh result;
+    labelCavities(local.mesh, &result, &info);
+    for (int ti = 0; ti < local.tetras.size(); ++ti)
+    {
+        if (foreign(local.tetras[ti]))
+            info.owners[ti] = FOREIGN_OWNER;
+    }
+    buildCavities(local.mesh, &result, &info);
+    return result;
+}
+
+bool Polylla::isBounded(const LocalMesh &local, int ti, const Box3 &safe)
+{
+    return ranges::all_of(local.mesh.tetras[ti].vertices,
+                          [&](int vi) { return safe.contains(local.mesh.vertices[vi]); });
+}
+
+Vector3 Polylla::centroid(const array<int, 4> &tetra, const vector<Vertex> &vertices)
+{
+    Vector3 c = Vector3::Zero();
+    for (int vi : tetra)
+        c += vertices[vi];
+    return c / Real(4);
+}
+
+Real Polylla::extent(const array<int, 4> &tetra, const vector<Vertex> &vertices)
+{
+    Vector3 c = centroid(tetra, vertices);
+    Real result = 0;
+    for (int vi : tetra)
+        result = std::max(result, (vertices[vi] - c).norm());
+    return result;
+}
+
+uint64_t Polylla::mortonCode(uint32_t i, uint32_t j, uint32_t k)
+{
+    uint64_t code = 0;
+    for (int bit = 0; bit < 21; ++bit)
+    {
+        code |= (static_cast<uint64_t>((i >> bit) & 1) << (3 * bit)) |
+                (static_cast<uint64_t>((j >> bit) & 1) << (3 * bit + 1)) |
+                (static_cast<uint64_t>((k >> bit) & 1) << (3 * bit + 2));
+    }
+    return code;
+}
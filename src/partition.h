@@ -0,0 +1,42 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+#include <gpolylla/polylla.h>
+#include <cstdint>
+#include <functional>
+
+namespace Polylla
+{
+// Tetrahedron of a region of a larger mesh, indices are global
+struct RegionTetra
+{
+    int index;
+    std::array<int, 4> vertices;
+    bool core;
+};
+
+// Sub-mesh of a larger mesh. Tetrahedra are kept in global order so the seed order matches the whole mesh.
+struct LocalMesh
+{
+    Mesh mesh;
+    std::vector<int> tetras;   // local -> global tetrahedron
+    std::vector<int> vertices; // local -> global vertex
+    std::vector<bool> core;
+};
+
+LocalMesh buildLocalMesh(std::vector<RegionTetra> region, const std::vector<Vertex> &vertices);
+
+// Runs the cavity algorithm on the region, tetrahedra that are foreign (by global index) count as already owned
+PolyMesh localCavities(const LocalMesh &local, const std::function<bool(int)> &foreign);
+
+// Whether all the neighbours of a tetrahedron are in the region, given that the region has every tetrahedron
+// whose centroid is inside the safe box grown by the largest centroid to vertex distance
+bool isBounded(const LocalMesh &local, int ti, const Box3 &safe);
+
+Vector3 centroid(const std::array<int, 4> &tetra, const std::vector<Vertex> &vertices);
+// Largest distance from the centroid to one of the vertices
+Real extent(const std::array<int, 4> &tetra, const std::vector<Vertex> &vertices);
+
+uint64_t mortonCode(uint32_t i, uint32_t j, uint32_t k);
+} // namespace Polylla
+
+#endif // PARTITION_H
@@ -0,0 +1,59 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace Polylla
+{
+// Queue between two stages of a pipeline. push waits while the queue is full, pop waits while it is empty and
+// returns nothing once it is closed and drained.
+template <typename T> class BoundedQueue
+{
+  public:
+    explicit BoundedQueue(std::size_t capacity) : capacity(capacity)
+    {
+    }
+
+    void push(T value)
+    {
+        std::unique_lock guard(lock);
+        notFull.wait(guard, [&] { return items.size() < capacity; });
+        items.push_back(std::move(value));
+        notEmpty.notify_one();
+    }
+
+    std::optional<T> pop()
+    {
+        std::unique_lock guard(lock);
+        notEmpty.wait(guard, [&] { return !items.empty() || closed; });
+        if (items.empty())
+            return std::nullopt;
+        T value = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return value;
+    }
+
+    // No more pushes will come
+    void close()
+    {
+        std::lock_guard guard(lock);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+  private:
+    std::size_t capacity;
+    std::deque<T> items;
+    bool closed = false;
+    std::mutex lock;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+};
+} // namespace Polylla
+
+#endif // PIPELINE_H
@@ -0,0 +1,201 @@
+#include "predicates.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace Polylla;
+using namespace std;
+
+static constexpr double EPSILON = numeric_limits<double>::epsilon() / 2;
+// Error bounds of the double evaluations, relative to the permanent of the expression
+static constexpr double ORIENT_BOUND = (7.0 + 56.0 * EPSILON) * EPSILON;
+static constexpr double SPHERE_BOUND = (8.0 + 64.0 * EPSILON) * EPSILON;
+
+PredicateCounters &Polylla::predicateCounters()
+{
+    thread_local PredicateCounters counters;
+    return counters;
+}
+
+// Exact sum of doubles, as non-overlapping terms of increasing magnitude
+class Expansion
+{
+  public:
+    Expansion(double value = 0.0)
+    {
+        if (value != 0.0)
+            terms.push_back(value);
+    }
+
+    static Expansion difference(double a, double b)
+    {
+        auto [sum, error] = twoSum(a, -b);
+        Expansion result;
+        if (error != 0.0)
+            result.terms.push_back(error);
+        if (sum != 0.0)
+            result.terms.push_back(sum);
+        return result;
+    }
+
+    Expansion operator+(const Expansion &other) const
+    {
+        Expansion result = *this;
+        for (double term : other.terms)
+            result.grow(term);
+        return result;
+    }
+
+    Expansion operator-(const Expansion &other) const
+    {
+        return *this + other.negated();
+    }
+
+    Expansion operator*(const Expansion &other) const
+    {
+        Expansion result;
+        for (double term : other.terms)
+            result = result + scaled(term);
+        return result;
+    }
+
+    // The largest term has the sign of the sum
+    double estimate() const
+    {
+        double sum = 0.0;
+        for (double term : terms)
+            sum += term;
+        return sum;
+    }
+
+  private:
+    vector<double> terms;
+
+    static pair<double, double> twoSum(double a, double b)
+    {
+        double sum = a + b;
+        double bVirtual = sum - a;
+        double aVirtual = sum - bVirtual;
+        return {sum, (a - aVirtual) + (b - bVirtual)};
+    }
+
+    static pair<double, double> twoProduct(double a, double b)
+    {
+        double product = a * b;
+        return {product, fma(a, b, -product)};
+    }
+
+    Expansion negated() const
+    {
+        Expansion result = *this;
+        for (double &term : result.terms)
+            term = -term;
+        return result;
+    }
+
+    // Grow-Expansion with zero elimination
+    void grow(double value)
+    {
+        vector<double> result;
+        result.reserve(terms.size() + 1);
+        double q = value;
+        for (double term : terms)
+        {
+            auto [sum, error] = twoSum(q, term);
+            if (error != 0.0)
+                result.push_back(error);
+            q = sum;
+        }
+        if (q != 0.0)
+            result.push_back(q);
+        terms = std::move(result);
+    }
+
+    // Scale-Expansion with zero elimination
+    Expansion scaled(double factor) const
+    {
+        Expansion result;
+        if (terms.empty() || factor == 0.0)
+            return result;
+        auto [q, error] = twoProduct(terms[0], factor);
+        if (error != 0.0)
+            result.terms.push_back(error);
+        for (size_t i = 1; i < terms.size(); ++i)
+        {
+            auto [product, productError] = twoProduct(terms[i], factor);
+            auto [sum, sumError] = twoSum(q, productError);
+            if (sumError != 0.0)
+                result.terms.push_back(sumError);
+            // |sum| <= |product| after the previous steps, so the fast variant of two-sum is exact here
+            double total = product + sum;
+            double low = sum - (total - product);
+            if (low != 0.0)
+                result.terms.push_back(low);
+            q = total;
+        }
+        if (q != 0.0)
+            result.terms.push_back(q);
+        return result;
+    }
+};
+
+static double orient3dExact(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3)
+{
+    Expansion u[3], v[3], w[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        u[i] = Expansion::difference(v1[i], v0[i]);
+        v[i] = Expansion::difference(v2[i], v0[i]);
+        w[i] = Expansion::difference(v3[i], v0[i]);
+    }
+    Expansion det = u[0] * (v[1] * w[2] - v[2] * w[1]) + u[1] * (v[2] * w[0] - v[0] * w[2]) +
+                    u[2] * (v[0] * w[1] - v[1] * w[0]);
+    return det.estimate();
+}
+
+double Polylla::orient3d(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3)
+{
+    auto &counters = predicateCounters();
+    counters.calls++;
+
+    const double ux = double(v1.x()) - v0.x(), uy = double(v1.y()) - v0.y(), uz = double(v1.z()) - v0.z();
+    const double vx = double(v2.x()) - v0.x(), vy = double(v2.y()) - v0.y(), vz = double(v2.z()) - v0.z();
+    const double wx = double(v3.x()) - v0.x(), wy = double(v3.y()) - v0.y(), wz = double(v3.z()) - v0.z();
+
+    const double vywz = vy * wz, vzwy = vz * wy;
+    const double vzwx = vz * wx, vxwz = vx * wz;
+    const double vxwy = vx * wy, vywx = vy * wx;
+    const double det = ux * (vywz - vzwy) + uy * (vzwx - vxwz) + uz * (vxwy - vywx);
+
+    const double permanent = (abs(vywz) + abs(vzwy)) * abs(ux) + (abs(vzwx) + abs(vxwz)) * abs(uy) +
+                             (abs(vxwy) + abs(vywx)) * abs(uz);
+    if (abs(det) > ORIENT_BOUND * permanent)
+        return det;
+
+    counters.exact++;
+    return orient3dExact(v0, v1, v2, v3);
+}
+
+double Polylla::sphereSide(const Eigen::Vector3d &center, double radius, const Eigen::Vector3d &point)
+{
+    auto &counters = predicateCounters();
+    counters.calls++;
+
+    const double dx = point.x() - center.x();
+    const double dy = point.y() - center.y();
+    const double dz = point.z() - center.z();
+    const double squared = dx * dx + dy * dy + dz * dz;
+    const double side = squared - radius * radius;
+    if (abs(side) > SPHERE_BOUND * (squared + radius * radius))
+        return side;
+
+    counters.exact++;
+    Expansion sum, r(radius);
+    for (int i = 0; i < 3; ++i)
+    {
+        Expansion d = Expansion::difference(point[i], center[i]);
+        sum = sum + d * d;
+    }
+    return (sum - r * r).estimate();
+}
@@ -0,0 +1,31 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+#include <gpolylla/polylla.h>
+#include <cstdint>
+
+namespace Polylla
+{
+// Filtered geometric predicates. A double precision evaluation is trusted when it is farther from zero than
+// its error bound, otherwise the sign is computed exactly with floating point expansions (Shewchuk, 1997).
+
+// Six times the signed volume of (v0, v1, v2, v3), that is (v1 - v0) x (v2 - v0) . (v3 - v0). The sign is exact.
+double orient3d(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3);
+
+// |point - center|^2 - radius^2. The sign is exact for the given center and radius, not for the sphere through the
+// vertices they were rounded from.
+double sphereSide(const Eigen::Vector3d &center, double radius, const Eigen::Vector3d &point);
+inline double sphereSide(const Vertex &center, double radius, const Vertex &point)
+{
+    return sphereSide(Eigen::Vector3d(center.cast<double>()), radius, Eigen::Vector3d(point.cast<double>()));
+}
+
+// Calls of the predicates on this thread and how many needed the exact evaluation
+struct PredicateCounters
+{
+    std::uint64_t calls = 0;
+    std::uint64_t exact = 0;
+};
+PredicateCounters &predicateCounters();
+} // namespace Polylla
+
+#endif // PREDICATES_H
@@ -0,0 +1,31 @@
+#include <gpolylla/progress.h>
+
+using namespace Polylla;
+using namespace std;
+
+void Progress::phase(const string &name)
+{
+    {
+        lock_guard lock(mutex);
+        phase_ = name;
+    }
+    report(0);
+}
+
+void Progress::report(double fraction)
+{
+    fraction_.store(fraction, memory_order_relaxed);
+    if (cancelled())
+        throw CancelledError("Cancelled during " + currentPhase());
+}
+
+void Progress::cancel()
+{
+    cancelled_.store(true, memory_order_relaxed);
+}
+
+string Progress::currentPhase() const
+{
+    lock_guard lock(mutex);
+    return phase_;
+}
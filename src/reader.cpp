@@ -1,19 +1,19 @@
 #include <fstream>
+#include <future>
+#include <sstream>
 #include <unordered_set>
 
+#include "io.h"
 #include "logger.h"
+#include "trace.h"
 #include "utils.h"
 
 using namespace Polylla;
 using namespace std;
 
-class FileNotFoundError : public std::runtime_error
-{
-    using std::runtime_error::runtime_error;
-};
-
-vector<Vertex> buildVertices(const string &file)
+vector<Vertex> Polylla::buildVertices(const string &file)
 {
+    GPOLYLLA_TRACE_SCOPE("buildVertices");
     vector<Vertex> verts;
 
     ifstream nodeStream(file);
@@ -44,7 +44,7 @@ vector<Vertex> buildVertices(const string &file)
                 verts.emplace_back(-1, -1, -1);
             first = 0;
         }
-        float x, y, z;
+        Real x, y, z;
         lineStream >> x >> y >> z;
         verts.emplace_back(x, y, z);
     }
@@ -52,8 +52,9 @@ vector<Vertex> buildVertices(const string &file)
     return verts;
 }
 
-vector<Tetrahedron> buildCells(const string &file)
+vector<Tetrahedron> Polylla::buildCells(const string &file)
 {
+    GPOLYLLA_TRACE_SCOPE("buildCells");
     vector<Tetrahedron> cells;
     ifstream eleStream(file);
     if (!eleStream.is_open())
@@ -90,8 +91,9 @@ vector<Tetrahedron> buildCells(const string &file)
     return cells;
 }
 
-vector<Face> buildFaces(const vector<Vertex> &vertices, const vector<Tetrahedron> &tetrahedrons)
+vector<Face> Polylla::buildFaces(const vector<Vertex> &vertices, const vector<Tetrahedron> &tetrahedrons)
 {
+    GPOLYLLA_TRACE_SCOPE("buildFaces");
     vector<Face> faces;
     unordered_set<Face> faceSet;
 
@@ -125,8 +127,9 @@ vector<Face> buildFaces(const vector<Vertex> &vertices, const vector<Tetrahedron
     return faces;
 }
 
-void buildConnectivity(Mesh *mesh)
+void Polylla::buildConnectivity(Mesh *mesh)
 {
+    GPOLYLLA_TRACE_SCOPE("buildConnectivity");
     using facePos = std::pair<int, int>;
     unordered_map<Face, vector<facePos>> faceMap;
 
@@ -185,11 +188,19 @@ void buildConnectivity(Mesh *mesh)
 
 Mesh TetgenReader::readMesh()
 {
+    GPOLYLLA_TRACE_SCOPE("TetgenReader::readMesh");
+    ExecutionScope scope(context);
     Mesh m;
-    m.vertices = buildVertices(this->nodeFile);
+    context.phase("read");
+    // The two files are parsed at the same time
+    auto vertices = async(launch::async, [&] { return buildVertices(this->nodeFile); });
     m.tetras = buildCells(this->eleFile);
+    m.vertices = vertices.get();
 
+    context.phase("faces");
     m.faces = buildFaces(m.vertices, m.tetras);
+    context.phase("connectivity");
     buildConnectivity(&m);
+    context.report(1);
     return m;
 }
\ No newline at end of file
@@ -0,0 +1,367 @@
+#include "parallel.h"
+#include "partition.h"
+#include "trace.h"
+#include "utils.h"
+#include <gpolylla/render.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+using namespace Polylla;
+using namespace std;
+
+namespace
+{
+// Corners of face k of the tetrahedron, counter-clockwise seen from outside, and its outward unit normal
+array<int, 3> orientedFace(const Mesh &mesh, int ti, int k, Vector3 *normal)
+{
+    const Tetrahedron &tetra = mesh.tetras[ti];
+    auto corners = mesh.faces[tetra.faces[k]].vertices;
+    const int other = *ranges::find_if(tetra.vertices, [&](int vi) { return !ranges::count(corners, vi); });
+
+    const Vector3 &a = mesh.vertices[corners[0]];
+    *normal = (mesh.vertices[corners[1]] - a).cross(mesh.vertices[corners[2]] - a).normalized();
+    // Outwards, away from the vertex off the face
+    if (normal->dot(mesh.vertices[other] - a) > 0)
+    {
+        *normal = -*normal;
+        swap(corners[1], corners[2]);
+    }
+    return corners;
+}
+} // namespace
+
+CellBuffer Polylla::buildCellBuffer(const Mesh &mesh)
+{
+    GPOLYLLA_TRACE_SCOPE("buildCellBuffer");
+    const int tetraCount = static_cast<int>(mesh.tetras.size());
+    CellBuffer buffer;
+    buffer.vertices.resize(static_cast<size_t>(tetraCount) * CellBuffer::VERTICES_PER_CELL);
+
+    parallelFor(tetraCount, [&](int ti) {
+        CellVertex *out = buffer.vertices.data() + CellBuffer::first(ti);
+        for (int k = 0; k < 4; ++k)
+        {
+            Vector3 normal;
+            for (int vi : orientedFace(mesh, ti, k, &normal))
+            {
+                const Vertex &v = mesh.vertices[vi];
+                *out++ = {{static_cast<float>(v.x()), static_cast<float>(v.y()), static_cast<float>(v.z())},
+                          {static_cast<float>(normal.x()), static_cast<float>(normal.y()),
+                           static_cast<float>(normal.z())},
+                          ti};
+            }
+        }
+    });
+    return buffer;
+}
+
+array<float, 3> Polylla::hsvToRgb(float h, float s, float v)
+{
+    const float c = v * s;
+    const float x = c * (1.0f - fabs(fmod(h / 60.0f, 2.0f) - 1.0f));
+    const float m = v - c;
+
+    array<float, 3> rgb;
+    if (h >= 0 && h < 60)
+        rgb = {c, x, 0};
+    else if (h >= 60 && h < 120)
+        rgb = {x, c, 0};
+    else if (h >= 120 && h < 180)
+        rgb = {0, c, x};
+    else if (h >= 180 && h < 240)
+        rgb = {0, x, c};
+    else if (h >= 240 && h < 300)
+        rgb = {x, 0, c};
+    else
+        rgb = {c, 0, x};
+    for (float &channel : rgb)
+        channel += m;
+    return rgb;
+}
+
+vector<array<float, 3>> Polylla::cellColors(int count, unsigned seed)
+{
+    mt19937 random(seed);
+    uniform_real_distribution<float> hue(0.0f, 360.0f);
+    vector<array<float, 3>> colors(count);
+    for (auto &color : colors)
+        color = cellColor(hue(random));
+    return colors;
+}
+
+VisibleSurface::VisibleSurface(const Mesh &mesh, vector<int> groups)
+    : mesh(&mesh), groups(std::move(groups)), visible_(mesh.tetras.size(), 1), positions(mesh.tetras.size() * 4, -1)
+{
+    GPOLYLLA_TRACE_SCOPE("VisibleSurface");
+    const int sideCount = static_cast<int>(positions.size());
+    vector<char> flags(sideCount);
+    parallelFor(sideCount, [&](int side) { flags[side] = seen(side); });
+    for (int side = 0; side < sideCount; ++side)
+    {
+        if (flags[side])
+        {
+            positions[side] = static_cast<int>(sides_.size());
+            sides_.push_back(side);
+        }
+    }
+    triangles_.resize(sides_.size());
+    parallelFor(static_cast<int>(sides_.size()), [&](int i) { triangles_[i] = triangle(sides_[i]); });
+    GPOLYLLA_TRACE_COUNTER("surfaceTriangles", sides_.size());
+}
+
+void VisibleSurface::setVisible(int ti, bool visible)
+{
+    if (visible_[ti] == visible)
+        return;
+    visible_[ti] = visible;
+    for (int k = 0; k < 4; ++k)
+    {
+        const int fi = mesh->tetras[ti].faces[k];
+        update(4 * ti + k);
+        const Face &face = mesh->faces[fi];
+        const int next = face.tetras[0] == ti ? face.tetras[1] : face.tetras[0];
+        if (next != -1)
+            update(4 * next + static_cast<int>(ranges::find(mesh->tetras[next].faces, fi) -
+                                               mesh->tetras[next].faces.begin()));
+    }
+}
+
+bool VisibleSurface::seen(int side) const
+{
+    const int ti = side / 4;
+    if (!visible_[ti])
+        return false;
+    const Face &face = mesh->faces[mesh->tetras[ti].faces[side % 4]];
+    const int next = face.tetras[0] == ti ? face.tetras[1] : face.tetras[0];
+    return next == -1 || !visible_[next] || (!groups.empty() && groups[next] != groups[ti]);
+}
+
+array<int, 3> VisibleSurface::triangle(int side) const
+{
+    Vector3 normal;
+    return orientedFace(*mesh, side / 4, side % 4, &normal);
+}
+
+void VisibleSurface::update(int side)
+{
+    const bool wanted = seen(side);
+    const int position = positions[side];
+    if (wanted && position == -1)
+    {
+        positions[side] = static_cast<int>(sides_.size());
+        sides_.push_back(side);
+        triangles_.push_back(triangle(side));
+    }
+    else if (!wanted && position != -1)
+    {
+        // The last side takes its place
+        positions[sides_.back()] = position;
+        sides_[position] = sides_.back();
+        triangles_[position] = triangles_.back();
+        sides_.pop_back();
+        triangles_.pop_back();
+        positions[side] = -1;
+    }
+}
+
+HullBuffer Polylla::buildHullBuffer(const PolyMesh &mesh, const vector<PolyStat> &stats)
+{
+    GPOLYLLA_TRACE_SCOPE("buildHullBuffer");
+    const int polyCount = static_cast<int>(mesh.cells.size());
+    if (!stats.empty() && stats.size() != mesh.cells.size())
+        throw invalid_argument("Stats do not match the polyhedra of the mesh");
+    vector<Hull> computed;
+    if (stats.empty())
+    {
+        computed.resize(polyCount);
+        parallelFor(polyCount, [&](int pi) { computed[pi] = Hull(mesh.cells[pi], mesh); }, 64);
+    }
+    auto hullOf = [&](int pi) -> const Hull & { return stats.empty() ? computed[pi] : stats[pi].hull; };
+
+    HullBuffer buffer;
+    buffer.offsets.assign(polyCount + 1, 0);
+    for (int pi = 0; pi < polyCount; ++pi)
+        buffer.offsets[pi + 1] = buffer.offsets[pi] + 3 * static_cast<int>(hullOf(pi).faces().size());
+    buffer.vertices.resize(buffer.offsets.back());
+
+    parallelFor(
+        polyCount,
+        [&](int pi) {
+            const Hull &hull = hullOf(pi);
+            const auto &points = hull.vertices();
+            Vector3 center = Vector3::Zero();
+            for (const auto &p : points)
+                center += p / static_cast<Real>(points.size());
+            const int cell = mesh.cells[pi].cells.empty() ? -1 : mesh.cells[pi].cells.front();
+
+            CellVertex *out = buffer.vertices.data() + buffer.offsets[pi];
+            for (const Face &face : hull.faces())
+            {
+                array<Vector3, 3> corners = {points[face.vertices[0]], points[face.vertices[1]],
+                                             points[face.vertices[2]]};
+                Vector3 normal = (corners[1] - corners[0]).cross(corners[2] - corners[0]);
+                // Outwards, the hull is convex so its center is behind every face
+                if (normal.dot(corners[0] - center) < 0)
+                {
+                    normal = -normal;
+                    swap(corners[1], corners[2]);
+                }
+                if (normal.norm() > 0)
+                    normal.normalize();
+                for (const Vector3 &v : corners)
+                {
+                    *out++ = {{static_cast<float>(v.x()), static_cast<float>(v.y()), static_cast<float>(v.z())},
+                              {static_cast<float>(normal.x()), static_cast<float>(normal.y()),
+                               static_cast<float>(normal.z())},
+                              cell};
+                }
+            }
+        },
+        64);
+    return buffer;
+}
+
+Frustum Frustum::fromMatrix(const float *viewProjection)
+{
+    auto row = [&](int i) {
+        return Eigen::Matrix<Real, 4, 1>(viewProjection[i], viewProjection[4 + i], viewProjection[8 + i],
+                                         viewProjection[12 + i]);
+    };
+    Frustum frustum;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        frustum.planes[2 * axis] = row(3) + row(axis);
+        frustum.planes[2 * axis + 1] = row(3) - row(axis);
+    }
+    return frustum;
+}
+
+bool Frustum::intersects(const Box3 &box) const
+{
+    if (box.isEmpty())
+        return false;
+    for (const auto &plane : planes)
+    {
+        // The corner of the box farthest along the plane normal
+        Vector3 corner;
+        for (int k = 0; k < 3; ++k)
+            corner[k] = plane[k] >= 0 ? box.max()[k] : box.min()[k];
+        if (plane.head<3>().dot(corner) + plane[3] < 0)
+            return false;
+    }
+    return true;
+}
+
+CellClusters::CellClusters(const vector<Box3> &boxes, const vector<int> &groups, int clusterSize)
+    : clusters_(boxes.size(), -1)
+{
+    GPOLYLLA_TRACE_SCOPE("CellClusters");
+    const int cellCount = static_cast<int>(boxes.size());
+    if (!groups.empty() && groups.size() != boxes.size())
+        throw invalid_argument("Groups do not match the boxes");
+    auto groupOf = [&](int ti) { return groups.empty() ? ti : groups[ti]; };
+
+    int groupCount = groups.empty() ? cellCount : 0;
+    for (int g : groups)
+        groupCount = max(groupCount, g + 1);
+    vector<Box3> groupBoxes(groupCount);
+    vector<int> groupSizes(groupCount, 0);
+    Box3 bounds;
+    for (int ti = 0; ti < cellCount; ++ti)
+    {
+        groupBoxes[groupOf(ti)].extend(boxes[ti]);
+        ++groupSizes[groupOf(ti)];
+        bounds.extend(boxes[ti]);
+    }
+
+    const Vector3 size = bounds.sizes().cwiseMax(TOLERANCE);
+    vector<pair<uint64_t, int>> codes;
+    for (int g = 0; g < groupCount; ++g)
+    {
+        if (groupSizes[g] == 0)
+            continue;
+        const Vector3 cell = (groupBoxes[g].center() - bounds.min()).cwiseQuotient(size) * Real(1023);
+        codes.emplace_back(mortonCode(static_cast<uint32_t>(cell.x()), static_cast<uint32_t>(cell.y()),
+                                      static_cast<uint32_t>(cell.z())),
+                           g);
+    }
+    ranges::sort(codes);
+
+    vector<int> clusterOfGroup(groupCount, -1);
+    int filled = 0;
+    for (auto [code, g] : codes)
+    {
+        if (boxes_.empty() || filled >= clusterSize)
+        {
+            boxes_.emplace_back();
+            filled = 0;
+        }
+        clusterOfGroup[g] = static_cast<int>(boxes_.size()) - 1;
+        boxes_.back().extend(groupBoxes[g]);
+        filled += groupSizes[g];
+    }
+    for (int ti = 0; ti < cellCount; ++ti)
+        clusters_[ti] = clusterOfGroup[groupOf(ti)];
+    bvh = Bvh(boxes_);
+    GPOLYLLA_TRACE_COUNTER("clusters", boxes_.size());
+}
+
+vector<int> CellClusters::visible(const Frustum &frustum) const
+{
+    vector<int> found;
+    bvh.traverse([&](const Box3 &box) { return frustum.intersects(box); },
+                 [&](int cluster) {
+                     if (frustum.intersects(boxes_[cluster]))
+                         found.push_back(cluster);
+                 });
+    ranges::sort(found);
+    return found;
+}
+
+void Polylla::fillSphereInstances(const vector<CavityAlgorithm::Cavity> &cavities, const vector<int> &owners,
+                                  const SphereFilter &filter, vector<SphereInstance> *instances)
+{
+    GPOLYLLA_TRACE_SCOPE("fillSphereInstances");
+    constexpr int CHUNK = 4096;
+    const int cavityCount = static_cast<int>(cavities.size());
+    if (filter.owner != -1 && owners.size() != cavities.size())
+        throw invalid_argument("Owners do not match the cavities");
+    auto passes = [&](int ti) {
+        const auto &cavity = cavities[ti];
+        return isfinite(cavity.radius) && cavity.radius >= filter.minRadius && cavity.radius <= filter.maxRadius &&
+               (filter.owner == -1 || owners[ti] == filter.owner);
+    };
+
+    // Counted per chunk first, so every chunk knows where its spheres go
+    const int chunkCount = (cavityCount + CHUNK - 1) / CHUNK;
+    vector<int> offsets(chunkCount + 1, 0);
+    parallelFor(
+        chunkCount,
+        [&](int c) {
+            for (int ti = c * CHUNK; ti < min(cavityCount, (c + 1) * CHUNK); ++ti)
+                offsets[c + 1] += passes(ti);
+        },
+        1);
+    for (int c = 0; c < chunkCount; ++c)
+        offsets[c + 1] += offsets[c];
+
+    instances->resize(offsets.back());
+    parallelFor(
+        chunkCount,
+        [&](int c) {
+            SphereInstance *out = instances->data() + offsets[c];
+            for (int ti = c * CHUNK; ti < min(cavityCount, (c + 1) * CHUNK); ++ti)
+            {
+                if (!passes(ti))
+                    continue;
+                const auto &cavity = cavities[ti];
+                *out++ = {{static_cast<float>(cavity.center.x()), static_cast<float>(cavity.center.y()),
+                           static_cast<float>(cavity.center.z())},
+                          static_cast<float>(cavity.radius)};
+            }
+        },
+        1);
+    GPOLYLLA_TRACE_COUNTER("sphereInstances", instances->size());
+}
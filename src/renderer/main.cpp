@@ -19,9 +19,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <chrono>
 #include <cmath>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <numeric>
 #include <optional>
 #include <random>
 #include <stdio.h>
@@ -29,6 +33,8 @@
 #include <unordered_set>
 
 #include <gpolylla/polylla.h>
+#include <gpolylla/progress.h>
+#include <gpolylla/render.h>
 #include <gpolylla/stat.h>
 
 #ifndef M_PI
@@ -47,7 +53,7 @@ static void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 static void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
 
-glm::vec3 toVec3(const Polylla::Vertex &vertex)
+glm::vec3 toVec3(const Polylla::Vector3 &vertex)
 {
     return glm::vec3(vertex.x(), vertex.y(), vertex.z());
 }
@@ -302,6 +308,12 @@ struct Layout
         stride += size * sizeof(float);
     }
 
+    template <> void push<int>(int size)
+    {
+        attributes.push_back({GL_INT, size, stride});
+        stride += size * sizeof(int);
+    }
+
     void build()
     {
         bind();
@@ -310,7 +322,11 @@ struct Layout
         for (auto [type, size, offset] : attributes)
         {
             glEnableVertexAttribArray(location);
-            glVertexAttribPointer(location, size, type, GL_FALSE, stride, reinterpret_cast<void *>(offset));
+            // Integers reach the shader as integers only through the I variant
+            if (type == GL_INT)
+                glVertexAttribIPointer(location, size, type, stride, reinterpret_cast<void *>(offset));
+            else
+                glVertexAttribPointer(location, size, type, GL_FALSE, stride, reinterpret_cast<void *>(offset));
             location++;
         }
 
@@ -409,67 +425,6 @@ struct CellBuffer : public Buffer
     }
 };
 
-struct PhongCellBuffer : public Buffer
-{
-    void init(const Polylla::Tetrahedron &cell, const Polylla::Mesh &mesh)
-    {
-        std::vector<float> vertices;
-        std::vector<unsigned int> indices;
-
-        int index = 0;
-        for (int fi = 0; fi < cell.faces.size(); fi++)
-        {
-            // Calculate face normal
-            const auto &face = mesh.faces.at(cell.faces.at(fi));
-
-            auto faceVertices = face.vertices;
-
-            const auto &other = mesh.vertices.at(cell.vertices.at(fi));
-
-            const auto &v0 = mesh.vertices.at(faceVertices.at(0));
-            const auto &v1 = mesh.vertices.at(faceVertices.at(1));
-            const auto &v2 = mesh.vertices.at(faceVertices.at(2));
-
-            glm::vec3 p0(v0.x(), v0.y(), v0.z());
-            glm::vec3 p1(v1.x(), v1.y(), v1.z());
-            glm::vec3 p2(v2.x(), v2.y(), v2.z());
-            glm::vec3 pOther(other.x(), other.y(), other.z());
-
-            glm::vec3 toOther = pOther - p0;
-
-            glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
-            if (glm::dot(normal, toOther) > 0)
-            {
-                normal = -normal;
-                std::ranges::reverse(faceVertices);
-            }
-
-            for (auto vi : faceVertices)
-            {
-                const auto &v = mesh.vertices.at(vi);
-                // Position
-                vertices.push_back(v.x());
-                vertices.push_back(v.y());
-                vertices.push_back(v.z());
-                // Normal
-                vertices.push_back(normal.x);
-                vertices.push_back(normal.y);
-                vertices.push_back(normal.z);
-
-                indices.push_back(index++);
-            }
-        }
-
-        Buffer::init(vertices, indices);
-    }
-
-    void buildLayout() override
-    {
-        layout.push<float>(3); // Position
-        layout.push<float>(3); // Normal
-    }
-};
-
 struct SphereBuffer : public Buffer
 {
     void init(float radius = 0.2f, int slices = 16, int stacks = 16)
@@ -529,10 +484,67 @@ struct SphereBuffer : public Buffer
     }
 };
 
+// The circumspheres of the cavities, a unit sphere drawn once per sphere with its center and radius as instance
+// attributes. The instances are refilled and uploaded only when the filter or the cavities change.
+struct CavitySpheres
+{
+    SphereBuffer sphere;
+    GLuint instanceVbo = 0;
+    std::vector<Polylla::SphereInstance> instances;
+    Polylla::SphereFilter filter;
+    // Set when the cavities change
+    bool dirty = true;
+
+    void init()
+    {
+        sphere.init(1.0f, 16, 12);
+        sphere.layout.bind();
+        glGenBuffers(1, &instanceVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Polylla::SphereInstance), nullptr);
+        glVertexAttribDivisor(2, 1);
+        sphere.layout.unbind();
+    }
+
+    void update(const std::vector<Polylla::CavityAlgorithm::Cavity> &cavities, const std::vector<int> &owners,
+                const Polylla::SphereFilter &next)
+    {
+        if (!dirty && next == filter)
+            return;
+        dirty = false;
+        filter = next;
+        Polylla::fillSphereInstances(cavities, owners, filter, &instances);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Polylla::SphereInstance), instances.data(),
+                     GL_DYNAMIC_DRAW);
+    }
+
+    void draw()
+    {
+        if (instances.empty())
+            return;
+        sphere.layout.bind();
+        glDrawElementsInstanced(GL_TRIANGLES, sphere.indices.size(), GL_UNSIGNED_INT, 0, instances.size());
+        sphere.layout.unbind();
+    }
+
+    void end()
+    {
+        glDeleteBuffers(1, &instanceVbo);
+        sphere.end();
+    }
+};
+
 struct AABB
 {
     glm::vec3 min = glm::vec3(0.0f, 0.0f, 0.0f);
     glm::vec3 max = glm::vec3(0.0f, 0.0f, 0.0f);
+
+    Polylla::Box3 box() const
+    {
+        return Polylla::Box3(Polylla::Vector3(min.x, min.y, min.z), Polylla::Vector3(max.x, max.y, max.z));
+    }
 };
 
 struct Model
@@ -555,28 +567,349 @@ struct Model
     AABB collider;
 };
 
+// Ranges of one multi draw call, firsts for arrays and byte offsets for elements
+struct DrawRanges
+{
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+    std::vector<const void *> offsets;
+
+    void clear()
+    {
+        firsts.clear();
+        counts.clear();
+        offsets.clear();
+    }
+
+    void add(GLint first, GLsizei count)
+    {
+        firsts.push_back(first);
+        counts.push_back(count);
+        offsets.push_back(reinterpret_cast<const void *>(static_cast<uintptr_t>(first) * sizeof(unsigned int)));
+    }
+};
+
+// Every tetrahedron in one vertex array. Only the faces of the visible surface are drawn, through an element
+// buffer over that array. The color of every cell lives in a buffer texture indexed by the cell attribute of its
+// vertices, alpha 0 hides the cell, so repainting or hiding cells only uploads that texture and the faces around
+// the cells that changed.
+//
+// The surface is sorted by cluster of cells, so every frame cull() keeps the clusters in the view as ranges of the
+// element buffer. Once the mesh is transformed, a distant cluster is drawn with the convex hulls of its polyhedra
+// when they have fewer triangles than its surface.
 struct VolumeMesh
 {
     std::vector<Model> cells;
-    std::vector<std::unique_ptr<Buffer>> buffers;
+    Layout layout;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    GLuint colorBuffer = 0;
+    GLuint colorTexture = 0;
+    // Faces seen around the opaque cells
+    Polylla::VisibleSurface surface;
+    int surfaceCount = 0;
+    // Set when the color or visibility of a cell changes, the colors are uploaded on the next sync()
+    bool dirty = true;
+
+    Polylla::CellClusters clusters;
+    // Range of every cluster in the element buffer
+    std::vector<GLsizei> clusterFirsts;
+    std::vector<GLsizei> clusterCounts;
+    std::vector<int> selectedCells;
+    std::vector<int> transparentCells;
+
+    Layout hullLayout;
+    GLuint hullVbo = 0;
+    GLuint hullEbo = 0;
+    std::vector<int> hullOffsets;
+    // Polyhedron of every cell, empty until the mesh is transformed
+    std::vector<int> polyhedra;
+    // Range of the hulls of every cluster in the hull element buffer, empty if it is never drawn coarse
+    std::vector<GLsizei> coarseFirsts;
+    std::vector<GLsizei> coarseCounts;
+
+    // What cull() kept for the frame
+    DrawRanges detailRanges;
+    DrawRanges coarseRanges;
+    DrawRanges selectedRanges;
+    DrawRanges transparentRanges;
+
+    void init(const Polylla::CellBuffer &buffer, const Polylla::Mesh &mesh, Polylla::CellClusters cellClusters)
+    {
+        layout.init();
+        layout.push<float>(3); // Position
+        layout.push<float>(3); // Normal
+        layout.push<int>(1);   // Cell
+        layout.bind();
 
-    void init()
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, buffer.vertices.size() * sizeof(Polylla::CellVertex), buffer.vertices.data(),
+                     GL_STATIC_DRAW);
+
+        // The element buffer is recorded in the vertex array, it is filled by sync()
+        glGenBuffers(1, &ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+        layout.build();
+        layout.unbind();
+        surface = Polylla::VisibleSurface(mesh);
+        clusters = std::move(cellClusters);
+
+        glGenBuffers(1, &colorBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, colorBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, buffer.cellCount() * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+        glGenTextures(1, &colorTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, colorTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, colorBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        dirty = true;
+    }
+
+    // Uploads the hulls of the polyhedra, clusters keep the cells of a polyhedron together
+    void setHulls(const Polylla::HullBuffer &hulls, std::vector<int> cellPolyhedra, Polylla::CellClusters cellClusters)
+    {
+        clearHulls();
+        hullLayout.init();
+        hullLayout.push<float>(3); // Position
+        hullLayout.push<float>(3); // Normal
+        hullLayout.push<int>(1);   // Cell
+        hullLayout.bind();
+        glGenBuffers(1, &hullVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, hullVbo);
+        glBufferData(GL_ARRAY_BUFFER, hulls.vertices.size() * sizeof(Polylla::CellVertex), hulls.vertices.data(),
+                     GL_STATIC_DRAW);
+        glGenBuffers(1, &hullEbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, hullEbo);
+        hullLayout.build();
+        hullLayout.unbind();
+
+        hullOffsets = hulls.offsets;
+        polyhedra = std::move(cellPolyhedra);
+        clusters = std::move(cellClusters);
+        dirty = true;
+    }
+
+    void clearHulls()
+    {
+        if (hullVbo != 0)
+        {
+            glDeleteBuffers(1, &hullVbo);
+            glDeleteBuffers(1, &hullEbo);
+            hullLayout.end();
+        }
+        hullLayout = Layout();
+        hullVbo = hullEbo = 0;
+        hullOffsets.clear();
+        polyhedra.clear();
+        coarseFirsts.clear();
+        coarseCounts.clear();
+        dirty = true;
+    }
+
+    void sync()
     {
+        if (!dirty || cells.empty())
+            return;
+
+        std::vector<glm::vec4> colors(cells.size());
+        selectedCells.clear();
+        transparentCells.clear();
+        for (size_t i = 0; i < cells.size(); i++)
+        {
+            colors[i] = cells[i].color;
+            colors[i].a = 1.0f;
+            if (cells[i].visibility == Model::HIDDEN)
+                colors[i].a = 0.0f;
+            else if (cells[i].visibility == Model::TRANSPARENT)
+                colors[i].a = 0.5f;
+            surface.setVisible(i, colors[i].a == 1.0f);
+            if (cells[i].visibility == Model::SELECTED)
+                selectedCells.push_back(i);
+            else if (cells[i].visibility == Model::TRANSPARENT)
+                transparentCells.push_back(i);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, colorBuffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, colors.size() * sizeof(glm::vec4), colors.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        // A side of the surface is the face starting at vertex 3 * side of the cell buffer, sides are sorted by
+        // cluster with a counting sort
+        const int clusterCount = clusters.size();
+        clusterCounts.assign(clusterCount, 0);
+        for (int side : surface.sides())
+            clusterCounts[clusters.clusterOf(side / 4)] += 3;
+        clusterFirsts.assign(clusterCount, 0);
+        for (int c = 1; c < clusterCount; c++)
+            clusterFirsts[c] = clusterFirsts[c - 1] + clusterCounts[c - 1];
+        std::vector<unsigned int> indices(surface.sides().size() * 3);
+        std::vector<GLsizei> cursor = clusterFirsts;
+        for (int side : surface.sides())
+        {
+            GLsizei &at = cursor[clusters.clusterOf(side / 4)];
+            for (int j = 0; j < 3; j++)
+                indices[at++] = 3 * side + j;
+        }
+        layout.bind();
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_DYNAMIC_DRAW);
+        layout.unbind();
+        surfaceCount = indices.size();
+        syncHulls();
+        dirty = false;
     }
 
+    // The hulls of the polyhedra on the surface of every cluster whose cells are all opaque
+    void syncHulls()
+    {
+        coarseFirsts.assign(clusters.size(), 0);
+        coarseCounts.assign(clusters.size(), 0);
+        if (hullOffsets.empty())
+            return;
+
+        std::vector<char> opaque(clusters.size(), 1);
+        for (size_t i = 0; i < cells.size(); i++)
+        {
+            if (cells[i].visibility == Model::HIDDEN || cells[i].visibility == Model::TRANSPARENT)
+                opaque[clusters.clusterOf(i)] = 0;
+        }
+        // Polyhedra are never split between clusters, so each is listed once
+        std::vector<std::vector<int>> shown(clusters.size());
+        std::vector<char> listed(hullOffsets.size() - 1, 0);
+        for (int side : surface.sides())
+        {
+            const int pi = polyhedra[side / 4];
+            if (!listed[pi])
+            {
+                listed[pi] = 1;
+                shown[clusters.clusterOf(side / 4)].push_back(pi);
+            }
+        }
+
+        std::vector<unsigned int> indices;
+        for (int c = 0; c < clusters.size(); c++)
+        {
+            GLsizei count = 0;
+            for (int pi : shown[c])
+                count += hullOffsets[pi + 1] - hullOffsets[pi];
+            if (!opaque[c] || count == 0 || count >= clusterCounts[c])
+                continue;
+            coarseFirsts[c] = indices.size();
+            coarseCounts[c] = count;
+            for (int pi : shown[c])
+            {
+                for (int k = hullOffsets[pi]; k < hullOffsets[pi + 1]; k++)
+                    indices.push_back(k);
+            }
+        }
+        hullLayout.bind();
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_DYNAMIC_DRAW);
+        hullLayout.unbind();
+    }
+
+    // Keeps what is in the view for this frame. A cluster is drawn coarse when its size over its distance to the
+    // eye, about the angle it spans, is under coarseAngle.
+    void cull(const glm::mat4 &viewProjection, const glm::vec3 &eye, bool frustumCulling, float coarseAngle)
+    {
+        detailRanges.clear();
+        coarseRanges.clear();
+        selectedRanges.clear();
+        transparentRanges.clear();
+        const Polylla::Frustum frustum = Polylla::Frustum::fromMatrix(glm::value_ptr(viewProjection));
+
+        std::vector<int> kept;
+        if (frustumCulling)
+        {
+            kept = clusters.visible(frustum);
+        }
+        else
+        {
+            kept.resize(clusters.size());
+            std::iota(kept.begin(), kept.end(), 0);
+        }
+        for (int c : kept)
+        {
+            const Polylla::Box3 &box = clusters.box(c);
+            const float size = box.sizes().norm();
+            if (coarseCounts[c] > 0 && size < coarseAngle * glm::distance(toVec3(box.center()), eye))
+                coarseRanges.add(coarseFirsts[c], coarseCounts[c]);
+            else if (clusterCounts[c] > 0)
+                detailRanges.add(clusterFirsts[c], clusterCounts[c]);
+        }
+
+        auto keep = [&](const std::vector<int> &from, DrawRanges &ranges) {
+            for (int ti : from)
+            {
+                if (!frustumCulling || frustum.intersects(cells[ti].collider.box()))
+                    ranges.add(Polylla::CellBuffer::first(ti), Polylla::CellBuffer::VERTICES_PER_CELL);
+            }
+        };
+        keep(selectedCells, selectedRanges);
+        keep(transparentCells, transparentRanges);
+    }
+
+    // Binds the cell colors for the mesh shader's cellColors sampler
+    void bind(Shader &shader)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, colorTexture);
+        shader.set("cellColors", 0);
+    }
+
+    // Draws the surface of the opaque cells kept by cull()
     void draw()
     {
+        if (!detailRanges.counts.empty())
+        {
+            layout.bind();
+            glMultiDrawElements(GL_TRIANGLES, detailRanges.counts.data(), GL_UNSIGNED_INT, detailRanges.offsets.data(),
+                                detailRanges.counts.size());
+            layout.unbind();
+        }
+        if (!coarseRanges.counts.empty())
+        {
+            hullLayout.bind();
+            glMultiDrawElements(GL_TRIANGLES, coarseRanges.counts.data(), GL_UNSIGNED_INT, coarseRanges.offsets.data(),
+                                coarseRanges.counts.size());
+            hullLayout.unbind();
+        }
+    }
+
+    // Draws the selected or transparent cells kept by cull(), one range per cell in a single call
+    void draw(Model::Visibility visibility)
+    {
+        const DrawRanges &ranges = visibility == Model::SELECTED ? selectedRanges : transparentRanges;
+        if ((visibility != Model::SELECTED && visibility != Model::TRANSPARENT) || ranges.firsts.empty())
+            return;
+
+        layout.bind();
+        glMultiDrawArrays(GL_TRIANGLES, ranges.firsts.data(), ranges.counts.data(), ranges.firsts.size());
+        layout.unbind();
     }
 
     void end()
     {
-        for (auto &buffer : buffers)
+        if (vbo != 0)
         {
-            buffer->end();
+            glDeleteBuffers(1, &vbo);
+            glDeleteBuffers(1, &ebo);
+            glDeleteBuffers(1, &colorBuffer);
+            glDeleteTextures(1, &colorTexture);
+            layout.end();
         }
-
-        buffers.clear();
+        layout = Layout();
+        vbo = ebo = colorBuffer = colorTexture = 0;
+        surface = Polylla::VisibleSurface();
+        surfaceCount = 0;
         cells.clear();
+        clearHulls();
+        clusters = Polylla::CellClusters();
+        clusterFirsts.clear();
+        clusterCounts.clear();
+        selectedCells.clear();
+        transparentCells.clear();
+        for (DrawRanges *ranges : {&detailRanges, &coarseRanges, &selectedRanges, &transparentRanges})
+            ranges->clear();
     }
 };
 
@@ -591,8 +924,14 @@ struct RenderSettings
 {
     bool faceCulling = true;
     bool wireframe = false;
+    bool frustumCulling = true;
+    bool levelOfDetail = true;
+    // Angular size in radians under which a cluster of polyhedra is drawn with their hulls
+    float coarseAngle = 0.05f;
     bool showGrid = true;
     bool showLightSphere = true;
+    bool showSpheres = false;
+    float sphereAlpha = 0.2f;
 };
 
 struct Ray
@@ -750,6 +1089,7 @@ static struct State
     std::unordered_map<std::string, Shader> shaders;
     std::unordered_map<std::string, Model> models;
     VolumeMesh mesh;
+    CavitySpheres spheres;
 
 } state;
 
@@ -818,6 +1158,23 @@ void init()
     std::string phongFragmentShaderSource(std::istreambuf_iterator<char>(phongFragmentShaderFile), {});
     state.shaders["phong"].init(phongVertexShaderSource.c_str(), phongFragmentShaderSource.c_str());
 
+    // Load volume mesh shader from files
+    state.shaders["mesh"] = Shader();
+    std::ifstream meshVertexShaderFile("shaders/mesh.vs");
+    std::ifstream meshFragmentShaderFile("shaders/mesh.fs");
+    std::string meshVertexShaderSource(std::istreambuf_iterator<char>(meshVertexShaderFile), {});
+    std::string meshFragmentShaderSource(std::istreambuf_iterator<char>(meshFragmentShaderFile), {});
+    state.shaders["mesh"].init(meshVertexShaderSource.c_str(), meshFragmentShaderSource.c_str());
+
+    // Load circumsphere shader from files
+    state.shaders["spheres"] = Shader();
+    std::ifstream spheresVertexShaderFile("shaders/spheres.vs");
+    std::ifstream spheresFragmentShaderFile("shaders/spheres.fs");
+    std::string spheresVertexShaderSource(std::istreambuf_iterator<char>(spheresVertexShaderFile), {});
+    std::string spheresFragmentShaderSource(std::istreambuf_iterator<char>(spheresFragmentShaderFile), {});
+    state.shaders["spheres"].init(spheresVertexShaderSource.c_str(), spheresFragmentShaderSource.c_str());
+    state.spheres.init();
+
     initializeGrid(state.shaders["grid"]);
 
     // Initialize light sphere
@@ -883,88 +1240,66 @@ void render()
 
     // Render the mesh with Phong lighting (will appear in front of grid)
     glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    state.shaders["phong"].use();
+    state.mesh.sync();
+    state.mesh.cull(state.frame.projection() * state.camera.view(), state.camera.position,
+                    state.renderSettings.frustumCulling,
+                    state.renderSettings.levelOfDetail ? state.renderSettings.coarseAngle : 0.0f);
+    Shader &meshShader = state.shaders["mesh"];
+    meshShader.use();
+    state.mesh.bind(meshShader);
+    meshShader.set("model", glm::mat4(1.0f));
+    meshShader.set("flatColor", 0);
+    meshShader.set("opaqueOnly", 0);
 
     // Set up global Phong lighting uniforms
     // Material properties
-    state.shaders["phong"].set("ambientStrength", 0.3f);
-    state.shaders["phong"].set("diffuseStrength", 1.0f);
-    state.shaders["phong"].set("specularStrength", 0.5f);
-    state.shaders["phong"].set("shininess", 32.0f);
+    meshShader.set("ambientStrength", 0.3f);
+    meshShader.set("diffuseStrength", 1.0f);
+    meshShader.set("specularStrength", 0.5f);
+    meshShader.set("shininess", 32.0f);
 
     // Light properties from state
-    state.shaders["phong"].set("lightPos", state.light.position);
-    state.shaders["phong"].set("lightColor", state.light.color * state.light.intensity);
-    state.shaders["phong"].set("viewPos", state.camera.position);
+    meshShader.set("lightPos", state.light.position);
+    meshShader.set("lightColor", state.light.color * state.light.intensity);
+    meshShader.set("viewPos", state.camera.position);
 
     // First render the selected cell to stencil buffer
     glStencilFunc(GL_ALWAYS, 1, 0xFF);
     glStencilMask(0xFF);
     glDisable(GL_DEPTH_TEST);
-    for (auto &cell : state.mesh.cells)
-    {
-        if (cell.visibility == Model::SELECTED)
-        {
-            state.shaders["phong"].use();
-            state.shaders["phong"].set("model", cell.model);
-            state.shaders["phong"].set("materialColor", cell.color);
-            cell.buffer->draw();
-        }
-    }
+    state.mesh.draw(Model::SELECTED);
 
     glEnable(GL_DEPTH_TEST);
     glStencilMask(0x00);
-    for (auto &cell : state.mesh.cells)
-    {
-        if (cell.visibility == Model::HIDDEN)
-            continue;
-
-        cell.color.a = 1.0f;
-        if (cell.visibility == Model::TRANSPARENT)
-            cell.color.a = 0.5f;
-
-        state.shaders["phong"].use();
-        state.shaders["phong"].set("model", cell.model);
-        state.shaders["phong"].set("materialColor", cell.color);
-        cell.buffer->draw();
-    }
+    state.mesh.draw();
+    state.mesh.draw(Model::TRANSPARENT);
 
     if (state.renderSettings.wireframe)
     {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
         glLineWidth(1.0f);
-        for (auto &cell : state.mesh.cells)
-        {
-            if (cell.visibility == Model::HIDDEN || cell.visibility == Model::TRANSPARENT)
-                continue;
-
-            state.shaders["basic"].use();
-            state.shaders["basic"].set("model", cell.model);
-            state.shaders["basic"].set("materialColor", glm::vec3(0.0f, 0.0f, 0.0f));
-            cell.buffer->draw();
-        }
+        meshShader.set("flatColor", 1);
+        meshShader.set("opaqueOnly", 1);
+        meshShader.set("materialColor", glm::vec3(0.0f, 0.0f, 0.0f));
+        state.mesh.draw();
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     }
 
-    // Then render the outline using the basic shader
+    // Then render the outline in a flat color
     glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
     glDisable(GL_DEPTH_TEST);
-    for (auto &cell : state.mesh.cells)
     {
-        if (cell.visibility == Model::SELECTED)
-        {
-            state.shaders["basic"].use();
-
-            // Create scaling matrix from tetrahedron center
-            glm::mat4 translateToOrigin = glm::translate(glm::mat4(1.0f), -state.selectedCellCenter);
-            glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(1.05f)); // 5% larger
-            glm::mat4 translateBack = glm::translate(glm::mat4(1.0f), state.selectedCellCenter);
-            glm::mat4 scaledModel = translateBack * scale * translateToOrigin * cell.model;
+        // Create scaling matrix from tetrahedron center
+        glm::mat4 translateToOrigin = glm::translate(glm::mat4(1.0f), -state.selectedCellCenter);
+        glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(1.05f)); // 5% larger
+        glm::mat4 translateBack = glm::translate(glm::mat4(1.0f), state.selectedCellCenter);
+        glm::mat4 scaledModel = translateBack * scale * translateToOrigin;
 
-            state.shaders["basic"].set("model", scaledModel);
-            state.shaders["basic"].set("materialColor", glm::vec3(1.0f, 1.0f, 1.0f));
-            cell.buffer->draw();
-        }
+        meshShader.set("model", scaledModel);
+        meshShader.set("flatColor", 1);
+        meshShader.set("opaqueOnly", 0);
+        meshShader.set("materialColor", glm::vec3(1.0f, 1.0f, 1.0f));
+        state.mesh.draw(Model::SELECTED);
     }
 
     // Restore stencil and depth state
@@ -974,6 +1309,25 @@ void render()
     // state.mesh.draw();
     // }
 
+    // Circumspheres over the mesh, translucent and without writing depth so those behind are not hidden
+    if (state.renderSettings.showSpheres)
+    {
+        Shader &spheresShader = state.shaders["spheres"];
+        spheresShader.use();
+        spheresShader.set("ambientStrength", 0.3f);
+        spheresShader.set("diffuseStrength", 1.0f);
+        spheresShader.set("specularStrength", 0.5f);
+        spheresShader.set("shininess", 32.0f);
+        spheresShader.set("materialColor", glm::vec3(0.3f, 0.6f, 1.0f));
+        spheresShader.set("alpha", state.renderSettings.sphereAlpha);
+        spheresShader.set("lightPos", state.light.position);
+        spheresShader.set("lightColor", state.light.color * state.light.intensity);
+        spheresShader.set("viewPos", state.camera.position);
+        glDepthMask(GL_FALSE);
+        state.spheres.draw();
+        glDepthMask(GL_TRUE);
+    }
+
     // Render light sphere at light position (if enabled)
     if (state.renderSettings.showLightSphere)
     {
@@ -981,6 +1335,7 @@ void render()
         state.models["lightSphere"].model = glm::translate(state.models["lightSphere"].model, state.light.position);
 
         // Set light sphere material to emit light color
+        state.shaders["phong"].use();
         state.shaders["phong"].set("materialColor", state.light.color);
         state.shaders["phong"].set("ambientStrength", 1.0f);  // Make it fully bright
         state.shaders["phong"].set("diffuseStrength", 0.0f);  // No diffuse
@@ -990,159 +1345,6 @@ void render()
     state.frame.unbind();
 }
 
-// Helper function to convert HSV to RGB color space
-glm::vec4 hsvToRgb(float h, float s, float v)
-{
-    float c = v * s;
-    float x = c * (1.0f - fabs(fmod(h / 60.0f, 2.0f) - 1.0f));
-    float m = v - c;
-
-    float r, g, b;
-    if (h >= 0 && h < 60)
-    {
-        r = c;
-        g = x;
-        b = 0;
-    }
-    else if (h >= 60 && h < 120)
-    {
-        r = x;
-        g = c;
-        b = 0;
-    }
-    else if (h >= 120 && h < 180)
-    {
-        r = 0;
-        g = c;
-        b = x;
-    }
-    else if (h >= 180 && h < 240)
-    {
-        r = 0;
-        g = x;
-        b = c;
-    }
-    else if (h >= 240 && h < 300)
-    {
-        r = x;
-        g = 0;
-        b = c;
-    }
-    else
-    {
-        r = c;
-        g = 0;
-        b = x;
-    }
-
-    return glm::vec4(r + m, g + m, b + m, 1.0f);
-}
-
-// Test if point is inside tetrahedron using barycentric coordinates
-bool pointInTetrahedron(const glm::vec3 &point, const glm::vec3 &v0, const glm::vec3 &v1, const glm::vec3 &v2,
-                        const glm::vec3 &v3)
-{
-    glm::mat4 M(glm::vec4(v0, 1.0f), glm::vec4(v1, 1.0f), glm::vec4(v2, 1.0f), glm::vec4(v3, 1.0f));
-
-    float det = glm::determinant(M);
-    if (abs(det) < 1e-6f)
-        return false; // Degenerate tetrahedron
-
-    // Calculate barycentric coordinates
-    glm::mat4 M0 = M;
-    M0[0] = glm::vec4(point, 1.0f);
-    float lambda0 = glm::determinant(M0) / det;
-
-    glm::mat4 M1 = M;
-    M1[1] = glm::vec4(point, 1.0f);
-    float lambda1 = glm::determinant(M1) / det;
-
-    glm::mat4 M2 = M;
-    M2[2] = glm::vec4(point, 1.0f);
-    float lambda2 = glm::determinant(M2) / det;
-
-    glm::mat4 M3 = M;
-    M3[3] = glm::vec4(point, 1.0f);
-    float lambda3 = glm::determinant(M3) / det;
-
-    const float tolerance = -1e-6f; // Small negative tolerance for numerical stability
-    return (lambda0 >= tolerance && lambda1 >= tolerance && lambda2 >= tolerance && lambda3 >= tolerance);
-}
-
-// Test ray-tetrahedron intersection and return distance to closest intersection
-bool rayIntersectsTetrahedron(const Ray &ray, const Polylla::Tetrahedron &cell, const Polylla::Mesh &mesh,
-                              float &closestDistance)
-{
-    // Safety checks
-    if (cell.vertices.size() != 4)
-        return false;
-
-    // Get tetrahedron vertices
-    std::vector<glm::vec3> vertices;
-    for (int vi : cell.vertices)
-    {
-        if (vi < 0 || vi >= mesh.vertices.size())
-            return false; // Invalid vertex index
-
-        const auto &v = mesh.vertices[vi];
-        vertices.push_back(glm::vec3(v.x(), v.y(), v.z()));
-    }
-
-    if (vertices.size() != 4)
-        return false;
-
-    glm::vec3 v0 = vertices[0];
-    glm::vec3 v1 = vertices[1];
-    glm::vec3 v2 = vertices[2];
-    glm::vec3 v3 = vertices[3];
-
-    // Test multiple points along the ray to find the closest intersection
-    const float maxDistance = 100.0f;
-    const int samples = 200;
-
-    closestDistance = maxDistance + 1.0f; // Initialize to beyond max range
-    bool found = false;
-
-    for (int i = 0; i < samples; i++)
-    {
-        float t = (float)i / (samples - 1) * maxDistance;
-        glm::vec3 point = ray.origin + t * ray.direction;
-
-        if (pointInTetrahedron(point, v0, v1, v2, v3))
-        {
-            closestDistance = t;
-            found = true;
-            break; // Found first intersection, which is closest due to sequential sampling
-        }
-    }
-
-    return found;
-}
-
-// Find the closest cell that intersects with the ray
-int findIntersectedCell(const Ray &ray, const Polylla::Mesh &mesh)
-{
-    if (mesh.tetras.empty())
-        return -1;
-
-    int closestCellIndex = -1;
-    float closestDistance = FLT_MAX;
-
-    for (size_t i = 0; i < mesh.tetras.size(); i++)
-    {
-        const auto intersection = ray.intersect(mesh.tetras[i], mesh);
-        if (intersection)
-        {
-            if (glm::length(intersection.value() - ray.origin) < closestDistance)
-            {
-                closestDistance = glm::length(intersection.value() - ray.origin);
-                closestCellIndex = (int)i;
-            }
-        }
-    }
-    return closestCellIndex;
-}
-
 } // namespace render
 
 namespace app
@@ -1156,6 +1358,16 @@ struct Controller
     double lastMouseY = 0.0;
 };
 
+// Work run off the UI thread, such as reading a mesh, the algorithm and the stats. The worker returns what is left
+// to do on the GL thread, uploading buffers and moving its results into the state, which pollJob() runs once it is
+// done. Members are destroyed in reverse, so the worker is waited for before its progress goes.
+struct Job
+{
+    std::string name;
+    Polylla::Progress progress;
+    std::future<std::function<void()>> result;
+};
+
 // Application state
 static struct State
 {
@@ -1165,6 +1377,11 @@ static struct State
     GLFWwindow *window = nullptr;
     Polylla::Mesh mesh;
     Polylla::PolyMesh polyMesh;
+    // Ray picking over the tetrahedra of mesh
+    Polylla::TetraIndex picker;
+    // Running job, one at a time, and the error of the last one that failed
+    std::unique_ptr<Job> job;
+    std::string jobError;
     Polylla::TetgenReader reader;
     Polylla::VisFWriter writer;
     Controller controller;
@@ -1173,6 +1390,11 @@ static struct State
     std::mt19937 gen;
     bool transformed = false;
     std::vector<int> owners;
+    // Circumsphere of every tetrahedron, the radius range drawn and whether only those of the selected polyhedron
+    std::vector<Polylla::CavityAlgorithm::Cavity> cavities;
+    float maxRadius = 0.0f;
+    float sphereRadii[2] = {0.0f, 0.0f};
+    bool spheresOfSelection = false;
     bool showTetras = false;
     std::vector<Polylla::PolyStat> stats;
     int loners;
@@ -1271,6 +1493,7 @@ static void mouse_button_callback(GLFWwindow *window, int button, int action, in
                 {
                     render::state.mesh.cells[render::state.selectedCellIndex].visibility = render::Model::VISIBLE;
                 }
+                render::state.mesh.dirty = true;
             }
 
             // Map to framebuffer coordinates
@@ -1285,8 +1508,11 @@ static void mouse_button_callback(GLFWwindow *window, int button, int action, in
             if (!app::state.mesh.tetras.empty() && !app::state.mesh.vertices.empty())
             {
 
-                // Find intersected cell
-                int cellIndex = render::findIntersectedCell(ray, app::state.mesh);
+                // Find intersected cell, hidden cells let the ray through
+                auto visible = [](int ti) { return render::state.mesh.cells[ti].visibility != render::Model::HIDDEN; };
+                Polylla::Vector3 origin(ray.origin.x, ray.origin.y, ray.origin.z);
+                Polylla::Vector3 direction(ray.direction.x, ray.direction.y, ray.direction.z);
+                int cellIndex = app::state.picker.pick(origin, direction, visible).tetra;
 
                 if (cellIndex >= 0)
                 {
@@ -1309,6 +1535,7 @@ static void mouse_button_callback(GLFWwindow *window, int button, int action, in
                         render::state.selectedCellCenter = render::state.mesh.cells[cellIndex].center;
                     }
                     render::state.selectedCellIndex = cellIndex;
+                    render::state.mesh.dirty = true;
                 }
             }
         }
@@ -1333,7 +1560,6 @@ void computeStats()
     int kernels = 0;
     state.kernelRatio = 0;
     std::unordered_set<int> used;
-    state.stats = Polylla::computeStats(state.polyMesh);
     for (int i = 0; i < state.polyMesh.cells.size(); i++)
     {
         const auto &poly = state.polyMesh.cells[i];
@@ -1372,83 +1598,97 @@ void paintMesh()
     std::uniform_real_distribution<float> hueDistribution(0.0f, 360.0f);
     for (size_t i = 0; i < state.mesh.tetras.size(); i++)
     {
-        float hue = hueDistribution(state.gen);
-        float saturation = 0.8f; // High saturation for vibrant colors
-        float value = 0.8f;      // High value for bright colors
-        glm::vec4 color = render::hsvToRgb(hue, saturation, value);
+        // Same colors as the snapshots of the library
+        auto rgb = Polylla::cellColor(hueDistribution(state.gen));
+        glm::vec4 color = glm::vec4(rgb[0], rgb[1], rgb[2], 1.0f);
         if (state.transformed)
         {
             color = render::state.mesh.cells[state.owners[i]].color;
         }
         render::state.mesh.cells[i].color = color;
     }
+    render::state.mesh.dirty = true;
 }
 
 void highlightCell(int cellIndex, glm::vec3 color)
 {
 }
 
-void loadMesh(const std::string &meshName)
+bool busy()
 {
-    state.transformed = false;
-    std::string meshPath = DATA_DIR + meshName;
-    state.reader.nodeFile = meshPath + ".node";
-    state.reader.eleFile = meshPath + ".ele";
-    Polylla::Mesh mesh = state.reader.readMesh();
-
-    app::state.mesh = mesh;
-
-    // Clear existing render mesh data
-    render::state.mesh.end();
+    return state.job != nullptr;
+}
 
-    glm::vec3 minBounds(FLT_MAX);
-    glm::vec3 maxBounds(-FLT_MAX);
+// Runs work(progress) on a worker thread, unless a job is already running
+template <typename Work> void startJob(const std::string &name, Work work)
+{
+    if (busy())
+        return;
+    state.jobError.clear();
+    state.job = std::make_unique<Job>();
+    state.job->name = name;
+    Job *job = state.job.get();
+    job->result = std::async(std::launch::async, [job, work] { return work(job->progress); });
+}
 
-    for (size_t cellIndex = 0; cellIndex < mesh.tetras.size(); cellIndex++)
+// Called every frame, finishes the job on the GL thread once its worker is done
+void pollJob()
+{
+    if (!busy() || state.job->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+    try
     {
-        const auto &cell = mesh.tetras.at(cellIndex);
-
-        auto buffer = std::make_unique<render::PhongCellBuffer>();
-        buffer->init(cell, mesh);
+        auto finish = state.job->result.get();
+        finish();
+    }
+    catch (const Polylla::CancelledError &)
+    {
+        // Nothing was changed, the state is as before the job
+    }
+    catch (const std::exception &e)
+    {
+        state.jobError = state.job->name + ": " + e.what();
+    }
+    state.job.reset();
+}
 
-        // Generate a unique color for each cell using HSV color space
+void cancelJob()
+{
+    if (busy())
+        state.job->progress.cancel();
+}
 
-        auto model = render::Model();
-        model.buffer = buffer.get(); // Get pointer before moving
-        model.shader = &render::state.shaders["phong"];
-        model.outlinedShader = &render::state.shaders["basic"];
+// What the worker of loadMesh prepares for the GL thread
+struct LoadedMesh
+{
+    std::string path;
+    Polylla::Mesh mesh;
+    Polylla::CellBuffer buffer;
+    std::vector<render::Model> cells;
+    Polylla::CellClusters clusters;
+    glm::vec3 minBounds = glm::vec3(FLT_MAX);
+    glm::vec3 maxBounds = glm::vec3(-FLT_MAX);
+};
 
-        // calculates center and bounds
-        glm::vec3 center = glm::vec3(0.0f, 0.0f, 0.0f);
-        glm::vec3 min = glm::vec3(FLT_MAX);
-        glm::vec3 max = glm::vec3(-FLT_MAX);
-        for (const auto &vi : cell.vertices)
-        {
-            const auto &vertex = mesh.vertices.at(vi);
-            auto v = toVec3(vertex);
-            center += v;
-            min = glm::min(min, v);
-            max = glm::max(max, v);
-        }
-        center /= cell.vertices.size();
-        model.center = center;
-        model.collider.min = min;
-        model.collider.max = max;
+void showMesh(LoadedMesh &loaded)
+{
+    state.transformed = false;
+    render::state.renderSettings.showSpheres = false;
+    state.reader.nodeFile = loaded.path + ".node";
+    state.reader.eleFile = loaded.path + ".ele";
+    app::state.mesh = std::move(loaded.mesh);
+    app::state.picker = Polylla::TetraIndex(app::state.mesh);
+    render::state.selectedCellIndex = -1;
 
-        render::state.mesh.buffers.push_back(std::move(buffer)); // Move after getting pointer
-        render::state.mesh.cells.push_back(model);
-    }
-    for (const auto &vertex : mesh.vertices)
-    {
-        glm::vec3 pos(vertex.x(), vertex.y(), vertex.z());
-        minBounds = glm::min(minBounds, pos);
-        maxBounds = glm::max(maxBounds, pos);
-    }
+    // Clear existing render mesh data
+    render::state.mesh.end();
+    render::state.mesh.init(loaded.buffer, app::state.mesh, std::move(loaded.clusters));
+    render::state.mesh.cells = std::move(loaded.cells);
 
-    render::state.camera.target = (minBounds + maxBounds) * 0.5f;
+    render::state.camera.target = (loaded.minBounds + loaded.maxBounds) * 0.5f;
 
     // Set initial distance based on mesh size
-    glm::vec3 size = maxBounds - minBounds;
+    glm::vec3 size = loaded.maxBounds - loaded.minBounds;
     float meshSize = glm::length(size);
     render::state.camera.distance = meshSize * 1.5f; // Start at 1.5x the mesh size
 
@@ -1459,6 +1699,113 @@ void loadMesh(const std::string &meshName)
     paintMesh();
 }
 
+// Reads the mesh and builds its buffers on a worker, the GL thread only uploads them
+void loadMesh(const std::string &meshName)
+{
+    std::string meshPath = DATA_DIR + meshName;
+    startJob("Loading " + meshName, [meshPath](Polylla::Progress &progress) -> std::function<void()> {
+        auto loaded = std::make_shared<LoadedMesh>();
+        loaded->path = meshPath;
+        Polylla::TetgenReader reader;
+        reader.nodeFile = meshPath + ".node";
+        reader.eleFile = meshPath + ".ele";
+        reader.context.progress = &progress;
+        loaded->mesh = reader.readMesh();
+        const Polylla::Mesh &mesh = loaded->mesh;
+
+        progress.phase("buffers");
+        loaded->buffer = Polylla::buildCellBuffer(mesh);
+        for (size_t cellIndex = 0; cellIndex < mesh.tetras.size(); cellIndex++)
+        {
+            const auto &cell = mesh.tetras.at(cellIndex);
+
+            auto model = render::Model();
+
+            // calculates center and bounds
+            glm::vec3 center = glm::vec3(0.0f, 0.0f, 0.0f);
+            glm::vec3 min = glm::vec3(FLT_MAX);
+            glm::vec3 max = glm::vec3(-FLT_MAX);
+            for (const auto &vi : cell.vertices)
+            {
+                const auto &vertex = mesh.vertices.at(vi);
+                auto v = toVec3(vertex);
+                center += v;
+                min = glm::min(min, v);
+                max = glm::max(max, v);
+            }
+            center /= cell.vertices.size();
+            model.center = center;
+            model.collider.min = min;
+            model.collider.max = max;
+
+            loaded->cells.push_back(model);
+            if (cellIndex % 4096 == 0)
+                progress.report(static_cast<double>(cellIndex) / mesh.tetras.size());
+        }
+        for (const auto &vertex : mesh.vertices)
+        {
+            glm::vec3 pos(vertex.x(), vertex.y(), vertex.z());
+            loaded->minBounds = glm::min(loaded->minBounds, pos);
+            loaded->maxBounds = glm::max(loaded->maxBounds, pos);
+        }
+
+        progress.phase("clusters");
+        std::vector<Polylla::Box3> boxes(loaded->cells.size());
+        for (size_t i = 0; i < boxes.size(); i++)
+            boxes[i] = loaded->cells[i].collider.box();
+        loaded->clusters = Polylla::CellClusters(boxes);
+        progress.report(1);
+        return [loaded] { showMesh(*loaded); };
+    });
+}
+
+// Runs the algorithm and its stats on a worker, over the mesh shown. Loading is disabled meanwhile, so the mesh
+// does not change under it.
+void transformMesh()
+{
+    startJob("Cavity algorithm", [](Polylla::Progress &progress) -> std::function<void()> {
+        Polylla::CavityAlgorithm worker;
+        worker.context.progress = &progress;
+        auto polyMesh = std::make_shared<Polylla::PolyMesh>(worker(state.mesh));
+        auto owners = std::make_shared<std::vector<int>>(worker.owners());
+        auto cavities = std::make_shared<std::vector<Polylla::CavityAlgorithm::Cavity>>(worker.cavities());
+        auto stats = std::make_shared<std::vector<Polylla::PolyStat>>(Polylla::computeStats(*polyMesh, worker.context));
+
+        // The hulls drawn for distant polyhedra, reusing those of the stats, and clusters that keep the
+        // tetrahedra of a polyhedron together. Colliders do not change while a job runs.
+        progress.phase("hulls");
+        auto hulls = std::make_shared<Polylla::HullBuffer>(Polylla::buildHullBuffer(*polyMesh, *stats));
+        auto polyhedra = std::make_shared<std::vector<int>>(polyMesh->tetras.size());
+        std::vector<Polylla::Box3> boxes(polyMesh->tetras.size());
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            (*polyhedra)[i] = polyMesh->tetras[i].polyhedron;
+            boxes[i] = render::state.mesh.cells[i].collider.box();
+        }
+        auto clusters = std::make_shared<Polylla::CellClusters>(boxes, *polyhedra);
+        progress.report(1);
+        return [polyMesh, owners, cavities, stats, hulls, polyhedra, clusters] {
+            render::state.mesh.setHulls(*hulls, std::move(*polyhedra), std::move(*clusters));
+            state.polyMesh = std::move(*polyMesh);
+            state.owners = std::move(*owners);
+            state.cavities = std::move(*cavities);
+            state.maxRadius = 0.0f;
+            for (const auto &cavity : state.cavities)
+            {
+                if (std::isfinite(cavity.radius))
+                    state.maxRadius = std::max(state.maxRadius, static_cast<float>(cavity.radius));
+            }
+            state.sphereRadii[0] = 0.0f;
+            state.sphereRadii[1] = state.maxRadius;
+            render::state.spheres.dirty = true;
+            state.stats = std::move(*stats);
+            paintMesh();
+            computeStats();
+            state.transformed = true;
+        };
+    });
+}
+
 void drawMenuBar()
 {
     if (ImGui::BeginMenuBar())
@@ -1468,7 +1815,7 @@ void drawMenuBar()
         {
             for (int i = 0; i < app::state.meshes.size(); i++)
             {
-                if (ImGui::MenuItem(app::state.meshes[i].c_str()))
+                if (ImGui::MenuItem(app::state.meshes[i].c_str(), nullptr, false, !busy()))
                 {
                     app::state.currentMesh = i;
                     loadMesh(app::state.meshes[i]);
@@ -1550,6 +1897,21 @@ void drawSidebar()
     // Fixed width sidebar with padding
     ImGui::BeginChild("Sidebar", ImVec2(0, 0));
 
+    if (busy())
+    {
+        std::string phase = state.job->progress.currentPhase();
+        ImGui::Text("%s", state.job->name.c_str());
+        ImGui::ProgressBar(state.job->progress.fraction(), ImVec2(-FLT_MIN, 0), phase.c_str());
+        if (ImGui::Button("Cancel"))
+            cancelJob();
+        ImGui::Separator();
+    }
+    else if (!state.jobError.empty())
+    {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", state.jobError.c_str());
+        ImGui::Separator();
+    }
+
     // Tab bar
     if (ImGui::BeginTabBar("SidebarTabs", ImGuiTabBarFlags_None))
     {
@@ -1646,24 +2008,25 @@ void drawSidebar()
 
             if (algorithm == 0)
             {
+                ImGui::BeginDisabled(busy());
                 if (ImGui::Button("Start"))
                 {
-                    Polylla::CavityAlgorithm worker;
-                    state.polyMesh = worker(state.mesh);
-                    state.owners = worker.owners();
-                    paintMesh();
-                    computeStats();
-                    state.transformed = true;
+                    transformMesh();
                 }
+                ImGui::EndDisabled();
                 if (ImGui::Button(state.showTetras ? "Hide Tetras" : "Show Tetras"))
                 {
                     state.showTetras = !state.showTetras;
                 }
+                ImGui::BeginDisabled(busy());
                 if (ImGui::Button("Reset"))
                 {
                     state.transformed = false;
+                    render::state.mesh.clearHulls();
+                    render::state.renderSettings.showSpheres = false;
                     paintMesh();
                 }
+                ImGui::EndDisabled();
             }
             else
             {
@@ -1671,6 +2034,27 @@ void drawSidebar()
             }
             if (state.transformed)
             {
+                ImGui::Spacing();
+                ImGui::Text("Cavities");
+                ImGui::Separator();
+                ImGui::Checkbox("Show Circumspheres", &render::state.renderSettings.showSpheres);
+                if (render::state.renderSettings.showSpheres)
+                {
+                    ImGui::DragFloatRange2("Radius", &state.sphereRadii[0], &state.sphereRadii[1],
+                                           state.maxRadius / 200.0f, 0.0f, state.maxRadius, "%.3f");
+                    ImGui::Checkbox("Only the selected polyhedron", &state.spheresOfSelection);
+                    ImGui::SliderFloat("Opacity", &render::state.renderSettings.sphereAlpha, 0.05f, 1.0f);
+
+                    // Refilled only when the filter changes, the selection included
+                    Polylla::SphereFilter filter;
+                    filter.minRadius = state.sphereRadii[0];
+                    filter.maxRadius = state.sphereRadii[1];
+                    if (state.spheresOfSelection && render::state.selectedCellIndex != -1)
+                        filter.owner = state.owners[render::state.selectedCellIndex];
+                    render::state.spheres.update(state.cavities, state.owners, filter);
+                    ImGui::Text("%zu spheres", render::state.spheres.instances.size());
+                }
+
                 ImGui::Spacing();
                 ImGui::Text("Statistics");
                 ImGui::Separator();
@@ -1786,6 +2170,27 @@ void drawSidebar()
                 ImGui::EndTooltip();
             }
 
+            // Culling and level of detail
+            ImGui::Checkbox("Frustum Culling", &render::state.renderSettings.frustumCulling);
+            ImGui::Checkbox("Level of Detail", &render::state.renderSettings.levelOfDetail);
+            ImGui::SameLine();
+            ImGui::TextDisabled("(?)");
+            if (ImGui::IsItemHovered())
+            {
+                ImGui::BeginTooltip();
+                ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+                ImGui::TextUnformatted("Draw distant polyhedra with their convex hulls, once the mesh is transformed");
+                ImGui::PopTextWrapPos();
+                ImGui::EndTooltip();
+            }
+            ImGui::BeginDisabled(!render::state.renderSettings.levelOfDetail);
+            ImGui::SliderFloat("Coarse Angle", &render::state.renderSettings.coarseAngle, 0.005f, 0.5f, "%.3f",
+                               ImGuiSliderFlags_Logarithmic);
+            ImGui::EndDisabled();
+            ImGui::Text("Clusters drawn: %zu of %d (%zu coarse)",
+                        render::state.mesh.detailRanges.counts.size() + render::state.mesh.coarseRanges.counts.size(),
+                        render::state.mesh.clusters.size(), render::state.mesh.coarseRanges.counts.size());
+
             // Show grid
             ImGui::Checkbox("Show Grid", &render::state.renderSettings.showGrid);
             ImGui::SameLine();
@@ -1949,6 +2354,8 @@ void init()
 
 void draw()
 {
+    pollJob();
+
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -1976,6 +2383,9 @@ void draw()
 
 void end()
 {
+    // Wait for a running job, its worker may still read the state
+    cancelJob();
+    state.job.reset();
 
     // Cleanup models
     for (auto &model : render::state.models)
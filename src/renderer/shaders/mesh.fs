@@ -0,0 +1,51 @@
+#version 330 core
+in vec3 fragPos;
+in vec3 fragNormal;
+flat in vec4 cellColor;
+
+out vec4 color;
+
+// Material properties
+uniform float ambientStrength;
+uniform float diffuseStrength;
+uniform float specularStrength;
+uniform float shininess;
+// Replaces the shading when flatColor is set, for wireframes and outlines
+uniform bool flatColor;
+uniform vec3 materialColor;
+
+// Light properties
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+
+void main()
+{
+    if (flatColor)
+    {
+        color = vec4(materialColor, 1.0);
+        return;
+    }
+
+    // Normalize the normal vector
+    vec3 norm = normalize(fragNormal);
+
+    // Ambient lighting
+    vec3 ambient = ambientStrength * lightColor;
+
+    // Diffuse lighting
+    vec3 lightDir = normalize(lightPos - fragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diffuseStrength * diff * lightColor;
+
+    // Specular lighting (Phong reflection model)
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = specularStrength * spec * lightColor;
+
+    // Combine all lighting components with the color of the cell
+    vec3 result = (ambient + diffuse + specular) * cellColor.rgb;
+
+    color = vec4(result, cellColor.a);
+}
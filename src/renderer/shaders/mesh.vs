@@ -0,0 +1,37 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in int cell;
+
+// RGBA of every cell, alpha 0 hides the cell
+uniform samplerBuffer cellColors;
+// Skip cells that are not opaque, for the wireframe
+uniform bool opaqueOnly;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 fragPos;
+out vec3 fragNormal;
+flat out vec4 cellColor;
+
+void main()
+{
+    cellColor = texelFetch(cellColors, cell);
+    if (cellColor.a == 0.0 || (opaqueOnly && cellColor.a < 1.0))
+    {
+        // Every vertex of the triangle lands on the same point outside the clip volume, so nothing is drawn
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    // Transform position to world space
+    fragPos = vec3(model * vec4(position, 1.0));
+
+    // Calculate normal matrix in shader (inverse transpose of model matrix)
+    mat3 normalMatrix = mat3(transpose(inverse(model)));
+    fragNormal = normalize(normalMatrix * normal);
+
+    gl_Position = projection * view * vec4(fragPos, 1.0);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+in vec3 fragPos;
+in vec3 fragNormal;
+
+out vec4 color;
+
+// Material properties
+uniform float ambientStrength;
+uniform float diffuseStrength;
+uniform float specularStrength;
+uniform float shininess;
+uniform vec3 materialColor;
+// Translucent, so the mesh and the spheres behind stay visible
+uniform float alpha;
+
+// Light properties
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+
+void main()
+{
+    vec3 norm = normalize(fragNormal);
+
+    vec3 ambient = ambientStrength * lightColor;
+
+    vec3 lightDir = normalize(lightPos - fragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diffuseStrength * diff * lightColor;
+
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = specularStrength * spec * lightColor;
+
+    vec3 result = (ambient + diffuse + specular) * materialColor;
+
+    color = vec4(result, alpha);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+// Center and radius of the sphere, one per instance
+layout (location = 2) in vec4 sphere;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 fragPos;
+out vec3 fragNormal;
+
+void main()
+{
+    // A unit sphere moved and scaled, so its normals stay the same
+    fragPos = sphere.xyz + sphere.w * position;
+    fragNormal = normal;
+
+    gl_Position = projection * view * vec4(fragPos, 1.0);
+}
@@ -0,0 +1,270 @@
+#include "io.h"
+#include <gpolylla/report.h>
+#include <gpolylla/trace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace Polylla;
+using namespace std;
+
+MeasureSummary MeasureSummary::of(const vector<double> &values, int bins)
+{
+    MeasureSummary summary;
+    summary.histogram.assign(bins, 0);
+    double sum = 0;
+    int count = 0;
+    for (int i = 0; i < values.size(); ++i)
+    {
+        if (!isfinite(values[i]))
+            continue;
+        if (summary.argMin == -1 || values[i] < summary.min)
+        {
+            summary.min = values[i];
+            summary.argMin = i;
+        }
+        if (summary.argMax == -1 || values[i] > summary.max)
+        {
+            summary.max = values[i];
+            summary.argMax = i;
+        }
+        sum += values[i];
+        ++count;
+    }
+    if (count == 0)
+        return summary;
+    summary.mean = sum / count;
+
+    const double width = (summary.max - summary.min) / bins;
+    for (double v : values)
+    {
+        if (!isfinite(v))
+            continue;
+        int bin = width > 0 ? static_cast<int>((v - summary.min) / width) : 0;
+        ++summary.histogram[clamp(bin, 0, bins - 1)];
+    }
+    return summary;
+}
+
+void RunReport::record(const string &name, chrono::steady_clock::time_point wall, double cpu)
+{
+    if (!timed)
+    {
+        firstWall = wall;
+        firstCpu = cpu;
+        timed = true;
+    }
+    lastWall = chrono::steady_clock::now();
+    lastCpu = cpuTime();
+    Phase phase;
+    phase.name = name;
+    phase.wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - wall).count();
+    phase.processCpuMs = cpuTime() - cpu;
+    phases.push_back(phase);
+}
+
+RunReport::Phase &RunReport::phase(const string &name)
+{
+    auto it = ranges::find(phases, name, &Phase::name);
+    if (it == phases.end())
+        throw runtime_error("No phase named " + name + " in the report");
+    return *it;
+}
+
+void RunReport::setMesh(const Mesh &mesh)
+{
+    vertices = mesh.vertices.size();
+    faces = mesh.faces.size();
+    tetras = mesh.tetras.size();
+}
+
+void RunReport::setResult(const PolyMesh &result)
+{
+    polyhedra = result.cells.size();
+    vector<bool> used(result.vertices.size(), false);
+    vector<double> sizes;
+    sizes.reserve(result.cells.size());
+    for (const auto &poly : result.cells)
+    {
+        for (int vi : poly.vertices)
+            used[vi] = true;
+        sizes.push_back(static_cast<double>(poly.cells.size()));
+    }
+    coverage = used.empty() ? 0 : static_cast<double>(ranges::count(used, true)) / used.size();
+    polyhedronTetras = MeasureSummary::of(sizes);
+}
+
+void RunReport::setStats(const vector<PolyStat> &stats)
+{
+    vector<double> volume, surface, edge;
+    kernels = 0;
+    for (const auto &stat : stats)
+    {
+        volume.push_back(stat.volumeRatio);
+        surface.push_back(stat.surfaceRatio);
+        edge.push_back(stat.edgeRatio);
+        kernels += stat.kernel.has_value();
+    }
+    quality = {{"volumeRatio", MeasureSummary::of(volume)},
+               {"surfaceRatio", MeasureSummary::of(surface)},
+               {"edgeRatio", MeasureSummary::of(edge)}};
+}
+
+double RunReport::cpuTime()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0;
+    auto ticks = [](FILETIME t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+    // Ticks of 100 ns
+    return (ticks(kernel) + ticks(user)) / 1e4;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto ms = [](timeval t) { return t.tv_sec * 1e3 + t.tv_usec / 1e3; };
+    return ms(usage.ru_utime) + ms(usage.ru_stime);
+#endif
+}
+
+size_t RunReport::peakMemory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    // Kilobytes on Linux
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+string Polylla::jsonString(const string &text)
+{
+    string out = "\"";
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char code[7];
+                snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+                out += code;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+namespace
+{
+void writeSummary(ostream &out, const MeasureSummary &s)
+{
+    out << "{\"min\": " << s.min << ", \"max\": " << s.max << ", \"mean\": " << s.mean << ", \"argMin\": " << s.argMin
+        << ", \"argMax\": " << s.argMax << ", \"histogram\": [";
+    for (int i = 0; i < s.histogram.size(); ++i)
+        out << (i ? ", " : "") << s.histogram[i];
+    out << "]}";
+}
+} // namespace
+
+void RunReport::write(const string &file) const
+{
+    ofstream out(file);
+    if (!out.is_open())
+        throw runtime_error("Unable to create file: " + file);
+    out.precision(9);
+
+    // Phases may overlap or leave gaps, so the total is measured from the first start to the last end
+    double wall = 0, cpu = 0;
+    if (timed)
+    {
+        wall = chrono::duration<double, milli>(lastWall - firstWall).count();
+        cpu = lastCpu - firstCpu;
+    }
+
+    out << "{\n";
+    out << "  \"input\": " << jsonString(input) << ",\n";
+    out << "  \"output\": " << jsonString(output) << ",\n";
+    out << "  \"threads\": " << threads << ",\n";
+    out << "  \"mesh\": {\"vertices\": " << vertices << ", \"faces\": " << faces << ", \"tetras\": " << tetras
+        << "},\n";
+    out << "  \"result\": {\"polyhedra\": " << polyhedra << ", \"pointCoverage\": " << coverage
+        << ", \"tetrasPerPolyhedron\": ";
+    writeSummary(out, polyhedronTetras);
+    out << "},\n";
+
+    out << "  \"phases\": [";
+    for (int i = 0; i < phases.size(); ++i)
+    {
+        const Phase &p = phases[i];
+        const double seconds = p.wallMs / 1e3;
+        out << (i ? ",\n" : "\n") << "    {\"name\": " << jsonString(p.name) << ", \"wallMs\": " << p.wallMs
+            << ", \"processCpuMs\": " << p.processCpuMs;
+        if (p.tetras > 0 && seconds > 0)
+            out << ", \"tetrasPerSecond\": " << p.tetras / seconds;
+        if (p.bytes > 0 && seconds > 0)
+            out << ", \"bytes\": " << p.bytes << ", \"megabytesPerSecond\": " << p.bytes / 1e6 / seconds;
+        out << "}";
+    }
+    out << "\n  ],\n";
+    out << "  \"total\": {\"wallMs\": " << wall << ", \"processCpuMs\": " << cpu << "},\n";
+    out << "  \"memory\": {\"peakResidentBytes\": " << peakMemory() << ", \"allocations\": ";
+    if (allocationTotal() > 0)
+        out << allocationTotal();
+    else
+        out << "null";
+    out << "}";
+
+    if (!quality.empty())
+    {
+        out << ",\n  \"quality\": {\"kernels\": " << kernels;
+        for (const auto &[name, summary] : quality)
+        {
+            out << ",\n    " << jsonString(name) << ": ";
+            writeSummary(out, summary);
+        }
+        out << "\n  }";
+    }
+    out << "\n}\n";
+}
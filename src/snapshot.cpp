@@ -0,0 +1,338 @@
+#include "parallel.h"
+#include "trace.h"
+#include <gpolylla/render.h>
+#include <gpolylla/snapshot.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numbers>
+#include <stdexcept>
+
+using namespace Polylla;
+using namespace std;
+
+namespace
+{
+constexpr int TILE_SIZE = 32;
+
+// Edge functions e = a x + b y + c of a triangle in pixels, positive inside, and the plane of its inverse depth
+struct Triangle
+{
+    float a[3], b[3], c[3];
+    float qx, qy, q0;
+    int minX, minY, maxX, maxY;
+    int cell;
+    float shade;
+};
+
+// Camera basis, forward, right and up
+struct View
+{
+    Vector3 forward, right, up;
+    Real tanHalf;
+
+    explicit View(const Camera &camera)
+    {
+        forward = (camera.target - camera.eye).normalized();
+        right = forward.cross(camera.up).normalized();
+        up = right.cross(forward);
+        tanHalf = std::tan(camera.fieldOfView * (numbers::pi_v<Real> / 360));
+    }
+};
+
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+{
+    static const auto table = [] {
+        array<uint32_t, 256> table;
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        return table;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void putBigEndian(vector<uint8_t> *out, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+        out->push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void writeChunk(ofstream &file, const char *type, const vector<uint8_t> &data)
+{
+    vector<uint8_t> chunk(type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    vector<uint8_t> length, crc;
+    putBigEndian(&length, static_cast<uint32_t>(data.size()));
+    putBigEndian(&crc, crc32(chunk.data(), chunk.size()));
+    file.write(reinterpret_cast<const char *>(length.data()), length.size());
+    file.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+    file.write(reinterpret_cast<const char *>(crc.data()), crc.size());
+}
+} // namespace
+
+Camera Camera::framing(const Mesh &mesh, const Vector3 &direction)
+{
+    Camera camera;
+    Box3 bounds;
+    for (const auto &v : mesh.vertices)
+        bounds.extend(v);
+    if (bounds.isEmpty())
+        return camera;
+
+    const Real radius = max(bounds.sizes().norm() / 2, Real(1e-6));
+    const Real distance = radius / std::sin(camera.fieldOfView * (numbers::pi_v<Real> / 360)) * Real(1.05);
+    camera.target = bounds.center();
+    camera.eye = camera.target + direction.normalized() * distance;
+    if (std::abs(direction.normalized().dot(camera.up)) > Real(0.99))
+        camera.up = Vector3(0, 0, 1);
+    return camera;
+}
+
+Vector3 Camera::ray(int x, int y, int width, int height) const
+{
+    const View view(*this);
+    const Real aspect = static_cast<Real>(width) / height;
+    const Real ndcX = (x + Real(0.5)) / width * 2 - 1;
+    const Real ndcY = 1 - (y + Real(0.5)) / height * 2;
+    return (view.forward + view.right * (ndcX * view.tanHalf * aspect) + view.up * (ndcY * view.tanHalf))
+        .normalized();
+}
+
+void Image::writePpm(const string &file) const
+{
+    ofstream out(file, ios::binary);
+    if (!out.is_open())
+    {
+        throw runtime_error("Unable to create file: " + file);
+    }
+    out << "P6\n" << width << " " << height << "\n255\n";
+    out.write(reinterpret_cast<const char *>(pixels.data()), pixels.size());
+}
+
+void Image::writePng(const string &file) const
+{
+    ofstream out(file, ios::binary);
+    if (!out.is_open())
+    {
+        throw runtime_error("Unable to create file: " + file);
+    }
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+    vector<uint8_t> header;
+    putBigEndian(&header, width);
+    putBigEndian(&header, height);
+    // 8 bit RGB, deflate, no interlacing
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+    writeChunk(out, "IHDR", header);
+
+    // Every row starts with filter type none
+    vector<uint8_t> raw;
+    raw.reserve(static_cast<size_t>(height) * (3 * width + 1));
+    for (int y = 0; y < height; ++y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixel(0, y), pixel(0, y) + 3 * width);
+    }
+
+    // Zlib stream of stored deflate blocks
+    vector<uint8_t> data = {0x78, 0x01};
+    uint32_t a = 1, b = 0;
+    size_t offset = 0;
+    do
+    {
+        const size_t size = min<size_t>(65535, raw.size() - offset);
+        data.push_back(offset + size == raw.size());
+        data.insert(data.end(), {static_cast<uint8_t>(size), static_cast<uint8_t>(size >> 8),
+                                 static_cast<uint8_t>(~size), static_cast<uint8_t>(~size >> 8)});
+        data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + size);
+        for (size_t i = offset; i < offset + size; ++i)
+        {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        offset += size;
+    } while (offset < raw.size());
+    putBigEndian(&data, b << 16 | a);
+    writeChunk(out, "IDAT", data);
+    writeChunk(out, "IEND", {});
+}
+
+void Image::write(const string &file) const
+{
+    const string extension = file.size() >= 4 ? file.substr(file.size() - 4) : "";
+    if (extension == ".png" || extension == ".PNG")
+        writePng(file);
+    else if (extension == ".ppm" || extension == ".PPM")
+        writePpm(file);
+    else
+        throw invalid_argument("Snapshots are written as .png or .ppm: " + file);
+}
+
+Image Snapshot::operator()(const Mesh &mesh) const
+{
+    GPOLYLLA_TRACE_SCOPE("Snapshot");
+    if (width <= 0 || height <= 0)
+        throw invalid_argument("Snapshot size must be positive");
+    ExecutionScope scope(context);
+    context.phase("surface");
+    VisibleSurface surface(mesh);
+
+    // Polyhedra if the tetrahedra have them, tetrahedra otherwise
+    int cellCount = static_cast<int>(mesh.tetras.size());
+    const bool byPolyhedron = ranges::any_of(mesh.tetras, [](const Tetrahedron &t) { return t.polyhedron >= 0; });
+    if (byPolyhedron)
+    {
+        cellCount = 0;
+        for (const auto &tetra : mesh.tetras)
+            cellCount = max(cellCount, tetra.polyhedron + 1);
+    }
+    const auto colors = cellColors(cellCount, seed);
+
+    context.phase("raster");
+    const View view(camera);
+    const Real aspect = static_cast<Real>(width) / height;
+    const int vertexCount = static_cast<int>(mesh.vertices.size());
+    // Pixel coordinates and inverse depth, which is affine in screen space, of every vertex
+    vector<array<float, 3>> screen(vertexCount);
+    parallelFor(vertexCount, [&](int vi) {
+        const Vector3 d = mesh.vertices[vi] - camera.eye;
+        const Real z = d.dot(view.forward);
+        const Real x = d.dot(view.right) / (z * view.tanHalf * aspect);
+        const Real y = d.dot(view.up) / (z * view.tanHalf);
+        screen[vi] = {static_cast<float>((x + 1) / 2 * width), static_cast<float>((1 - y) / 2 * height),
+                      z > 0 ? static_cast<float>(1 / z) : 0.0f};
+    });
+
+    const int triangleCount = static_cast<int>(surface.triangles().size());
+    vector<Triangle> triangles(triangleCount);
+    vector<char> drawn(triangleCount, 0);
+    parallelFor(triangleCount, [&](int i) {
+        const auto &corners = surface.triangles()[i];
+        const Vector3 &p0 = mesh.vertices[corners[0]];
+        const Vector3 normal = (mesh.vertices[corners[1]] - p0).cross(mesh.vertices[corners[2]] - p0).normalized();
+        // Back faces are hidden by the front ones of the closed surface
+        if (normal.dot(camera.eye - p0) <= 0)
+            return;
+        const array<float, 3> *p[3] = {&screen[corners[0]], &screen[corners[1]], &screen[corners[2]]};
+        if ((*p[0])[2] <= 0 || (*p[1])[2] <= 0 || (*p[2])[2] <= 0)
+            return;
+
+        Triangle &t = triangles[i];
+        const float x0 = (*p[0])[0], y0 = (*p[0])[1], x1 = (*p[1])[0], y1 = (*p[1])[1], x2 = (*p[2])[0],
+                    y2 = (*p[2])[1];
+        const float area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+        if (area == 0)
+            return;
+        const float sign = area > 0 ? 1.0f : -1.0f;
+        for (int k = 0; k < 3; ++k)
+        {
+            const auto &from = *p[k], &to = *p[(k + 1) % 3];
+            t.a[k] = sign * (from[1] - to[1]);
+            t.b[k] = sign * (to[0] - from[0]);
+            t.c[k] = sign * ((to[1] - from[1]) * from[0] - (to[0] - from[0]) * from[1]);
+        }
+        const float q0 = (*p[0])[2], q1 = (*p[1])[2], q2 = (*p[2])[2];
+        t.qx = ((q1 - q0) * (y2 - y0) - (q2 - q0) * (y1 - y0)) / area;
+        t.qy = ((q2 - q0) * (x1 - x0) - (q1 - q0) * (x2 - x0)) / area;
+        t.q0 = q0 - t.qx * x0 - t.qy * y0;
+
+        t.minX = max(0, static_cast<int>(floor(min({x0, x1, x2}))));
+        t.minY = max(0, static_cast<int>(floor(min({y0, y1, y2}))));
+        t.maxX = min(width - 1, static_cast<int>(ceil(max({x0, x1, x2}))));
+        t.maxY = min(height - 1, static_cast<int>(ceil(max({y0, y1, y2}))));
+        if (t.minX > t.maxX || t.minY > t.maxY)
+            return;
+
+        const int ti = surface.sides()[i] / 4;
+        t.cell = byPolyhedron ? mesh.tetras[ti].polyhedron : ti;
+        const Vector3 toFace = (p0 - camera.eye).normalized();
+        t.shade = static_cast<float>(0.3 + 0.7 * std::abs(normal.dot(toFace)));
+        drawn[i] = t.cell >= 0;
+    });
+
+    // Triangles of every tile in increasing order, so ties in depth resolve the same on any number of threads
+    const int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE, tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    vector<vector<int>> bins(tilesX * tilesY);
+    for (int i = 0; i < triangleCount; ++i)
+    {
+        if (!drawn[i])
+            continue;
+        const Triangle &t = triangles[i];
+        for (int ty = t.minY / TILE_SIZE; ty <= t.maxY / TILE_SIZE; ++ty)
+        {
+            for (int tx = t.minX / TILE_SIZE; tx <= t.maxX / TILE_SIZE; ++tx)
+                bins[ty * tilesX + tx].push_back(i);
+        }
+    }
+    GPOLYLLA_TRACE_COUNTER("snapshotTriangles", triangleCount);
+
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 3);
+    parallelFor(
+        tilesX * tilesY,
+        [&](int tile) {
+            const int left = tile % tilesX * TILE_SIZE, top = tile / tilesX * TILE_SIZE;
+            const int right = min(left + TILE_SIZE, width), bottom = min(top + TILE_SIZE, height);
+            float depth[TILE_SIZE * TILE_SIZE];
+            int nearest[TILE_SIZE * TILE_SIZE];
+            fill(begin(depth), end(depth), 0.0f);
+            fill(begin(nearest), end(nearest), -1);
+
+            for (int i : bins[tile])
+            {
+                const Triangle &t = triangles[i];
+                const int x0 = max(t.minX, left), x1 = min(t.maxX, right - 1);
+                const int y0 = max(t.minY, top), y1 = min(t.maxY, bottom - 1);
+                for (int y = y0; y <= y1; ++y)
+                {
+                    const float py = y + 0.5f;
+                    float *depthRow = depth + (y - top) * TILE_SIZE - left;
+                    int *nearestRow = nearest + (y - top) * TILE_SIZE - left;
+                    // Branch free over the row, so the compiler evaluates several pixels per instruction
+                    for (int x = x0; x <= x1; ++x)
+                    {
+                        const float px = x + 0.5f;
+                        const float e0 = t.a[0] * px + t.b[0] * py + t.c[0];
+                        const float e1 = t.a[1] * px + t.b[1] * py + t.c[1];
+                        const float e2 = t.a[2] * px + t.b[2] * py + t.c[2];
+                        const float q = t.qx * px + t.qy * py + t.q0;
+                        const bool take = (e0 >= 0) & (e1 >= 0) & (e2 >= 0) & (q > depthRow[x]);
+                        depthRow[x] = take ? q : depthRow[x];
+                        nearestRow[x] = take ? i : nearestRow[x];
+                    }
+                }
+            }
+
+            for (int y = top; y < bottom; ++y)
+            {
+                for (int x = left; x < right; ++x)
+                {
+                    const int i = nearest[(y - top) * TILE_SIZE + x - left];
+                    array<float, 3> color = background;
+                    if (i != -1)
+                    {
+                        for (int k = 0; k < 3; ++k)
+                            color[k] = colors[triangles[i].cell][k] * triangles[i].shade;
+                    }
+                    uint8_t *out = image.pixels.data() + 3 * (static_cast<size_t>(y) * width + x);
+                    for (int k = 0; k < 3; ++k)
+                        out[k] = static_cast<uint8_t>(lround(clamp(color[k], 0.0f, 1.0f) * 255));
+                }
+            }
+        },
+        1);
+    context.report(1);
+    return image;
+}
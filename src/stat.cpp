@@ -1,8 +1,8 @@
 //
 // Created by vigb9 on 06/10/2025.
 //
-#include "../cmake-build-debug/_deps/imgui-src/imgui.h"
 #include "utils.h"
+#include "trace.h"
 #include <gpolylla/stat.h>
 
 #include <QuickHull.hpp>
@@ -14,10 +14,10 @@
 
 using namespace Polylla;
 
-float generalVolume(const std::vector<Vertex> &vertices, const std::vector<Face> &faces)
+Real generalVolume(const std::vector<Vertex> &vertices, const std::vector<Face> &faces)
 {
     Vertex ref = vertices[0];
-    float signedVolume = 0.f;
+    Real signedVolume = 0;
     for (auto f: faces)
     {
         const auto &v0 = vertices[f.vertices[0]];
@@ -25,12 +25,12 @@ float generalVolume(const std::vector<Vertex> &vertices, const std::vector<Face>
         const auto &v2 = vertices[f.vertices[2]];
         signedVolume += signedSixthVolume(ref, v0, v1, v2);
     }
-    return abs(signedVolume) / 6.0f;
+    return std::abs(signedVolume) / 6;
 }
 
-float generalArea(const std::vector<Vertex> &vertices, const std::vector<Face> &faces)
+Real generalArea(const std::vector<Vertex> &vertices, const std::vector<Face> &faces)
 {
-    float totalArea = 0.f;
+    Real totalArea = 0;
     for (auto f: faces)
     {
         const auto &v0 = vertices[f.vertices[0]];
@@ -38,43 +38,43 @@ float generalArea(const std::vector<Vertex> &vertices, const std::vector<Face> &
         const auto &v2 = vertices[f.vertices[2]];
         totalArea += normal(v0, v1, v2).norm();
     }
-    return .5f * totalArea;
+    return Real(0.5) * totalArea;
 }
 
 
-Hull::Hull(const Polyhedron &poly, const PolyMesh &mesh)
+Hull::Hull(const Polyhedron &poly, const Mesh &mesh)
 {
-    quickhull::QuickHull<float> qh;
-    std::vector<quickhull::Vector3<float>> qhVertices;
-    vertices.reserve(poly.vertices.size());
+    quickhull::QuickHull<Real> qh;
+    std::vector<quickhull::Vector3<Real>> qhVertices;
+    vertices_.reserve(poly.vertices.size());
     qhVertices.reserve(poly.vertices.size());
     for (int vi : poly.vertices)
     {
         const auto& vert = mesh.vertices[vi];
-        vertices.push_back(vert);
+        vertices_.push_back(vert);
         qhVertices.emplace_back(vert.x(), vert.y(), vert.z());
     }
     auto hull = qh.getConvexHull(qhVertices, true, true);
     const auto& indices = hull.getIndexBuffer();
     int facesAmount = indices.size() / 3;
-    faces.reserve(facesAmount);
+    faces_.reserve(facesAmount);
     for (int fi = 0; fi < facesAmount; fi++)
     {
-        faces.emplace_back(indices[fi * 3], indices[fi * 3 + 1], indices[fi * 3 + 2]);
+        faces_.emplace_back(indices[fi * 3], indices[fi * 3 + 1], indices[fi * 3 + 2]);
     }
 }
 
-float Hull::volume() const
+Real Hull::volume() const
 {
-    return generalVolume(vertices, faces);
+    return generalVolume(vertices_, faces_);
 }
 
-float Hull::area() const
+Real Hull::area() const
 {
-    return generalArea(vertices, faces);
+    return generalArea(vertices_, faces_);
 }
 
- Kernel::Kernel(const Polyhedron &poly, const PolyMesh &mesh)
+ Kernel::Kernel(const Polyhedron &poly, const Mesh &mesh)
 {
     PolyhedronKernel k;
     std::vector<cinolib::vec3d> kVertices;
@@ -132,12 +132,12 @@ float Hull::area() const
 }
 
 
-float Kernel::volume() const
+Real Kernel::volume() const
 {
     return generalVolume(vertices, faces);
 }
 
-float Kernel::area() const
+Real Kernel::area() const
 {
     return generalArea(vertices, faces);
 }
@@ -162,46 +162,57 @@ bool Kernel::empty() const
 //     }
 // }
 
-std::vector<PolyStat> Polylla::computeStats(const PolyMesh &mesh)
+PolyStat Polylla::computeStat(const Polyhedron &poly, const Mesh &mesh)
 {
-    std::vector<PolyStat> stats;
-    stats.reserve(mesh.cells.size());
-    for (const auto& poly : mesh.cells)
-    {
-        PolyStat stat;
-        stat.hull = Hull(poly, mesh);
-        Kernel possibleKernel(poly, mesh);
+    PolyStat stat;
+    stat.hull = Hull(poly, mesh);
+    Kernel possibleKernel(poly, mesh);
 
-        stat.kernel = possibleKernel;
-        if (possibleKernel.empty())
-        {
-            stat.kernel = std::nullopt;
-        }
+    stat.kernel = possibleKernel;
+    if (possibleKernel.empty())
+    {
+        stat.kernel = std::nullopt;
+    }
 
-        float minSize = std::numeric_limits<float>::max();
-        float maxSize = std::numeric_limits<float>::min();
+    Real minSize = std::numeric_limits<Real>::max();
+    Real maxSize = std::numeric_limits<Real>::min();
 
-        for (const auto& fi : poly.faces)
+    for (const auto& fi : poly.faces)
+    {
+        const Face &f = mesh.faces[fi];
+        for (int i = 0; i < 3; ++i)
         {
-            const Face &f = mesh.faces[fi];
-            for (int i = 0; i < 3; ++i)
-            {
-                const auto &v0 = mesh.vertices[f.vertices[i]];
-                const auto &v1 = mesh.vertices[f.vertices[(i + 1) % 3]];
-                float edgeSize = (v1 - v0).norm();
-                minSize = std::min(minSize, edgeSize);
-                maxSize = std::max(maxSize, edgeSize);
-            }
+            const auto &v0 = mesh.vertices[f.vertices[i]];
+            const auto &v1 = mesh.vertices[f.vertices[(i + 1) % 3]];
+            Real edgeSize = (v1 - v0).norm();
+            minSize = std::min(minSize, edgeSize);
+            maxSize = std::max(maxSize, edgeSize);
         }
+    }
 
-        stat.edgeRatio = minSize / maxSize;
-        stat.volumeRatio = 0.0f;
-        if (stat.kernel)
-            stat.volumeRatio = poly.volume(mesh) / stat.kernel.value().volume();
-        stat.surfaceRatio = poly.area(mesh) / stat.hull.area();
-        stats.push_back(stat);
+    stat.edgeRatio = minSize / maxSize;
+    stat.volumeRatio = 0;
+    if (stat.kernel)
+        stat.volumeRatio = poly.volume(mesh) / stat.kernel.value().volume();
+    stat.surfaceRatio = poly.area(mesh) / stat.hull.area();
+    return stat;
+}
+
+std::vector<PolyStat> Polylla::computeStats(const PolyMesh &mesh, const ExecutionContext &context)
+{
+    GPOLYLLA_TRACE_SCOPE("computeStats");
+    GPOLYLLA_TRACE_COUNTER("polyhedra", mesh.cells.size());
+    ExecutionScope scope(context);
+    context.phase("stats");
+    std::vector<PolyStat> stats;
+    stats.reserve(mesh.cells.size());
+    for (const auto& poly : mesh.cells)
+    {
+        stats.push_back(computeStat(poly, mesh));
+        if (stats.size() % 256 == 0)
+            context.report(static_cast<double>(stats.size()) / mesh.cells.size());
     }
+    context.report(1);
 
     return stats;
 }
-
@@ -0,0 +1,395 @@
+#include "cavity.h"
+#include "io.h"
+#include "logger.h"
+#include "partition.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace Polylla;
+using namespace std;
+
+struct SpilledTetra
+{
+    int index;
+    array<int, 4> vertices;
+};
+
+struct BlockGrid
+{
+    Vector3 origin;
+    Vector3 size;
+    int resolution = 1;
+
+    BlockGrid(const vector<Vertex> &vertices, size_t tetras, int blockSize)
+    {
+        Box3 bounds;
+        for (const auto &v : vertices)
+            bounds.extend(v);
+        origin = bounds.min();
+        size = bounds.sizes().cwiseMax(TOLERANCE);
+
+        const double blocks = std::ceil(static_cast<double>(tetras) / std::max(blockSize, 1));
+        resolution = std::max(1, static_cast<int>(std::ceil(std::cbrt(blocks))));
+    }
+
+    int count() const
+    {
+        return resolution * resolution * resolution;
+    }
+
+    array<int, 3> cellOf(const Vector3 &p) const
+    {
+        array<int, 3> cell;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            int c = static_cast<int>((p[axis] - origin[axis]) / size[axis] * resolution);
+            cell[axis] = std::clamp(c, 0, resolution - 1);
+        }
+        return cell;
+    }
+
+    int blockOf(const Vector3 &p) const
+    {
+        auto [i, j, k] = cellOf(p);
+        return (k * resolution + j) * resolution + i;
+    }
+
+    Box3 box(int block) const
+    {
+        int i = block % resolution;
+        int j = (block / resolution) % resolution;
+        int k = block / (resolution * resolution);
+        Vector3 step = size / static_cast<Real>(resolution);
+        Vector3 lo = origin + Vector3(i * step.x(), j * step.y(), k * step.z());
+        return {lo, lo + step};
+    }
+
+    // Z-order of the blocks, so consecutive blocks share most of their halo
+    vector<int> order() const
+    {
+        vector<pair<uint64_t, int>> codes;
+        codes.reserve(count());
+        for (int b = 0; b < count(); ++b)
+        {
+            int i = b % resolution;
+            int j = (b / resolution) % resolution;
+            int k = b / (resolution * resolution);
+            codes.emplace_back(mortonCode(i, j, k), b);
+        }
+        ranges::sort(codes);
+        vector<int> blocks;
+        blocks.reserve(codes.size());
+        for (auto [code, b] : codes)
+            blocks.push_back(b);
+        return blocks;
+    }
+};
+
+class BlockStore
+{
+  public:
+    BlockStore(filesystem::path directory, int blocks) : directory(std::move(directory)), buffers(blocks)
+    {
+        // Blocks are appended to, so files left by an interrupted run must go
+        filesystem::remove_all(this->directory);
+        filesystem::create_directories(this->directory);
+    }
+
+    void push(int block, const SpilledTetra &tetra)
+    {
+        buffers[block].push_back(tetra);
+        if (buffers[block].size() >= FLUSH_SIZE)
+            flush(block);
+    }
+
+    void flush()
+    {
+        for (int b = 0; b < buffers.size(); ++b)
+            flush(b);
+    }
+
+    vector<SpilledTetra> read(int block) const
+    {
+        vector<SpilledTetra> tetras;
+        ifstream in(path(block), ios::binary | ios::ate);
+        if (!in.is_open())
+            return tetras;
+        auto bytes = static_cast<size_t>(in.tellg());
+        tetras.resize(bytes / sizeof(SpilledTetra));
+        in.seekg(0);
+        in.read(reinterpret_cast<char *>(tetras.data()), tetras.size() * sizeof(SpilledTetra));
+        return tetras;
+    }
+
+    void clear() const
+    {
+        filesystem::remove_all(directory);
+    }
+
+  private:
+    static constexpr size_t FLUSH_SIZE = 4096;
+    filesystem::path directory;
+    vector<vector<SpilledTetra>> buffers;
+
+    filesystem::path path(int block) const
+    {
+        return directory / ("block_" + to_string(block) + ".bin");
+    }
+
+    void flush(int block)
+    {
+        auto &buffer = buffers[block];
+        if (buffer.empty())
+            return;
+        ofstream out(path(block), ios::binary | ios::app);
+        if (!out.is_open())
+            throw runtime_error("Unable to spill block: " + path(block).string());
+        out.write(reinterpret_cast<const char *>(buffer.data()), buffer.size() * sizeof(SpilledTetra));
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+};
+
+// Streams the element file, sending every tetrahedron to the block of its centroid
+struct SpillInfo
+{
+    size_t tetras = 0;
+    // Largest circumradius per block
+    vector<Real> radius;
+    // Largest distance from a centroid to its vertices, bounds how far a neighbour's centroid can be
+    Real extent = 0;
+};
+
+SpillInfo spillTetras(const string &file, const vector<Vertex> &vertices, const BlockGrid &grid, BlockStore *store)
+{
+    ifstream eleStream(file);
+    if (!eleStream.is_open())
+    {
+        throw FileNotFoundError("Cannot open element file: " + file);
+    }
+
+    SpillInfo info;
+    info.radius.resize(grid.count(), 0.0f);
+
+    string line;
+    getline(eleStream, line);
+    int index = 0;
+    bool first = true;
+    while (getline(eleStream, line))
+    {
+        istringstream lineStream(line);
+        string token;
+        lineStream >> token;
+        if (token.empty() || token == "#")
+            continue; // Skip comments
+        if (first)
+        {
+            // Same numbering as buildCells, which pads 1-based files with a dummy tetrahedron
+            if (stoi(token) == 1)
+                index = 1;
+            first = false;
+        }
+
+        SpilledTetra t;
+        t.index = index++;
+        lineStream >> t.vertices[0] >> t.vertices[1] >> t.vertices[2] >> t.vertices[3];
+
+        const auto &p = vertices;
+        auto sphere = circumsphere(p[t.vertices[0]], p[t.vertices[1]], p[t.vertices[2]], p[t.vertices[3]]);
+        int block = grid.blockOf(centroid(t.vertices, vertices));
+        info.radius[block] = std::max(info.radius[block], static_cast<Real>(sphere.radius));
+        info.extent = std::max(info.extent, Polylla::extent(t.vertices, vertices));
+        store->push(block, t);
+        info.tetras = index;
+    }
+    store->flush();
+    return info;
+}
+
+class BlockProcessor
+{
+  public:
+    BlockProcessor(const StreamingCavityAlgorithm &config, VisFStreamWriter *writer, size_t tetras)
+        : config(config), writer(writer), committed(tetras, false)
+    {
+    }
+
+    // Runs the cavity algorithm on the region and writes the polyhedra whose seed is accepted by the filter.
+    // Returns false if one of them reaches a tetrahedron whose neighbours may lie outside the region; then nothing
+    // is written, unless partial is set and the others are written anyway.
+    template <typename Filter, typename Bounded>
+    bool process(const LocalMesh &local, Filter accept, Bounded bounded, bool partial = false)
+    {
+        PolyMesh result = localCavities(local, [&](int ti) { return committed[ti]; });
+
+        bool complete = true;
+        vector<const Polyhedron *> accepted;
+        for (const auto &poly : result.cells)
+        {
+            if (!accept(poly.cells.front()))
+                continue;
+            if (!ranges::all_of(poly.cells, bounded))
+            {
+                if (!partial)
+                    return false;
+                complete = false;
+                continue;
+            }
+            accepted.push_back(&poly);
+        }
+
+        for (const Polyhedron *poly : accepted)
+        {
+            vector<int> tetras;
+            tetras.reserve(poly->cells.size());
+            for (int ti : poly->cells)
+            {
+                tetras.push_back(local.tetras[ti]);
+                committed[local.tetras[ti]] = true;
+            }
+
+            auto faces = directedFaces(*poly, result);
+            for (auto &face : faces)
+            {
+                for (int &vi : face)
+                    vi = local.vertices[vi];
+            }
+            writer->write(faces);
+            if (config.onPolyhedron)
+                config.onPolyhedron(tetras);
+        }
+        return complete;
+    }
+
+    bool isCommitted(int ti) const
+    {
+        return committed[ti];
+    }
+
+  private:
+    const StreamingCavityAlgorithm &config;
+    VisFStreamWriter *writer;
+    vector<bool> committed;
+};
+
+void StreamingCavityAlgorithm::operator()()
+{
+    const vector<Vertex> vertices = buildVertices(nodeFile);
+
+    // The header has the amount of tetrahedra, needed to size the blocks
+    size_t expected = 0;
+    {
+        ifstream eleStream(eleFile);
+        if (!eleStream.is_open())
+            throw FileNotFoundError("Cannot open element file: " + eleFile);
+        eleStream >> expected;
+    }
+
+    BlockGrid grid(vertices, expected, blockSize);
+    filesystem::path directory = spillDirectory.empty() ? outputFile + ".blocks" : spillDirectory;
+    BlockStore store(directory, grid.count());
+    SpillInfo spilled = spillTetras(eleFile, vertices, grid, &store);
+    const Box3 bounds(grid.origin, grid.origin + grid.size);
+
+    VisFStreamWriter writer;
+    writer.outputFile = outputFile;
+    writer.begin(vertices);
+    BlockProcessor processor(*this, &writer, spilled.tetras);
+
+    // Tetrahedra of the block and of its neighbours inside the expanded box, skipping the committed ones
+    auto gather = [&](int b, const Box3 &expanded) {
+        vector<RegionTetra> region;
+        for (const auto &t : store.read(b))
+        {
+            if (!processor.isCommitted(t.index))
+                region.push_back({t.index, t.vertices, true});
+        }
+        if (region.empty())
+            return region;
+
+        auto lo = grid.cellOf(expanded.min());
+        auto hi = grid.cellOf(expanded.max());
+        for (int k = lo[2]; k <= hi[2]; ++k)
+        {
+            for (int j = lo[1]; j <= hi[1]; ++j)
+            {
+                for (int i = lo[0]; i <= hi[0]; ++i)
+                {
+                    int neighbour = (k * grid.resolution + j) * grid.resolution + i;
+                    if (neighbour == b)
+                        continue;
+                    for (const auto &t : store.read(neighbour))
+                    {
+                        if (!processor.isCommitted(t.index) && expanded.contains(centroid(t.vertices, vertices)))
+                            region.push_back({t.index, t.vertices, false});
+                    }
+                }
+            }
+        }
+        return region;
+    };
+
+    // Processes block b with a halo that doubles until its polyhedra are bounded. The halo stops at one block
+    // diagonal, so a region never holds more than the block and its direct neighbours; at the cap the bounded
+    // polyhedra are written and the others are left over.
+    auto processBlock = [&](int b, Real halo) {
+        Box3 box = grid.box(b);
+        const Real maxHalo = std::max(halo, box.diagonal().norm());
+        while (true)
+        {
+            Box3 expanded(box.min().array() - halo, box.max().array() + halo);
+            vector<RegionTetra> region = gather(b, expanded);
+            if (region.empty())
+                return;
+
+            // Every tetrahedron sharing a face with one inside the safe box is part of the region
+            bool whole = expanded.contains(bounds);
+            Box3 safe(expanded.min().array() + spilled.extent, expanded.max().array() - spilled.extent);
+            LocalMesh local = buildLocalMesh(std::move(region), vertices);
+            auto bounded = [&](int ti) {
+                return whole || isBounded(local, ti, safe);
+            };
+            const bool last = halo >= maxHalo;
+            if (processor.process(local, [&](int seed) { return local.core[seed]; }, bounded, last) || last)
+                return;
+            halo = std::min(std::max(2 * halo, spilled.extent), maxHalo);
+        }
+    };
+
+    // A heuristic width: it makes the block's own polyhedra bounded, not equal to those of the whole mesh, since
+    // seeds outside the halo are never looked at
+    for (int b : grid.order())
+        processBlock(b, haloFactor * std::min(spilled.radius[b], grid.box(b).diagonal().norm()));
+
+    // Tetrahedra claimed in their block by a halo seed that later grew differently, or by a polyhedron cut by the
+    // halo cap, are left over. They are grown among themselves block by block, so they end in some polyhedron,
+    // not necessarily the one of the in-core algorithm. A last pass without halo takes what still does not fit.
+    size_t leftovers = 0;
+    for (int b = 0; b < grid.count(); ++b)
+    {
+        for (const auto &t : store.read(b))
+            leftovers += !processor.isCommitted(t.index);
+    }
+    if (leftovers > 0)
+    {
+        log("Streaming cavities: " + to_string(leftovers) + " leftover tetrahedra");
+        for (int b : grid.order())
+            processBlock(b, spilled.extent);
+        for (int b : grid.order())
+        {
+            vector<RegionTetra> region = gather(b, grid.box(b));
+            if (region.empty())
+                continue;
+            LocalMesh local = buildLocalMesh(std::move(region), vertices);
+            processor.process(local, [](int) { return true; }, [](int) { return true; });
+        }
+    }
+
+    writer.end();
+    store.clear();
+}
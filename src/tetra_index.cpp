@@ -0,0 +1,85 @@
+#include "parallel.h"
+#include <gpolylla/polylla.h>
+
+#include <cmath>
+#include <limits>
+
+using namespace Polylla;
+using namespace std;
+
+namespace
+{
+constexpr Real INF = numeric_limits<Real>::infinity();
+
+// Möller-Trumbore, the distance along the ray to the triangle or infinity. Edges and corners count as hits so a
+// ray through a shared edge is not lost between two faces.
+Real rayTriangle(const Vector3 &origin, const Vector3 &direction, const Vector3 &a, const Vector3 &b,
+                 const Vector3 &c)
+{
+    const Vector3 edge1 = b - a, edge2 = c - a;
+    const Vector3 p = direction.cross(edge2);
+    const Real det = edge1.dot(p);
+    if (det == 0)
+        return INF;
+
+    const Real inverse = 1 / det;
+    const Vector3 s = origin - a;
+    const Real u = s.dot(p) * inverse;
+    if (u < 0 || u > 1)
+        return INF;
+    const Vector3 q = s.cross(edge1);
+    const Real v = direction.dot(q) * inverse;
+    if (v < 0 || u + v > 1)
+        return INF;
+    const Real t = edge2.dot(q) * inverse;
+    return t >= 0 ? t : INF;
+}
+} // namespace
+
+TetraIndex::TetraIndex(const Mesh &mesh) : mesh(&mesh)
+{
+    vector<Box3> boxes(mesh.tetras.size());
+    parallelFor(static_cast<int>(mesh.tetras.size()), [&](int ti) {
+        for (int vi : mesh.tetras[ti].vertices)
+            boxes[ti].extend(mesh.vertices[vi]);
+    });
+    bvh_ = Bvh(boxes);
+}
+
+TetraIndex::Hit TetraIndex::pick(const Vector3 &origin, const Vector3 &direction,
+                                 const function<bool(int)> &accept) const
+{
+    Hit hit;
+    if (!mesh)
+        return hit;
+
+    // Face of the closest crossing of every tested tetrahedron, kept for the winner
+    auto cross = [&](int ti, int *face) {
+        Real best = INF;
+        for (int fi : mesh->tetras[ti].faces)
+        {
+            const auto &corners = mesh->faces[fi].vertices;
+            const Real t = rayTriangle(origin, direction, mesh->vertices[corners[0]], mesh->vertices[corners[1]],
+                                       mesh->vertices[corners[2]]);
+            if (t < best)
+            {
+                best = t;
+                *face = fi;
+            }
+        }
+        return best;
+    };
+
+    auto found = bvh_.closestHit(origin, direction, [&](int ti) {
+        if (accept && !accept(ti))
+            return INF;
+        int face = -1;
+        return cross(ti, &face);
+    });
+    if (!found)
+        return hit;
+
+    hit.tetra = found->second;
+    hit.distance = cross(hit.tetra, &hit.face);
+    return hit;
+}
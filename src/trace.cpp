@@ -0,0 +1,169 @@
+#include "trace.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#ifdef GPOLYLLA_TRACE
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+using namespace Polylla;
+using namespace std;
+
+#ifdef GPOLYLLA_TRACE
+namespace
+{
+struct TraceEvent
+{
+    const char *name;
+    // 'X' for spans, 'C' for counters
+    char phase;
+    int64_t start;
+    int64_t duration;
+    double value;
+};
+
+// Appended to by its thread, read by writeTrace from another one, hence the lock. It is only contended while a
+// trace is written or cleared.
+struct ThreadBuffer
+{
+    int thread;
+    mutex lock;
+    vector<TraceEvent> events;
+
+    void record(const TraceEvent &event)
+    {
+        lock_guard guard(lock);
+        events.push_back(event);
+    }
+};
+
+// Buffers outlive their threads so spans recorded by finished workers are still written
+struct TraceRegistry
+{
+    mutex lock;
+    vector<shared_ptr<ThreadBuffer>> buffers;
+};
+
+TraceRegistry &registry()
+{
+    static TraceRegistry instance;
+    return instance;
+}
+
+ThreadBuffer &threadBuffer()
+{
+    thread_local shared_ptr<ThreadBuffer> buffer = [] {
+        auto &r = registry();
+        lock_guard guard(r.lock);
+        auto created = make_shared<ThreadBuffer>();
+        created->thread = static_cast<int>(r.buffers.size());
+        r.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+// Nanoseconds since the first event of the process
+int64_t now()
+{
+    static const auto origin = chrono::steady_clock::now();
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+thread_local uint64_t allocationCount = 0;
+atomic<uint64_t> processAllocations = 0;
+} // namespace
+
+TraceScope::TraceScope(const char *name) : name(name), start(now()), allocations(allocationCount)
+{
+}
+
+TraceScope::~TraceScope()
+{
+    const int64_t end = now();
+    const auto allocated = static_cast<double>(allocationCount - allocations);
+    threadBuffer().record({name, 'X', start, end - start, allocated});
+}
+
+void Polylla::traceCounter(const char *name, double value)
+{
+    threadBuffer().record({name, 'C', now(), 0, value});
+}
+#endif
+
+void Polylla::countAllocation() noexcept
+{
+#ifdef GPOLYLLA_TRACE
+    ++allocationCount;
+    processAllocations.fetch_add(1, memory_order_relaxed);
+#endif
+}
+
+bool Polylla::tracingEnabled()
+{
+#ifdef GPOLYLLA_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t Polylla::allocationTotal()
+{
+#ifdef GPOLYLLA_TRACE
+    return processAllocations.load(memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+void Polylla::clearTrace()
+{
+#ifdef GPOLYLLA_TRACE
+    auto &r = registry();
+    lock_guard guard(r.lock);
+    for (auto &buffer : r.buffers)
+    {
+        lock_guard bufferGuard(buffer->lock);
+        buffer->events.clear();
+    }
+#endif
+}
+
+void Polylla::writeTrace(const std::string &file)
+{
+    ofstream out(file);
+    if (!out.is_open())
+        throw runtime_error("Unable to create file: " + file);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+#ifdef GPOLYLLA_TRACE
+    auto &r = registry();
+    lock_guard guard(r.lock);
+    bool first = true;
+    out << fixed;
+    out.precision(3);
+    for (const auto &buffer : r.buffers)
+    {
+        lock_guard bufferGuard(buffer->lock);
+        for (const auto &e : buffer->events)
+        {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":\"" << e.name << "\",\"ph\":\"" << e.phase << "\",\"pid\":1,\"tid\":" << buffer->thread
+                << ",\"ts\":" << e.start / 1000.0;
+            if (e.phase == 'X')
+                out << ",\"dur\":" << e.duration / 1000.0
+                    << ",\"args\":{\"allocations\":" << static_cast<uint64_t>(e.value) << "}}";
+            else
+                out << ",\"args\":{\"value\":" << e.value << "}}";
+        }
+    }
+#endif
+    out << "\n]}\n";
+}
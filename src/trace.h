@@ -0,0 +1,38 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <gpolylla/trace.h>
+
+#ifdef GPOLYLLA_TRACE
+#include <cstdint>
+
+namespace Polylla
+{
+// Records the time spent in its scope and the allocations its thread counted meanwhile. Names must outlive the
+// trace, string literals are expected.
+class TraceScope
+{
+  public:
+    explicit TraceScope(const char *name);
+    ~TraceScope();
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+  private:
+    const char *name;
+    std::int64_t start;
+    std::uint64_t allocations;
+};
+
+void traceCounter(const char *name, double value);
+} // namespace Polylla
+
+#define GPOLYLLA_TRACE_JOIN_(a, b) a##b
+#define GPOLYLLA_TRACE_JOIN(a, b) GPOLYLLA_TRACE_JOIN_(a, b)
+#define GPOLYLLA_TRACE_SCOPE(name) ::Polylla::TraceScope GPOLYLLA_TRACE_JOIN(traceScope, __LINE__)(name)
+#define GPOLYLLA_TRACE_COUNTER(name, value) ::Polylla::traceCounter(name, static_cast<double>(value))
+#else
+#define GPOLYLLA_TRACE_SCOPE(name) ((void)0)
+#define GPOLYLLA_TRACE_COUNTER(name, value) ((void)0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,222 @@
+#include <gpolylla/polylla.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace Polylla;
+using namespace std;
+
+SocketTransport::SocketTransport(int rank, int size) : rank_(rank), size_(size), sockets(size, -1)
+{
+}
+
+int SocketTransport::rank() const
+{
+    return rank_;
+}
+
+int SocketTransport::size() const
+{
+    return size_;
+}
+
+#ifndef _WIN32
+
+static void sendAll(int socket, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = ::send(socket, data, size, 0);
+        if (sent <= 0)
+            throw runtime_error("Socket send failed: " + string(strerror(errno)));
+        data += sent;
+        size -= sent;
+    }
+}
+
+static void receiveAll(int socket, char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t received = ::recv(socket, data, size, 0);
+        if (received <= 0)
+            throw runtime_error("Socket receive failed: " + string(received == 0 ? "closed" : strerror(errno)));
+        data += received;
+        size -= received;
+    }
+}
+
+SocketTransport::~SocketTransport()
+{
+    for (int socket : sockets)
+    {
+        if (socket != -1)
+            close(socket);
+    }
+    for (int child : children)
+        waitpid(child, nullptr, 0);
+}
+
+void SocketTransport::send(int to, const vector<char> &message)
+{
+    if (to < 0 || to >= size_ || sockets[to] == -1)
+        throw runtime_error("No connection from rank " + to_string(rank_) + " to rank " + to_string(to));
+    // Messages are framed by their length
+    uint64_t length = message.size();
+    sendAll(sockets[to], reinterpret_cast<const char *>(&length), sizeof(length));
+    sendAll(sockets[to], message.data(), message.size());
+}
+
+vector<char> SocketTransport::receive(int from)
+{
+    if (from < 0 || from >= size_ || sockets[from] == -1)
+        throw runtime_error("No connection from rank " + to_string(from) + " to rank " + to_string(rank_));
+    uint64_t length = 0;
+    receiveAll(sockets[from], reinterpret_cast<char *>(&length), sizeof(length));
+    vector<char> message(length);
+    receiveAll(sockets[from], message.data(), message.size());
+    return message;
+}
+
+unique_ptr<SocketTransport> SocketTransport::spawn(int size)
+{
+    unique_ptr<SocketTransport> root(new SocketTransport(0, size));
+    for (int r = 1; r < size; ++r)
+    {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+            throw runtime_error("Unable to create socket pair: " + string(strerror(errno)));
+
+        pid_t pid = fork();
+        if (pid < 0)
+            throw runtime_error("Unable to fork worker: " + string(strerror(errno)));
+        if (pid == 0)
+        {
+            // The worker keeps only its own end, the sockets to earlier workers belong to rank 0
+            close(pair[0]);
+            for (int socket : root->sockets)
+            {
+                if (socket != -1)
+                    close(socket);
+            }
+            root->sockets.assign(size, -1);
+            root->children.clear();
+            unique_ptr<SocketTransport> worker(new SocketTransport(r, size));
+            worker->sockets[0] = pair[1];
+            return worker;
+        }
+        close(pair[1]);
+        root->sockets[r] = pair[0];
+        root->children.push_back(pid);
+    }
+    return root;
+}
+
+unique_ptr<SocketTransport> SocketTransport::listen(unsigned short port, int size)
+{
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server < 0)
+        throw runtime_error("Unable to create socket: " + string(strerror(errno)));
+    int enable = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(server, size) != 0)
+    {
+        close(server);
+        throw runtime_error("Unable to listen on port " + to_string(port) + ": " + strerror(errno));
+    }
+
+    unique_ptr<SocketTransport> root(new SocketTransport(0, size));
+    for (int i = 1; i < size; ++i)
+    {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0)
+        {
+            close(server);
+            throw runtime_error("Unable to accept worker: " + string(strerror(errno)));
+        }
+        // Workers introduce themselves with their rank
+        int32_t rank = 0;
+        receiveAll(client, reinterpret_cast<char *>(&rank), sizeof(rank));
+        if (rank <= 0 || rank >= size || root->sockets[rank] != -1)
+        {
+            close(client);
+            close(server);
+            throw runtime_error("Invalid worker rank: " + to_string(rank));
+        }
+        root->sockets[rank] = client;
+    }
+    close(server);
+    return root;
+}
+
+unique_ptr<SocketTransport> SocketTransport::connect(const string &host, unsigned short port, int rank, int size)
+{
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *found = nullptr;
+    if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &found) != 0 || found == nullptr)
+        throw runtime_error("Unable to resolve host: " + host);
+
+    int client = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+    if (client < 0 || ::connect(client, found->ai_addr, found->ai_addrlen) != 0)
+    {
+        freeaddrinfo(found);
+        if (client >= 0)
+            close(client);
+        throw runtime_error("Unable to connect to " + host + ":" + to_string(port));
+    }
+    freeaddrinfo(found);
+
+    int32_t id = rank;
+    sendAll(client, reinterpret_cast<const char *>(&id), sizeof(id));
+    unique_ptr<SocketTransport> worker(new SocketTransport(rank, size));
+    worker->sockets[0] = client;
+    return worker;
+}
+
+#else
+
+SocketTransport::~SocketTransport() = default;
+
+void SocketTransport::send(int, const vector<char> &)
+{
+    throw runtime_error("SocketTransport is not supported on this platform");
+}
+
+vector<char> SocketTransport::receive(int)
+{
+    throw runtime_error("SocketTransport is not supported on this platform");
+}
+
+unique_ptr<SocketTransport> SocketTransport::spawn(int)
+{
+    throw runtime_error("SocketTransport is not supported on this platform");
+}
+
+unique_ptr<SocketTransport> SocketTransport::listen(unsigned short, int)
+{
+    throw runtime_error("SocketTransport is not supported on this platform");
+}
+
+unique_ptr<SocketTransport> SocketTransport::connect(const string &, unsigned short, int, int)
+{
+    throw runtime_error("SocketTransport is not supported on this platform");
+}
+
+#endif
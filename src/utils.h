@@ -1,5 +1,7 @@
 #ifndef UTILS_H
 #define UTILS_H
+#include "io.h"
+#include "predicates.h"
 #include <gpolylla/polylla.h>
 #include <numeric>
 
@@ -22,7 +24,7 @@ constexpr int FACE_CONFIGURATION[4][3] = {
     {0, 1, 2}  // 3
 };
 
-constexpr float TOLERANCE = 0.00000001f;
+constexpr Real TOLERANCE = 0.00000001;
 
 template <typename T> bool sameContent(const T *a, const T *b, size_t size)
 {
@@ -47,21 +49,16 @@ template <typename T> bool sameContent(const T *a, const T *b, size_t size)
     }
     return same;
 }
-inline Eigen::Vector3f normal(const Vertex &v0, const Vertex &v1, const Vertex &v2)
+inline Vector3 normal(const Vertex &v0, const Vertex &v1, const Vertex &v2)
 {
     return (v1 - v0).cross(v2 - v0);
 }
 
-inline float signedSixthVolume(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3)
+inline Real signedSixthVolume(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3)
 {
-    return (v1 - v0).cross(v2 - v0).dot(v3 - v0);
+    return static_cast<Real>(orient3d(v0, v1, v2, v3));
 }
 
-inline bool isOutside(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &other)
-{
-    auto n = normal(v0, v1, v2);
-    return (other - v0).dot(n) <= 0;
-}
 inline int opposite(const Face &f, const Tetrahedron &tetra)
 {
 
@@ -73,42 +70,12 @@ inline int opposite(const Face &f, const Tetrahedron &tetra)
     return -1;
 }
 
-inline std::vector<std::array<int, 3>> getDirectedFaces(const Polyhedron& p, const PolyMesh& mesh)
+// Boundary faces of a polyhedron with their normals pointing outwards, the reverse of directedFaces
+inline std::vector<std::array<int, 3>> getDirectedFaces(const Polyhedron &p, const Mesh &mesh)
 {
-    std::vector<std::array<int, 3>> faces;
-    for (const int ti : p.cells)
-    {
-        const Tetrahedron &t = mesh.tetras[ti];
-        for (const int tetraFi : t.faces)
-        {
-
-            if (std::ranges::find(p.faces, tetraFi) == p.faces.end())
-                continue;
-
-            const Face &f = mesh.faces[tetraFi];
-            for (const int ref : t.vertices)
-            {
-                // Ref is the only vertex that is not part of the face
-                if (std::ranges::find(f.vertices, ref) != f.vertices.end())
-                    continue;
-
-                // Direct the face based on the reference vertex
-                auto vertices = f.vertices;
-                const Vertex &other = mesh.vertices[ref];
-                const Vertex &v0 = mesh.vertices[mesh.faces[tetraFi].vertices[0]];
-                const Vertex &v1 = mesh.vertices[mesh.faces[tetraFi].vertices[1]];
-                const Vertex &v2 = mesh.vertices[mesh.faces[tetraFi].vertices[2]];
-                if (!isOutside(v0, v1, v2, other))
-                {
-                    // If the reference vertex is inside, reverse the order
-                    std::ranges::reverse(vertices);
-                }
-                faces.push_back(vertices);
-                break;
-            }
-        }
-    }
-
+    auto faces = directedFaces(p, mesh);
+    for (auto &face : faces)
+        std::ranges::reverse(face);
     return faces;
 }
 
@@ -0,0 +1,494 @@
+#include "io.h"
+#include "parallel.h"
+#include "trace.h"
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Polylla;
+using namespace std;
+
+namespace
+{
+// Read only mapping of a whole file, unmapped on destruction
+class MappedFile
+{
+  public:
+#ifdef _WIN32
+    explicit MappedFile(const string &file)
+    {
+        HANDLE handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            throw FileNotFoundError("Cannot open VisF file: " + file);
+        LARGE_INTEGER length;
+        if (!GetFileSizeEx(handle, &length))
+        {
+            CloseHandle(handle);
+            throw runtime_error("Cannot stat VisF file: " + file);
+        }
+        size_ = static_cast<size_t>(length.QuadPart);
+        // An empty file cannot be mapped, it has no data
+        if (size_ > 0)
+        {
+            HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping)
+            {
+                data_ = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(handle);
+        if (size_ > 0 && !data_)
+            throw runtime_error("Cannot map VisF file: " + file);
+    }
+    ~MappedFile()
+    {
+        if (data_)
+            UnmapViewOfFile(data_);
+    }
+#else
+    explicit MappedFile(const string &file)
+    {
+        const int fd = open(file.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw FileNotFoundError("Cannot open VisF file: " + file);
+        struct stat info;
+        if (fstat(fd, &info) == -1)
+        {
+            close(fd);
+            throw runtime_error("Cannot stat VisF file: " + file);
+        }
+        size_ = info.st_size;
+        void *address = size_ > 0 ? mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        close(fd);
+        if (address == MAP_FAILED)
+            throw runtime_error("Cannot map VisF file: " + file);
+        data_ = static_cast<const char *>(address);
+        // The sections are parsed by several threads at once, so the whole file is read ahead
+        if (data_)
+            madvise(address, size_, MADV_WILLNEED);
+    }
+    ~MappedFile()
+    {
+        if (data_)
+            munmap(const_cast<char *>(data_), size_);
+    }
+#endif
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const
+    {
+        return data_;
+    }
+    size_t size() const
+    {
+        return size_;
+    }
+
+  private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// First item a parallel loop failed at, as workers cannot throw
+class Failure
+{
+  public:
+    void record(long long item)
+    {
+        long long current = first.load(memory_order_relaxed);
+        while (item < current && !first.compare_exchange_weak(current, item, memory_order_relaxed))
+            ;
+    }
+    bool failed() const
+    {
+        return first.load() != LLONG_MAX;
+    }
+    long long item() const
+    {
+        return first.load();
+    }
+
+  private:
+    atomic<long long> first = LLONG_MAX;
+};
+
+// Lines of the text, as [begin, end) offsets, split in parallel
+class Lines
+{
+  public:
+    Lines(const char *data, size_t size) : data(data)
+    {
+        constexpr size_t CHUNK = 1 << 20;
+        const int chunkCount = static_cast<int>((size + CHUNK - 1) / CHUNK);
+        auto chunkEnd = [&](int c) { return data + min(size, (c + 1) * CHUNK); };
+
+        // Newlines are counted per chunk, then every chunk writes the starts of its lines
+        vector<size_t> counts(chunkCount + 1, 0);
+        parallelFor(
+            chunkCount,
+            [&](int c) {
+                for (const char *p = data + c * CHUNK; (p = static_cast<const char *>(memchr(p, '\n', chunkEnd(c) - p)));
+                     ++p)
+                    counts[c + 1]++;
+            },
+            1);
+        for (int c = 0; c < chunkCount; ++c)
+            counts[c + 1] += counts[c];
+
+        starts.resize(counts.back() + 1);
+        starts[0] = 0;
+        parallelFor(
+            chunkCount,
+            [&](int c) {
+                size_t line = counts[c] + 1;
+                for (const char *p = data + c * CHUNK; (p = static_cast<const char *>(memchr(p, '\n', chunkEnd(c) - p)));
+                     ++p)
+                    starts[line++] = p + 1 - data;
+            },
+            1);
+        // Without a final newline the last line ends at the end of the file
+        if (starts.back() != size)
+            starts.push_back(size);
+    }
+
+    size_t size() const
+    {
+        return starts.size() - 1;
+    }
+    const char *begin(size_t line) const
+    {
+        return data + starts[line];
+    }
+    const char *end(size_t line) const
+    {
+        return data + starts[line + 1];
+    }
+
+  private:
+    const char *data;
+    vector<size_t> starts;
+};
+
+// Parses the next number of a line, false at its end or on anything else
+template <typename T> bool next(const char *&p, const char *end, T *value)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        ++p;
+    auto [last, error] = from_chars(p, end, *value);
+    if (error != errc())
+        return false;
+    p = last;
+    return true;
+}
+
+bool atEnd(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        ++p;
+    return p == end;
+}
+
+// Vertices of the faces of a polyhedron, sorted
+vector<int> polyhedronVertices(const vector<int> &faces, const vector<Face> &meshFaces)
+{
+    vector<int> vertices;
+    vertices.reserve(3 * faces.size());
+    for (int fi : faces)
+        vertices.insert(vertices.end(), meshFaces[fi].vertices.begin(), meshFaces[fi].vertices.end());
+    ranges::sort(vertices);
+    vertices.erase(ranges::unique(vertices).begin(), vertices.end());
+    return vertices;
+}
+
+class AsciiParser
+{
+  public:
+    AsciiParser(const MappedFile &file, const string &name, const ExecutionContext &context)
+        : lines(file.data(), file.size()), name(name), context(context)
+    {
+    }
+
+    PolyMesh parse()
+    {
+        PolyMesh mesh;
+        size_t line = 1;
+
+        context.phase("vertices");
+        const int vertexCount = count(line++);
+        section(line, vertexCount);
+        mesh.vertices.resize(vertexCount);
+        check(line, [&](int i, const char *p, const char *end) {
+            Real x, y, z;
+            if (!next(p, end, &x) || !next(p, end, &y) || !next(p, end, &z) || !atEnd(p, end))
+                return false;
+            mesh.vertices[i] = Vertex(x, y, z);
+            return true;
+        }, vertexCount);
+        line += vertexCount;
+
+        context.phase("faces");
+        const int faceCount = count(line++);
+        section(line, faceCount);
+        mesh.faces.resize(faceCount);
+        check(line, [&](int i, const char *p, const char *end) {
+            int n;
+            auto &vertices = mesh.faces[i].vertices;
+            if (!next(p, end, &n) || n != 3)
+                return false;
+            for (int &vi : vertices)
+            {
+                if (!next(p, end, &vi) || vi < 0 || vi >= vertexCount)
+                    return false;
+            }
+            return atEnd(p, end);
+        }, faceCount);
+        line += faceCount;
+
+        // Relations between polygons are never written, so none are expected
+        if (count(line++) != 0)
+            throw runtime_error("Polygon neighbours are not supported in VisF file: " + name);
+
+        context.phase("polyhedra");
+        const int cellCount = count(line++);
+        section(line, cellCount);
+        mesh.cells.resize(cellCount);
+        check(line, [&](int i, const char *p, const char *end) {
+            int n;
+            auto &faces = mesh.cells[i].faces;
+            // Every index takes at least two characters, which bounds what a broken count allocates
+            if (!next(p, end, &n) || n < 0 || n > end - p)
+                return false;
+            faces.resize(n);
+            for (int &fi : faces)
+            {
+                if (!next(p, end, &fi) || fi < 0 || fi >= faceCount)
+                    return false;
+            }
+            if (!atEnd(p, end))
+                return false;
+            mesh.cells[i].vertices = polyhedronVertices(faces, mesh.faces);
+            return true;
+        }, cellCount);
+        context.report(1);
+        return mesh;
+    }
+
+  private:
+    Lines lines;
+    const string &name;
+    const ExecutionContext &context;
+
+    [[noreturn]] void malformed(size_t line) const
+    {
+        throw runtime_error("Malformed VisF file " + name + " at line " + to_string(line + 1));
+    }
+
+    int count(size_t line) const
+    {
+        if (line >= lines.size())
+            throw runtime_error("Truncated VisF file: " + name);
+        const char *p = lines.begin(line);
+        int n;
+        if (!next(p, lines.end(line), &n) || n < 0 || !atEnd(p, lines.end(line)))
+            malformed(line);
+        return n;
+    }
+
+    void section(size_t first, int count) const
+    {
+        if (first + count > lines.size())
+            throw runtime_error("Truncated VisF file: " + name);
+    }
+
+    // Parses the lines [first, first + n) in parallel, throwing at the first one that fails
+    template <typename Parse> void check(size_t first, Parse &&parse, int n) const
+    {
+        Failure failure;
+        parallelFor(
+            n,
+            [&](int i) {
+                if (!parse(i, lines.begin(first + i), lines.end(first + i)))
+                    failure.record(i);
+            },
+            4096);
+        if (failure.failed())
+            malformed(first + failure.item());
+    }
+};
+
+class BinaryParser
+{
+  public:
+    BinaryParser(const MappedFile &file, size_t offset, bool bigEndian, const string &name,
+                 const ExecutionContext &context)
+        : data(file.data()), size(file.size()), offset(offset), swap(bigEndian != (endian::native == endian::big)),
+          name(name), context(context)
+    {
+    }
+
+    PolyMesh parse()
+    {
+        PolyMesh mesh;
+
+        context.phase("vertices");
+        const int vertexCount = count();
+        const size_t vertices = take(static_cast<size_t>(vertexCount) * 3 * sizeof(double));
+        mesh.vertices.resize(vertexCount);
+        parallelFor(
+            vertexCount,
+            [&](int i) {
+                const size_t at = vertices + static_cast<size_t>(i) * 3 * sizeof(double);
+                mesh.vertices[i] = Vertex(static_cast<Real>(load<double>(at)),
+                                          static_cast<Real>(load<double>(at + sizeof(double))),
+                                          static_cast<Real>(load<double>(at + 2 * sizeof(double))));
+            },
+            4096);
+
+        // Faces are all triangles, so their records have the same size
+        context.phase("faces");
+        const int faceCount = count();
+        const size_t faces = take(static_cast<size_t>(faceCount) * 4 * sizeof(int32_t));
+        mesh.faces.resize(faceCount);
+        Failure failure;
+        parallelFor(
+            faceCount,
+            [&](int i) {
+                const size_t at = faces + static_cast<size_t>(i) * 4 * sizeof(int32_t);
+                if (load<int32_t>(at) != 3)
+                    return failure.record(i);
+                for (int k = 0; k < 3; ++k)
+                {
+                    const int vi = load<int32_t>(at + (k + 1) * sizeof(int32_t));
+                    if (vi < 0 || vi >= vertexCount)
+                        return failure.record(i);
+                    mesh.faces[i].vertices[k] = vi;
+                }
+            },
+            4096);
+        if (failure.failed())
+            malformed("face", failure.item());
+
+        if (count() != 0)
+            throw runtime_error("Polygon neighbours are not supported in VisF file: " + name);
+
+        // Polyhedra records vary in size, so where each starts is found first
+        context.phase("polyhedra");
+        const int cellCount = count();
+        vector<size_t> starts(cellCount);
+        for (int i = 0; i < cellCount; ++i)
+        {
+            starts[i] = offset;
+            const int n = count();
+            take(static_cast<size_t>(n) * sizeof(int32_t));
+        }
+        mesh.cells.resize(cellCount);
+        parallelFor(
+            cellCount,
+            [&](int i) {
+                auto &faces = mesh.cells[i].faces;
+                faces.resize(load<int32_t>(starts[i]));
+                for (size_t k = 0; k < faces.size(); ++k)
+                {
+                    faces[k] = load<int32_t>(starts[i] + (k + 1) * sizeof(int32_t));
+                    if (faces[k] < 0 || faces[k] >= faceCount)
+                        return failure.record(i);
+                }
+                mesh.cells[i].vertices = polyhedronVertices(faces, mesh.faces);
+            },
+            1024);
+        if (failure.failed())
+            malformed("polyhedron", failure.item());
+        context.report(1);
+        return mesh;
+    }
+
+  private:
+    const char *data;
+    size_t size;
+    size_t offset;
+    bool swap;
+    const string &name;
+    const ExecutionContext &context;
+
+    [[noreturn]] void malformed(const string &item, long long index) const
+    {
+        throw runtime_error("Malformed VisF file " + name + " at " + item + " " + to_string(index));
+    }
+
+    template <typename T> T load(size_t at) const
+    {
+        using Bits = conditional_t<sizeof(T) == 8, uint64_t, uint32_t>;
+        Bits bits;
+        memcpy(&bits, data + at, sizeof(bits));
+        if (swap)
+        {
+            Bits swapped = 0;
+            for (size_t b = 0; b < sizeof(bits); ++b)
+                swapped |= ((bits >> (8 * b)) & 0xff) << (8 * (sizeof(bits) - 1 - b));
+            bits = swapped;
+        }
+        return bit_cast<T>(bits);
+    }
+
+    // Offset of the next bytes, which must be in the file
+    size_t take(size_t bytes)
+    {
+        if (bytes > size - offset)
+            throw runtime_error("Truncated VisF file: " + name);
+        const size_t at = offset;
+        offset += bytes;
+        return at;
+    }
+
+    int count()
+    {
+        const int n = load<int32_t>(take(sizeof(int32_t)));
+        if (n < 0)
+            throw runtime_error("Malformed VisF file " + name + " at offset " + to_string(offset));
+        return n;
+    }
+};
+} // namespace
+
+PolyMesh VisFReader::readMesh()
+{
+    GPOLYLLA_TRACE_SCOPE("VisFReader::readMesh");
+    ExecutionScope scope(context);
+    context.phase("read");
+    MappedFile file(inputFile);
+
+    // The header line says how the rest is stored
+    const char *end = file.size() > 0 ? static_cast<const char *>(memchr(file.data(), '\n', file.size())) : nullptr;
+    const char *p = file.data();
+    int format, type;
+    if (!end || !next(p, end, &format) || !next(p, end, &type) || !atEnd(p, end))
+        throw runtime_error("Missing VisF header in: " + inputFile);
+    if (type != 2)
+        throw runtime_error("Not a polyhedral VisF file: " + inputFile);
+
+    PolyMesh mesh;
+    if (format == 2)
+        mesh = AsciiParser(file, inputFile, context).parse();
+    else if (format == 0 || format == 1)
+        mesh = BinaryParser(file, end + 1 - file.data(), format == 0, inputFile, context).parse();
+    else
+        throw runtime_error("Unknown VisF format " + to_string(format) + " in: " + inputFile);
+    GPOLYLLA_TRACE_COUNTER("visfPolyhedra", mesh.cells.size());
+    return mesh;
+}
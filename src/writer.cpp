@@ -1,4 +1,9 @@
+#include "io.h"
+#include "trace.h"
 #include "utils.h"
+#include <bit>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 
 
@@ -11,66 +16,108 @@ struct DirectedInfo
     vector<vector<int>> cells;
 };
 
-bool isOutside(int fi, int vi, const PolyMesh &mesh)
+vector<array<int, 3>> Polylla::directedFaces(const Polyhedron &p, const Mesh &mesh)
 {
-    const Vertex &ref = mesh.vertices[vi];
-    const Vertex &v0 = mesh.vertices[mesh.faces[fi].vertices[0]];
-    const Vertex &v1 = mesh.vertices[mesh.faces[fi].vertices[1]];
-    const Vertex &v2 = mesh.vertices[mesh.faces[fi].vertices[2]];
-    const auto normal = (v1 - v0).cross(v2 - v0);
-    const auto toRef = ref - v0;
-    return normal.dot(toRef) > 0;
-}
+    vector<array<int, 3>> faces;
+    for (const int ti : p.cells)
+    {
+        const Tetrahedron &t = mesh.tetras[ti];
+        for (const int tetraFi : t.faces)
+        {
+
+            if (ranges::find(p.faces, tetraFi) == p.faces.end())
+                continue;
 
+            const Face &f = mesh.faces[tetraFi];
+            for (const int ref : t.vertices)
+            {
+                // Ref is the only vertex that is not part of the face
+                if (ranges::find(f.vertices, ref) != f.vertices.end())
+                    continue;
+
+                // Direct the face based on the reference vertex, the normal points towards it
+                auto vertices = f.vertices;
+                const auto &v = mesh.vertices;
+                if (orient3d(v[vertices[0]], v[vertices[1]], v[vertices[2]], v[ref]) <= 0)
+                {
+                    // If the reference vertex is not in front of the face, reverse the order
+                    ranges::reverse(vertices);
+                }
+                faces.push_back(vertices);
+                break;
+            }
+        }
+    }
+    return faces;
+}
 
 DirectedInfo getDirectedFacesFromMesh(PolyMesh *mesh)
 {
+    GPOLYLLA_TRACE_SCOPE("directedFaces");
     DirectedInfo info;
     info.cells.resize(mesh->cells.size());
     for (int pi = 0; pi < mesh->cells.size(); ++pi)
     {
-        const Polyhedron &p = mesh->cells[pi];
-        for (const int ti : p.cells)
+        for (const auto &vertices : directedFaces(mesh->cells[pi], *mesh))
         {
-            const Tetrahedron &t = mesh->tetras[ti];
-            for (const int tetraFi : t.faces)
-            {
-
-                if (ranges::find(p.faces, tetraFi) == p.faces.end())
-                    continue;
-
-                const Face &f = mesh->faces[tetraFi];
-                for (const int ref : t.vertices)
-                {
-                    // Ref is the only vertex that is not part of the face
-                    if (ranges::find(f.vertices, ref) != f.vertices.end())
-                        continue;
-
-                    // Direct the face based on the reference vertex
-                    auto vertices = f.vertices;
-                    if (!isOutside(tetraFi, ref, *mesh))
-                    {
-                        // If the reference vertex is inside, reverse the order
-                        ranges::reverse(vertices);
-                    }
-                    info.faces.push_back(vertices);
-
-                    info.cells[pi].push_back(info.faces.size() - 1);
-                    break;
-                }
-            }
+            info.faces.push_back(vertices);
+            info.cells[pi].push_back(info.faces.size() - 1);
         }
     }
     return info;
 };
 
+namespace
+{
+// Sections of a binary VisF after its header line: counts and indices as 32 bit integers, coordinates as 64 bit
+// floats, all in the native byte order
+void writeBinary(ofstream &file, const PolyMesh &mesh, const DirectedInfo &info, const ExecutionContext &context)
+{
+    auto put = [&](auto value) { file.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+    put(static_cast<int32_t>(mesh.vertices.size()));
+    for (const auto &v : mesh.vertices)
+    {
+        put(static_cast<double>(v.x()));
+        put(static_cast<double>(v.y()));
+        put(static_cast<double>(v.z()));
+    }
+    put(static_cast<int32_t>(info.faces.size()));
+    for (const auto &vertices : info.faces)
+    {
+        put(static_cast<int32_t>(vertices.size()));
+        for (int vi : vertices)
+            put(static_cast<int32_t>(vi));
+    }
+    put(int32_t(0));
+    put(static_cast<int32_t>(info.cells.size()));
+    for (int pi = 0; pi < info.cells.size(); ++pi)
+    {
+        if (pi % 4096 == 0)
+            context.report(static_cast<double>(pi) / info.cells.size());
+        put(static_cast<int32_t>(info.cells[pi].size()));
+        for (int fi : info.cells[pi])
+            put(static_cast<int32_t>(fi));
+    }
+}
+} // namespace
+
 void VisFWriter::writeMesh(PolyMesh mesh)
 {
-    ofstream file(outputFile);
+    GPOLYLLA_TRACE_SCOPE("VisFWriter::writeMesh");
+    ExecutionScope scope(context);
+    context.phase("write");
+    ofstream file(outputFile, binary ? ios::binary : ios::out);
     if (!file.is_open())
     {
         throw runtime_error("Unable to create file: " + outputFile);
     }
+    if (binary)
+    {
+        file << (endian::native == endian::big ? 0 : 1) << " " << 2 << "\n";
+        writeBinary(file, mesh, getDirectedFacesFromMesh(&mesh), context);
+        context.report(1);
+        return;
+    }
 
     // primer valor -> formato del archivo
     // 0 -> big endian
@@ -107,8 +154,11 @@ void VisFWriter::writeMesh(PolyMesh mesh)
     file << 0 << endl;
     // numero de poliedros y poliedros (basado en poligonos)
     file << info.cells.size() << endl;
-    for (const auto &faces : info.cells)
+    for (int pi = 0; pi < info.cells.size(); ++pi)
     {
+        if (pi % 4096 == 0)
+            context.report(static_cast<double>(pi) / info.cells.size());
+        const auto &faces = info.cells[pi];
         file << faces.size();
         for (int fi : faces)
         {
@@ -116,4 +166,87 @@ void VisFWriter::writeMesh(PolyMesh mesh)
         }
         file << endl;
     }
+    context.report(1);
+}
+
+// The face and polyhedron sections are spilled to side files because VisF stores their sizes first
+void VisFStreamWriter::begin(const std::vector<Vertex> &vertices)
+{
+    file = make_unique<ofstream>(outputFile);
+    if (!file->is_open())
+    {
+        throw runtime_error("Unable to create file: " + outputFile);
+    }
+    facesFile = make_unique<fstream>(outputFile + ".faces", ios::in | ios::out | ios::trunc);
+    cellsFile = make_unique<fstream>(outputFile + ".cells", ios::in | ios::out | ios::trunc);
+    if (!facesFile->is_open() || !cellsFile->is_open())
+    {
+        throw runtime_error("Unable to create spill files for: " + outputFile);
+    }
+    faceCount = 0;
+    cellCount = 0;
+
+    *file << 2 << " " << 2 << endl;
+    *file << vertices.size() << endl;
+    for (const auto &v : vertices)
+    {
+        *file << v.x() << " " << v.y() << " " << v.z() << endl;
+    }
+}
+
+void VisFStreamWriter::write(const std::vector<std::array<int, 3>> &faces)
+{
+    *cellsFile << faces.size();
+    for (const auto &vertices : faces)
+    {
+        *facesFile << vertices.size();
+        for (int vi : vertices)
+        {
+            *facesFile << " " << vi;
+        }
+        *facesFile << "\n";
+        *cellsFile << " " << faceCount++;
+    }
+    *cellsFile << "\n";
+    cellCount++;
+}
+
+void VisFStreamWriter::write(const Polyhedron &poly, const Mesh &mesh)
+{
+    write(directedFaces(poly, mesh));
+}
+
+void VisFStreamWriter::end()
+{
+    *file << faceCount << endl;
+    if (faceCount > 0)
+    {
+        facesFile->seekg(0);
+        *file << facesFile->rdbuf();
+    }
+
+    *file << 0 << endl;
+    *file << cellCount << endl;
+    if (cellCount > 0)
+    {
+        cellsFile->seekg(0);
+        *file << cellsFile->rdbuf();
+    }
+    file->close();
+
+    facesFile.reset();
+    cellsFile.reset();
+    file.reset();
+    std::remove((outputFile + ".faces").c_str());
+    std::remove((outputFile + ".cells").c_str());
+}
+
+void VisFStreamWriter::abort()
+{
+    facesFile.reset();
+    cellsFile.reset();
+    file.reset();
+    std::remove(outputFile.c_str());
+    std::remove((outputFile + ".faces").c_str());
+    std::remove((outputFile + ".cells").c_str());
 }
@@ -0,0 +1,151 @@
+#include "utils.h"
+#include <gpolylla/batch.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace Polylla;
+
+namespace
+{
+std::string readFile(const std::string &file)
+{
+    std::ifstream in(file);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+} // namespace
+
+TEST(BatchTest, GlobMatchesMeshes)
+{
+    auto jobs = BatchRunner::fromGlob(DATA_DIR "1000points*.node", TEMP_DIR "batch");
+    ASSERT_EQ(jobs.size(), 2);
+    EXPECT_EQ(std::filesystem::path(jobs[0].eleFile).filename(), "1000points.ele");
+    EXPECT_EQ(std::filesystem::path(jobs[1].nodeFile).filename(), "1000points07.node");
+    EXPECT_EQ(std::filesystem::path(jobs[1].outputFile), std::filesystem::path(TEMP_DIR "batch") / "1000points07.visf");
+    EXPECT_THROW(BatchRunner::fromGlob(DATA_DIR "nothing*", TEMP_DIR), std::runtime_error);
+}
+
+TEST(BatchTest, RunsEveryMeshInOrder)
+{
+    std::filesystem::create_directories(TEMP_DIR);
+    const std::string manifest = std::string(TEMP_DIR) + "batch.txt";
+    {
+        std::ofstream out(manifest);
+        out << "# Meshes of the test\n";
+        out << DATA_DIR "socket\n";
+        out << DATA_DIR "missing\n";
+        out << "\n" DATA_DIR "mage.node " DATA_DIR "mage.ele " TEMP_DIR "batch/mage_out.visf\n";
+        out << DATA_DIR "basic\n";
+    }
+
+    BatchRunner runner;
+    runner.jobs = BatchRunner::fromManifest(manifest, TEMP_DIR "batch");
+    ASSERT_EQ(runner.jobs.size(), 4);
+    std::vector<std::string> done;
+    runner.onDone = [&](const BatchRunner::Result &r) { done.push_back(r.job.eleFile); };
+    const auto &results = runner.run();
+
+    ASSERT_EQ(done.size(), 4);
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(done[i], runner.jobs[i].eleFile);
+    EXPECT_FALSE(results[1].error.empty());
+    for (int i : {0, 2, 3})
+    {
+        ASSERT_TRUE(results[i].error.empty()) << results[i].error;
+        EXPECT_TRUE(std::filesystem::exists(results[i].job.outputFile));
+        EXPECT_EQ(results[i].report.phases.size(), 3);
+    }
+    EXPECT_EQ(std::filesystem::path(results[2].job.outputFile).filename(), "mage_out.visf");
+
+    // Same polyhedra as a run of its own
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "socket.node";
+    reader.eleFile = DATA_DIR "socket.ele";
+    EXPECT_EQ(results[0].polyhedra, CavityAlgorithm()(reader.readMesh()).cells.size());
+
+    const std::string report = std::string(TEMP_DIR) + "batch/batch.json";
+    runner.writeReport(report);
+    const std::string json = readFile(report);
+    EXPECT_NE(json.find("\"meshes\": 4"), std::string::npos);
+    EXPECT_NE(json.find("\"failed\": 1"), std::string::npos);
+    EXPECT_NE(json.find("\"error\": "), std::string::npos);
+}
+
+TEST(BatchTest, ThrowingOnDoneStopsTheRun)
+{
+    BatchRunner runner;
+    for (const char *name : {"basic", "socket", "mage", "1000points"})
+        runner.jobs.push_back({DATA_DIR + std::string(name) + ".node", DATA_DIR + std::string(name) + ".ele",
+                               TEMP_DIR "batch/" + std::string(name) + "_stop.visf"});
+    int done = 0;
+    runner.onDone = [&](const BatchRunner::Result &) {
+        if (++done == 2)
+            throw std::runtime_error("stop");
+    };
+    EXPECT_THROW(runner.run(), std::runtime_error);
+    EXPECT_EQ(done, 2);
+}
+
+TEST(PipelineTest, MatchesSequentialRun)
+{
+    std::filesystem::create_directories(TEMP_DIR);
+    for (bool mergeLoners : {false, true})
+    {
+        PipelineRunner pipeline;
+        pipeline.nodeFile = DATA_DIR "mage.node";
+        pipeline.eleFile = DATA_DIR "mage.ele";
+        pipeline.outputFile = std::string(TEMP_DIR) + "pipeline.visf";
+        pipeline.makeStats = true;
+        pipeline.algorithm.mergeLoners = mergeLoners;
+        PolyMesh result = pipeline.run();
+        EXPECT_EQ(pipeline.report.phases.size(), 4);
+
+        TetgenReader reader;
+        reader.nodeFile = DATA_DIR "mage.node";
+        reader.eleFile = DATA_DIR "mage.ele";
+        CavityAlgorithm algorithm;
+        algorithm.mergeLoners = mergeLoners;
+        PolyMesh expected = algorithm(reader.readMesh());
+        ASSERT_EQ(result.cells.size(), expected.cells.size());
+
+        VisFWriter writer;
+        writer.outputFile = std::string(TEMP_DIR) + "sequential.visf";
+        writer.writeMesh(expected);
+        EXPECT_EQ(readFile(pipeline.outputFile), readFile(writer.outputFile));
+
+        auto stats = computeStats(expected);
+        ASSERT_EQ(pipeline.stats.size(), stats.size());
+        for (int pi = 0; pi < stats.size(); ++pi)
+        {
+            EXPECT_EQ(pipeline.stats[pi].edgeRatio, stats[pi].edgeRatio);
+            EXPECT_EQ(pipeline.stats[pi].surfaceRatio, stats[pi].surfaceRatio);
+        }
+    }
+}
+
+TEST(PipelineTest, ReportsUnwritableOutput)
+{
+    PipelineRunner pipeline;
+    pipeline.nodeFile = DATA_DIR "socket.node";
+    pipeline.eleFile = DATA_DIR "socket.ele";
+    pipeline.outputFile = std::string(TEMP_DIR) + "missing/dir/pipeline.visf";
+    EXPECT_THROW(pipeline.run(), std::runtime_error);
+}
+
+TEST(PipelineTest, FailedRunLeavesNoOutput)
+{
+    std::filesystem::create_directories(TEMP_DIR);
+    PipelineRunner pipeline;
+    pipeline.nodeFile = DATA_DIR "socket.node";
+    pipeline.eleFile = DATA_DIR "socket.ele";
+    pipeline.outputFile = std::string(TEMP_DIR) + "cancelled.visf";
+    std::stop_source stop;
+    stop.request_stop();
+    pipeline.algorithm.context.stop = stop.get_token();
+    EXPECT_THROW(pipeline.run(), CancelledError);
+    EXPECT_FALSE(std::filesystem::exists(pipeline.outputFile));
+    EXPECT_FALSE(std::filesystem::exists(pipeline.outputFile + ".faces"));
+    EXPECT_FALSE(std::filesystem::exists(pipeline.outputFile + ".cells"));
+}
@@ -0,0 +1,139 @@
+#include "io.h"
+#include "utils.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace Polylla;
+
+class CavityIndexTest : public ::testing::Test
+{
+  protected:
+    CavityAlgorithm algorithm;
+    std::vector<Vertex> points;
+
+    void SetUp() override
+    {
+        TetgenReader reader;
+        reader.nodeFile = DATA_DIR "1000points.node";
+        reader.eleFile = DATA_DIR "1000points.ele";
+        Mesh mesh = reader.readMesh();
+        algorithm(mesh);
+
+        // Mesh vertices plus random points around the mesh
+        Box3 bounds;
+        for (const auto &v : mesh.vertices)
+            bounds.extend(v);
+        std::mt19937 random(42);
+        for (int i = 0; i < 200; ++i)
+        {
+            Vector3 t(std::uniform_real_distribution<Real>(-0.1, 1.1)(random),
+                              std::uniform_real_distribution<Real>(-0.1, 1.1)(random),
+                              std::uniform_real_distribution<Real>(-0.1, 1.1)(random));
+            points.emplace_back(bounds.min() + bounds.sizes().cwiseProduct(t));
+        }
+        for (int i = 0; i < mesh.vertices.size(); i += 10)
+            points.push_back(mesh.vertices[i]);
+    }
+
+    template <typename Accept> std::vector<int> scan(Accept accept) const
+    {
+        std::vector<int> found;
+        for (int ci = 0; ci < algorithm.cavities().size(); ++ci)
+        {
+            if (accept(algorithm.cavities()[ci]))
+                found.push_back(ci);
+        }
+        return found;
+    }
+
+    static std::vector<int> sorted(std::vector<int> values)
+    {
+        std::ranges::sort(values);
+        return values;
+    }
+};
+
+TEST_F(CavityIndexTest, ContainingMatchesLinearScan)
+{
+    const CavityIndex &index = algorithm.index();
+    for (const auto &p : points)
+    {
+        auto expected = scan([&](const CavityAlgorithm::Cavity &c) { return c.isInside(p); });
+        EXPECT_EQ(sorted(index.containing(p)), expected);
+    }
+}
+
+TEST_F(CavityIndexTest, WithinRadiusMatchesLinearScan)
+{
+    const CavityIndex &index = algorithm.index();
+    const Real radius = 0.05;
+    for (const auto &p : points)
+    {
+        auto expected =
+            scan([&](const CavityAlgorithm::Cavity &c) {
+                return (c.center - p.cast<double>()).squaredNorm() <= static_cast<double>(radius) * radius;
+            });
+        EXPECT_EQ(sorted(index.withinRadius(p, radius)), expected);
+    }
+}
+
+TEST_F(CavityIndexTest, NearestMatchesLinearScan)
+{
+    const CavityIndex &index = algorithm.index();
+    const auto &cavities = algorithm.cavities();
+    for (const auto &p : points)
+    {
+        std::vector<std::pair<Real, int>> expected;
+        for (int ci = 0; ci < cavities.size(); ++ci)
+            expected.emplace_back(static_cast<Real>((cavities[ci].center - p.cast<double>()).norm()), ci);
+        std::ranges::sort(expected);
+
+        auto found = index.nearest(p, 8);
+        ASSERT_EQ(found.size(), 8);
+        for (int i = 0; i < found.size(); ++i)
+            EXPECT_EQ(found[i], expected[i].second);
+    }
+}
+
+TEST_F(CavityIndexTest, ConcurrentCallsShareOneIndex)
+{
+    std::vector<const CavityIndex *> indices(4);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < indices.size(); ++i)
+        threads.emplace_back([&, i] { indices[i] = &algorithm.index(); });
+    for (auto &thread : threads)
+        thread.join();
+    for (const CavityIndex *index : indices)
+        EXPECT_EQ(index, indices.front());
+    EXPECT_EQ(indices.front()->cavities().size(), algorithm.cavities().size());
+}
+
+TEST(CavityIndexFlatTest, FlatCavityFoundAtItsCenter)
+{
+    Mesh mesh;
+    mesh.vertices = {Vertex(0, 0, 0), Vertex(1, 0, 0), Vertex(0, 1, 0), Vertex(1, 1, 0)};
+    mesh.tetras = {Tetrahedron(0, 1, 2, 3)};
+    mesh.faces = buildFaces(mesh.vertices, mesh.tetras);
+    buildConnectivity(&mesh);
+    CavityAlgorithm algorithm;
+    algorithm(mesh);
+    const CavityIndex &index = algorithm.index();
+
+    EXPECT_TRUE(index.containing(mesh.vertices[0]).empty());
+    EXPECT_EQ(index.withinRadius(Vertex(0.1f, 0, 0), 0.2f), std::vector<int>{0});
+    EXPECT_EQ(index.nearest(Vertex(1, 1, 1), 1), std::vector<int>{0});
+}
+
+TEST(BvhTest, EmptyAndSingleBox)
+{
+    Bvh empty(std::vector<Box3>{});
+    EXPECT_TRUE(empty.empty());
+    EXPECT_TRUE(empty.nearest(Vector3::Zero(), 3, [](int) { return Real(0); }).empty());
+
+    Bvh single({Box3(Vector3::Zero(), Vector3::Ones())});
+    int visited = 0;
+    single.traverse([](const Box3 &box) { return box.contains(Vector3(0.5, 0.5, 0.5)); },
+                    [&](int item) { visited += item + 1; });
+    EXPECT_EQ(visited, 1);
+}
@@ -1,4 +1,5 @@
 #include "utils.h"
+#include "io.h"
 
 using namespace Polylla;
 
@@ -29,3 +30,83 @@ TEST_F(CavityTest, BasicPolyMeshCreation) {
     checkSimilar(result.tetras, BASIC_POLY_MESH.tetras, "Tetras");
     checkSimilar(result.cells, BASIC_POLY_MESH.cells, "Cells");
 }
+
+TEST(CavityLonersTest, MergeLoners)
+{
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "mage.node";
+    reader.eleFile = DATA_DIR "mage.ele";
+    Mesh mesh = reader.readMesh();
+
+    CavityAlgorithm plain;
+    PolyMesh before = plain(mesh);
+    CavityAlgorithm merging;
+    merging.mergeLoners = true;
+    PolyMesh after = merging(mesh);
+
+    int loners = 0;
+    for (const auto &poly : before.cells)
+        loners += poly.cells.size() == 1;
+    ASSERT_GT(loners, 0);
+    EXPECT_LT(after.cells.size(), before.cells.size());
+
+    std::vector<int> uses(mesh.faces.size(), 0);
+    size_t tetras = 0;
+    for (int pi = 0; pi < after.cells.size(); ++pi)
+    {
+        const auto &poly = after.cells[pi];
+        EXPECT_GT(poly.cells.size(), 1) << "Polyhedron " << pi;
+        tetras += poly.cells.size();
+        for (int ti : poly.cells)
+        {
+            EXPECT_EQ(after.tetras[ti].polyhedron, pi);
+            EXPECT_EQ(merging.owners()[ti], merging.owners()[poly.cells[0]]);
+        }
+        for (int fi : poly.faces)
+            ++uses[fi];
+    }
+    EXPECT_EQ(tetras, mesh.tetras.size());
+    for (int fi = 0; fi < mesh.faces.size(); ++fi)
+    {
+        const Face &face = mesh.faces[fi];
+        const bool inside =
+            face.tetras[1] != -1 && after.tetras[face.tetras[0]].polyhedron == after.tetras[face.tetras[1]].polyhedron;
+        EXPECT_EQ(uses[fi], inside ? 0 : (face.tetras[1] == -1 ? 1 : 2)) << "Face " << fi;
+    }
+
+    // Polyhedra without loners around them are kept whole
+    for (const auto &poly : before.cells)
+    {
+        const auto &merged = after.cells[after.tetras[poly.cells[0]].polyhedron].cells;
+        for (int ti : poly.cells)
+            EXPECT_EQ(after.tetras[ti].polyhedron, after.tetras[poly.cells[0]].polyhedron);
+        EXPECT_GE(merged.size(), poly.cells.size());
+    }
+}
+
+// The sphere of a nearly flat tetrahedron is large and keeps its double precision, even in a float build
+TEST(CavityPrecisionTest, NearlyFlatTetrahedronKeepsItsRadius)
+{
+    Mesh mesh;
+    mesh.vertices = {Vertex(0, 0, 0), Vertex(1, 0, 0), Vertex(0, 1, 0), Vertex(0.3f, 0.7f, 1e-3f)};
+    mesh.tetras = {Tetrahedron(0, 1, 2, 3)};
+    mesh.faces = buildFaces(mesh.vertices, mesh.tetras);
+    buildConnectivity(&mesh);
+    CavityAlgorithm algorithm;
+    algorithm(mesh);
+
+    // The same circumcenter in extended precision, from the coordinates as stored
+    using Vector3l = Eigen::Matrix<long double, 3, 1>;
+    const Vector3l p0 = mesh.vertices[0].cast<long double>();
+    const Vector3l b = mesh.vertices[1].cast<long double>() - p0;
+    const Vector3l c = mesh.vertices[2].cast<long double>() - p0;
+    const Vector3l d = mesh.vertices[3].cast<long double>() - p0;
+    const Vector3l offset = (b.squaredNorm() * c.cross(d) + c.squaredNorm() * d.cross(b) + d.squaredNorm() * b.cross(c)) /
+                            (2 * b.cross(c).dot(d));
+    const long double radius = offset.norm();
+
+    const auto &cavity = algorithm.cavities()[0];
+    EXPECT_GT(radius, 100);
+    EXPECT_NEAR(cavity.radius, static_cast<double>(radius), 1e-12 * radius);
+    EXPECT_NEAR((cavity.center - (p0 + offset).cast<double>()).norm(), 0, 1e-12 * radius);
+}
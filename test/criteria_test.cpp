@@ -0,0 +1,101 @@
+#include "utils.h"
+#include <gpolylla/criteria.h>
+
+using namespace Polylla;
+
+namespace
+{
+// A criterion written outside the library, checked at compile time like the built-in ones
+struct SameParityCriterion
+{
+    const Mesh *mesh = nullptr;
+
+    void bind(const Mesh &m)
+    {
+        mesh = &m;
+    }
+    bool operator()(int fi) const
+    {
+        const Face &face = mesh->faces[fi];
+        return face.tetras[0] % 2 == face.tetras[1] % 2;
+    }
+};
+
+static_assert(FaceCriterion<AreaCriterion>);
+static_assert(FaceCriterion<VolumeRatioCriterion>);
+static_assert(FaceCriterion<SameParityCriterion>);
+static_assert(GrowthCriterion<CavityCriterion>);
+static_assert(!GrowthCriterion<AreaCriterion>);
+} // namespace
+
+class CriteriaTest : public ::testing::TestWithParam<std::string>
+{
+  protected:
+    Mesh mesh;
+
+    void SetUp() override
+    {
+        mesh = readData(GetParam());
+    }
+};
+
+TEST_P(CriteriaTest, CavityCriterionMatchesCavityAlgorithm)
+{
+    GrowAlgorithm<CavityCriterion> grow;
+    CavityAlgorithm cavity;
+    PolyMesh a = grow(mesh);
+    PolyMesh b = cavity(mesh);
+    ASSERT_EQ(a.cells.size(), b.cells.size());
+    for (int pi = 0; pi < a.cells.size(); ++pi)
+    {
+        EXPECT_EQ(a.cells[pi].cells, b.cells[pi].cells) << "Polyhedron " << pi;
+        EXPECT_EQ(a.cells[pi].faces, b.cells[pi].faces) << "Polyhedron " << pi;
+        EXPECT_EQ(a.cells[pi].vertices, b.cells[pi].vertices) << "Polyhedron " << pi;
+    }
+}
+
+TEST_P(CriteriaTest, AreaCriterionMatchesFaceAlgorithm)
+{
+    MergeAlgorithm<AreaCriterion> merge;
+    FaceAlgorithm face;
+    PolyMesh a = merge(mesh);
+    PolyMesh b = face(mesh);
+    ASSERT_EQ(a.cells.size(), b.cells.size());
+    // Same polyhedra, only numbered differently
+    for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+        EXPECT_EQ(a.cells[a.tetras[ti].polyhedron].cells, b.cells[b.tetras[ti].polyhedron].cells);
+}
+
+TEST_P(CriteriaTest, VolumeRatioJoinsSimilarTetrahedra)
+{
+    MergeAlgorithm<VolumeRatioCriterion> merge;
+    merge.merge.ratio = 0.8;
+    PolyMesh result = merge(mesh);
+    for (const Face &face : mesh.faces)
+    {
+        if (face.tetras[1] == -1)
+            continue;
+        const Real a = std::abs(mesh.tetras[face.tetras[0]].volume(mesh));
+        const Real b = std::abs(mesh.tetras[face.tetras[1]].volume(mesh));
+        if (std::min(a, b) >= 0.8 * std::max(a, b))
+        {
+            EXPECT_EQ(result.tetras[face.tetras[0]].polyhedron, result.tetras[face.tetras[1]].polyhedron);
+        }
+    }
+
+    merge.merge.ratio = 2;
+    EXPECT_EQ(merge(mesh).cells.size(), mesh.tetras.size());
+}
+
+TEST_P(CriteriaTest, CustomCriterion)
+{
+    MergeAlgorithm<SameParityCriterion> merge;
+    PolyMesh result = merge(mesh);
+    for (const auto &poly : result.cells)
+    {
+        for (int ti : poly.cells)
+            EXPECT_EQ(ti % 2, poly.cells[0] % 2);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Meshes, CriteriaTest, ::testing::Values("1000points", "socket", "mage"));
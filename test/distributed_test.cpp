@@ -0,0 +1,115 @@
+#include "utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <set>
+
+using namespace Polylla;
+
+#ifndef _WIN32
+
+class DistributedTest : public ::testing::TestWithParam<std::string>
+{
+  protected:
+    static std::set<std::vector<int>> sortedCells(const PolyMesh &mesh)
+    {
+        std::set<std::vector<int>> cells;
+        for (auto poly : mesh.cells)
+        {
+            std::ranges::sort(poly.cells);
+            cells.insert(poly.cells);
+        }
+        return cells;
+    }
+
+    // Runs the algorithm over forked workers, which exit as soon as they are done
+    static PolyMesh runDistributed(const Mesh &mesh, int ranks, const std::string &shardPrefix = "")
+    {
+        auto transport = SocketTransport::spawn(ranks);
+        DistributedCavityAlgorithm algorithm;
+        algorithm.transport = transport.get();
+        algorithm.shardPrefix = shardPrefix;
+        if (transport->rank() != 0)
+        {
+            try
+            {
+                algorithm.serve();
+            }
+            catch (...)
+            {
+                std::_Exit(1);
+            }
+            std::_Exit(0);
+        }
+        return algorithm(mesh);
+    }
+};
+
+// Polyhedra near range boundaries may differ from the in-core ones, only the partition is guaranteed
+TEST_P(DistributedTest, EveryTetrahedronInOnePolyhedron)
+{
+    Mesh mesh = readData(GetParam());
+    PolyMesh result = runDistributed(mesh, 3);
+
+    std::vector<int> tetras;
+    for (int pi = 0; pi < result.cells.size(); ++pi)
+    {
+        for (int ti : result.cells[pi].cells)
+        {
+            EXPECT_EQ(result.tetras[ti].polyhedron, pi);
+            tetras.push_back(ti);
+        }
+    }
+    std::ranges::sort(tetras);
+    std::vector<int> expected(mesh.tetras.size());
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(tetras, expected);
+}
+
+TEST_P(DistributedTest, OneRankSameCellsAsInMemory)
+{
+    Mesh mesh = readData(GetParam());
+    PolyMesh expected = CavityAlgorithm()(mesh);
+    PolyMesh result = runDistributed(mesh, 1);
+
+    EXPECT_EQ(result.cells.size(), expected.cells.size());
+    EXPECT_EQ(sortedCells(result), sortedCells(expected));
+}
+
+TEST_P(DistributedTest, ShardsCoverEveryPolyhedron)
+{
+    const std::string name = GetParam();
+    const std::string prefix = std::string(TEMP_DIR) + name + "_distributed";
+    Mesh mesh = readData(name);
+    PolyMesh result = runDistributed(mesh, 3, prefix);
+
+    size_t cells = 0;
+    for (int r = 0; r < 3; ++r)
+    {
+        const std::string file = prefix + "_" + std::to_string(r) + ".visf";
+        ASSERT_TRUE(std::filesystem::exists(file));
+        std::ifstream in(file);
+        int format, type, count;
+        in >> format >> type >> count;
+        float x, y, z;
+        for (int i = 0; i < count; ++i)
+            in >> x >> y >> z;
+        in >> count;
+        std::string line;
+        std::getline(in, line);
+        for (int i = 0; i < count; ++i)
+            std::getline(in, line);
+        int neighbours, polys;
+        in >> neighbours >> polys;
+        cells += polys;
+        in.close();
+        std::filesystem::remove(file);
+    }
+    EXPECT_EQ(cells, result.cells.size());
+}
+
+INSTANTIATE_TEST_SUITE_P(DataMeshes, DistributedTest, ::testing::Values("basic", "3D_100", "socket", "1000points", "mage", "1000points07"));
+
+#endif
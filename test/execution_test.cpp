@@ -0,0 +1,196 @@
+#include "parallel.h"
+#include "utils.h"
+#include <gpolylla/execution.h>
+#include <gpolylla/stat.h>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace Polylla;
+
+namespace
+{
+// Counts what is allocated through it, forwarding to the default resource
+class CountingResource : public std::pmr::memory_resource
+{
+  public:
+    std::atomic<std::size_t> bytes = 0;
+
+  private:
+    void *do_allocate(std::size_t size, std::size_t alignment) override
+    {
+        bytes += size;
+        return std::pmr::get_default_resource()->allocate(size, alignment);
+    }
+    void do_deallocate(void *p, std::size_t size, std::size_t alignment) override
+    {
+        std::pmr::get_default_resource()->deallocate(p, size, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+ExecutionContext withThreads(int threads)
+{
+    ExecutionContext context;
+    context.threads = threads;
+    return context;
+}
+
+// Threads a parallel loop runs on
+int threadsUsed()
+{
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    parallelFor(
+        1 << 16,
+        [&](int) {
+            std::lock_guard lock(mutex);
+            ids.insert(std::this_thread::get_id());
+        },
+        1);
+    return static_cast<int>(ids.size());
+}
+} // namespace
+
+TEST(ExecutionTest, ScopesLimitThreads)
+{
+    const int hardware = threadCount();
+    EXPECT_EQ(threadLimit(), 0);
+    {
+        ExecutionScope outer(withThreads(2));
+        EXPECT_EQ(threadCount(), std::min(hardware, 2));
+        EXPECT_LE(threadsUsed(), 2);
+        {
+            // Nested scopes only narrow the limit
+            ExecutionScope wider(withThreads(8));
+            EXPECT_EQ(threadLimit(), 2);
+            ExecutionScope narrower(withThreads(1));
+            EXPECT_EQ(threadsUsed(), 1);
+        }
+        EXPECT_EQ(threadLimit(), 2);
+
+        // Workers of a parallel loop keep the limit of the thread that started it
+        std::atomic<int> maxLimit = 0;
+        parallelFor(
+            hardware, [&](int) { maxLimit = std::max(maxLimit.load(), threadLimit()); }, 1);
+        EXPECT_EQ(maxLimit, 2);
+    }
+    EXPECT_EQ(threadLimit(), 0);
+    EXPECT_EQ(threadCount(), hardware);
+}
+
+TEST(ExecutionTest, StopTokenCancels)
+{
+    Mesh mesh = BASIC_MESH;
+    std::stop_source source;
+    ExecutionContext context;
+    context.stop = source.get_token();
+    EXPECT_NO_THROW(context.check());
+    source.request_stop();
+    EXPECT_TRUE(context.cancelled());
+    EXPECT_THROW(context.check(), CancelledError);
+
+    CavityAlgorithm cavity;
+    cavity.context = context;
+    EXPECT_THROW(cavity(mesh), CancelledError);
+    FaceAlgorithm face;
+    face.context = context;
+    EXPECT_THROW(face(mesh), CancelledError);
+    EXPECT_THROW(computeStats(CavityAlgorithm()(mesh), context), CancelledError);
+}
+
+TEST(ExecutionTest, RunsUseTheMemoryResource)
+{
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "mage.node";
+    reader.eleFile = DATA_DIR "mage.ele";
+    Mesh mesh = reader.readMesh();
+
+    CountingResource memory;
+    FaceAlgorithm algorithm;
+    algorithm.context.memory = &memory;
+    algorithm.context.threads = 2;
+    PolyMesh result = algorithm(mesh);
+    EXPECT_GE(memory.bytes, 2 * mesh.tetras.size() * sizeof(int));
+    EXPECT_EQ(memoryResource(), std::pmr::get_default_resource());
+
+    // The same polyhedra as with the default context
+    EXPECT_EQ(FaceAlgorithm()(mesh).cells.size(), result.cells.size());
+}
+
+TEST(ExecutionTest, CavityRunsUseTheMemoryResource)
+{
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "mage.node";
+    reader.eleFile = DATA_DIR "mage.ele";
+    Mesh mesh = reader.readMesh();
+
+    CountingResource merged;
+    CavityAlgorithm cavity;
+    cavity.mergeLoners = true;
+    cavity.context.memory = &merged;
+    PolyMesh result = cavity(mesh);
+    EXPECT_GE(merged.bytes, mesh.tetras.size() * (2 * sizeof(int) + sizeof(char)));
+    CavityAlgorithm plain;
+    plain.mergeLoners = true;
+    EXPECT_EQ(plain(mesh).cells.size(), result.cells.size());
+
+    CountingResource distributed;
+    DistributedCavityAlgorithm ranks;
+    ranks.context.memory = &distributed;
+    result = ranks(mesh);
+    EXPECT_GE(distributed.bytes, mesh.tetras.size() * (sizeof(Vector3) + 4 * sizeof(int)));
+    EXPECT_EQ(CavityAlgorithm()(mesh).cells.size(), result.cells.size());
+}
+
+TEST(ExecutionTest, TasksRethrowTheFirstExceptionOnceAllAreDone)
+{
+    std::atomic<int> running = 0;
+    auto task = [&](int t) {
+        running++;
+        if (t == 2)
+        {
+            running--;
+            throw CancelledError("task " + std::to_string(t));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        running--;
+    };
+    EXPECT_THROW(runTasks(4, task), CancelledError);
+    EXPECT_EQ(running, 0);
+    // The pool is still usable
+    std::atomic<int> done = 0;
+    runTasks(4, [&](int) { done++; });
+    EXPECT_EQ(done, 4);
+}
+
+TEST(ExecutionTest, TasksReuseThePoolThreads)
+{
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    for (int call = 0; call < 20; ++call)
+    {
+        runTasks(4, [&](int) {
+            std::lock_guard lock(mutex);
+            ids.insert(std::this_thread::get_id());
+        });
+    }
+    EXPECT_LE(ids.size(), std::max(4u, std::thread::hardware_concurrency()));
+}
+
+TEST(ExecutionTest, NestedTasksFinish)
+{
+    std::atomic<int> done = 0;
+    runTasks(3, [&](int) { runTasks(3, [&](int) { done++; }); });
+    EXPECT_EQ(done, 9);
+
+    // Tasks run under the scope of the thread that started them
+    ExecutionScope scope(withThreads(2));
+    std::atomic<int> limits = 0;
+    runTasks(3, [&](int) { limits += threadLimit(); });
+    EXPECT_EQ(limits, 6);
+}
@@ -0,0 +1,126 @@
+#include "utils.h"
+#include <gpolylla/generator.h>
+
+using namespace Polylla;
+
+TEST(FaceTest, BasicPolyMeshCreation)
+{
+    // The corners join the central tetrahedron through their largest face
+    FaceAlgorithm algorithm;
+    PolyMesh result = algorithm(BASIC_MESH);
+    checkSimilar(result.cells, BASIC_POLY_MESH.cells, "Cells");
+    EXPECT_EQ(algorithm.seeds().size(), 1);
+}
+
+class FaceMeshTest : public ::testing::TestWithParam<std::string>
+{
+  protected:
+    Mesh mesh;
+
+    void SetUp() override
+    {
+        mesh = readData(GetParam());
+    }
+};
+
+TEST_P(FaceMeshTest, JoinsAcrossLargestFaces)
+{
+    FaceAlgorithm algorithm;
+    PolyMesh result = algorithm(mesh);
+    const auto &fittests = algorithm.fittests();
+    ASSERT_EQ(result.cells.size(), algorithm.seeds().size());
+
+    for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+    {
+        const int pi = result.tetras[ti].polyhedron;
+        ASSERT_GE(pi, 0) << "Tetrahedron " << ti;
+        // No face of the tetrahedron is larger than its fittest one
+        const Real best = mesh.faces[fittests[ti]].area(mesh);
+        for (int fi : mesh.tetras[ti].faces)
+            EXPECT_LE(mesh.faces[fi].area(mesh), best);
+
+        const Face &face = mesh.faces[fittests[ti]];
+        const int next = face.tetras[0] == ti ? face.tetras[1] : face.tetras[0];
+        if (next != -1)
+        {
+            EXPECT_EQ(result.tetras[next].polyhedron, pi) << "Tetrahedron " << ti;
+        }
+    }
+
+    // Each polyhedron holds its terminal face and no other
+    std::vector<int> terminals(result.cells.size(), 0);
+    for (int fi : algorithm.seeds())
+    {
+        const Face &face = mesh.faces[fi];
+        ++terminals[result.tetras[face.tetras[0] != -1 ? face.tetras[0] : face.tetras[1]].polyhedron];
+    }
+    for (int pi = 0; pi < result.cells.size(); ++pi)
+        EXPECT_EQ(terminals[pi], 1) << "Polyhedron " << pi;
+}
+
+TEST_P(FaceMeshTest, EmitsEveryBoundaryFaceOnce)
+{
+    FaceAlgorithm algorithm;
+    PolyMesh result = algorithm(mesh);
+
+    std::vector<int> uses(mesh.faces.size(), 0);
+    size_t tetras = 0;
+    for (const auto &poly : result.cells)
+    {
+        tetras += poly.cells.size();
+        for (int fi : poly.faces)
+            ++uses[fi];
+    }
+    EXPECT_EQ(tetras, mesh.tetras.size());
+    for (int fi = 0; fi < mesh.faces.size(); ++fi)
+    {
+        const Face &face = mesh.faces[fi];
+        int expected = 0;
+        if (face.tetras[1] == -1)
+            expected = 1;
+        else if (result.tetras[face.tetras[0]].polyhedron != result.tetras[face.tetras[1]].polyhedron)
+            expected = 2;
+        EXPECT_EQ(uses[fi], expected) << "Face " << fi;
+    }
+}
+
+TEST_P(FaceMeshTest, IsDeterministic)
+{
+    FaceAlgorithm first, second;
+    PolyMesh a = first(mesh);
+    PolyMesh b = second(mesh);
+    ASSERT_EQ(a.cells.size(), b.cells.size());
+    for (int pi = 0; pi < a.cells.size(); ++pi)
+    {
+        EXPECT_EQ(a.cells[pi].cells, b.cells[pi].cells);
+        EXPECT_EQ(a.cells[pi].faces, b.cells[pi].faces);
+        EXPECT_EQ(a.cells[pi].vertices, b.cells[pi].vertices);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Meshes, FaceMeshTest, ::testing::Values("1000points", "socket", "mage"));
+
+TEST(FaceTest, LargeLattice)
+{
+    // Enough tetrahedra for the unions to run on every thread
+    LatticeGenerator generator;
+    generator.resize(200000);
+    generator.jitter = 0.12;
+    Mesh mesh = generator.readMesh();
+
+    FaceAlgorithm algorithm;
+    PolyMesh result = algorithm(mesh);
+    for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+    {
+        const Face &face = mesh.faces[algorithm.fittests()[ti]];
+        const int next = face.tetras[0] == ti ? face.tetras[1] : face.tetras[0];
+        if (next != -1)
+        {
+            ASSERT_EQ(result.tetras[next].polyhedron, result.tetras[ti].polyhedron);
+        }
+    }
+    size_t tetras = 0;
+    for (const auto &poly : result.cells)
+        tetras += poly.cells.size();
+    EXPECT_EQ(tetras, mesh.tetras.size());
+}
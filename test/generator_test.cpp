@@ -0,0 +1,92 @@
+#include "predicates.h"
+#include "utils.h"
+#include <gpolylla/generator.h>
+#include <filesystem>
+
+using namespace Polylla;
+
+class GeneratorSplitTest : public ::testing::TestWithParam<LatticeGenerator::Split>
+{
+  protected:
+    LatticeGenerator generator;
+
+    void SetUp() override
+    {
+        generator.cells = {4, 3, 5};
+        generator.size = Vector3(2, 1, 3);
+        generator.split = GetParam();
+        generator.grading = 4;
+        generator.seed = 11;
+    }
+};
+
+TEST_P(GeneratorSplitTest, ConformingPositiveTetras)
+{
+    Mesh mesh = generator.readMesh();
+    ASSERT_EQ(mesh.vertices.size(), generator.vertexCount());
+    ASSERT_EQ(mesh.tetras.size(), generator.tetraCount());
+
+    // Two triangles per boundary square, every other face shared by two tetrahedra
+    const auto &c = generator.cells;
+    int boundary = 0;
+    for (const auto &f : mesh.faces)
+    {
+        ASSERT_NE(f.tetras[0], -1);
+        if (f.tetras[1] == -1)
+            ++boundary;
+    }
+    EXPECT_EQ(boundary, 4 * (c[0] * c[1] + c[1] * c[2] + c[0] * c[2]));
+
+    double volume = 0;
+    for (const auto &t : mesh.tetras)
+    {
+        const auto &v = t.vertices;
+        double sixth = orient3d(mesh.vertices[v[0]], mesh.vertices[v[1]], mesh.vertices[v[2]], mesh.vertices[v[3]]);
+        ASSERT_GT(sixth, 0);
+        volume += sixth / 6;
+    }
+    EXPECT_NEAR(volume, 6.0, 1e-4);
+}
+
+TEST_P(GeneratorSplitTest, DeterministicBySeed)
+{
+    Mesh first = generator.readMesh();
+    Mesh again = generator.readMesh();
+    generator.seed = 12;
+    Mesh other = generator.readMesh();
+    EXPECT_EQ(first.vertices, again.vertices);
+    EXPECT_NE(first.vertices, other.vertices);
+}
+
+TEST_P(GeneratorSplitTest, TetgenRoundTrip)
+{
+    std::filesystem::create_directories(TEMP_DIR);
+    const std::string prefix = std::string(TEMP_DIR) + "lattice";
+    generator.writeTetgen(prefix + ".node", prefix + ".ele");
+    TetgenReader reader;
+    reader.nodeFile = prefix + ".node";
+    reader.eleFile = prefix + ".ele";
+    Mesh read = reader.readMesh();
+    Mesh generated = generator.readMesh();
+    EXPECT_EQ(read.vertices, generated.vertices);
+    ASSERT_EQ(read.tetras.size(), generated.tetras.size());
+    for (int ti = 0; ti < read.tetras.size(); ++ti)
+        EXPECT_EQ(read.tetras[ti].vertices, generated.tetras[ti].vertices);
+
+    CavityAlgorithm algorithm;
+    EXPECT_FALSE(algorithm(read).cells.empty());
+}
+
+INSTANTIATE_TEST_SUITE_P(Splits, GeneratorSplitTest,
+                         ::testing::Values(LatticeGenerator::Split::Five, LatticeGenerator::Split::Six));
+
+TEST(GeneratorTest, ResizeReachesTetraCount)
+{
+    LatticeGenerator generator;
+    generator.resize(100000);
+    EXPECT_GE(generator.tetraCount(), 100000);
+    EXPECT_LT(generator.tetraCount(), 130000);
+    generator.split = LatticeGenerator::Split::Five;
+    generator.resize(1000);
+    EXPECT_EQ(generator.cells[0], 6);
+}
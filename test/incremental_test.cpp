@@ -0,0 +1,149 @@
+#include "io.h"
+#include "utils.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace Polylla;
+
+class IncrementalMeshTest : public ::testing::TestWithParam<std::string>
+{
+  protected:
+    Mesh mesh;
+    CavityAlgorithm algorithm;
+
+    void SetUp() override
+    {
+        mesh = readData(GetParam());
+        algorithm(mesh);
+    }
+
+    static Mesh rebuild(std::vector<Vertex> vertices, const std::vector<Tetrahedron> &tetras)
+    {
+        Mesh edited;
+        edited.vertices = std::move(vertices);
+        for (const auto &t : tetras)
+            edited.tetras.emplace_back(t.vertices);
+        edited.faces = buildFaces(edited.vertices, edited.tetras);
+        buildConnectivity(&edited);
+        return edited;
+    }
+
+    // Applies the edit and checks the update against a run on the edited mesh
+    void check(Mesh edited, const std::vector<int> &previous)
+    {
+        std::vector<std::vector<int>> reported;
+        algorithm.onPolyhedron = [&](const Polyhedron &poly) { reported.push_back(poly.cells); };
+        PolyMesh updated = algorithm.update(edited, previous);
+        algorithm.onPolyhedron = nullptr;
+        CavityAlgorithm full;
+        PolyMesh expected = full(edited);
+
+        ASSERT_EQ(updated.cells.size(), expected.cells.size());
+        ASSERT_EQ(reported.size(), expected.cells.size());
+        for (int pi = 0; pi < expected.cells.size(); ++pi)
+        {
+            EXPECT_EQ(reported[pi], expected.cells[pi].cells) << "Polyhedron " << pi;
+            EXPECT_EQ(updated.cells[pi].cells, expected.cells[pi].cells) << "Polyhedron " << pi;
+            EXPECT_EQ(updated.cells[pi].faces, expected.cells[pi].faces) << "Polyhedron " << pi;
+            EXPECT_EQ(updated.cells[pi].vertices, expected.cells[pi].vertices) << "Polyhedron " << pi;
+        }
+        for (int ti = 0; ti < expected.tetras.size(); ++ti)
+            ASSERT_EQ(updated.tetras[ti].polyhedron, expected.tetras[ti].polyhedron) << "Tetrahedron " << ti;
+        EXPECT_EQ(algorithm.owners(), full.owners());
+        EXPECT_EQ(algorithm.seeds(), full.seeds());
+        mesh = std::move(edited);
+    }
+
+    void moveVertex(int vi, const Vector3 &offset)
+    {
+        auto vertices = mesh.vertices;
+        vertices[vi] += offset;
+        std::vector<int> previous(mesh.tetras.size());
+        for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+        {
+            const auto &v = mesh.tetras[ti].vertices;
+            previous[ti] = std::ranges::find(v, vi) == v.end() ? ti : -1;
+        }
+        check(rebuild(vertices, mesh.tetras), previous);
+    }
+
+    // Replaces the tetrahedron by four around its centroid, appended at the end
+    void splitTetra(int ti)
+    {
+        auto vertices = mesh.vertices;
+        const auto v = mesh.tetras[ti].vertices;
+        Vector3 center = Vector3::Zero();
+        for (int vi : v)
+            center += mesh.vertices[vi];
+        vertices.emplace_back(center / 4);
+        int c = vertices.size() - 1;
+
+        std::vector<Tetrahedron> tetras;
+        std::vector<int> previous;
+        for (int tj = 0; tj < mesh.tetras.size(); ++tj)
+        {
+            if (tj == ti)
+                continue;
+            tetras.push_back(mesh.tetras[tj]);
+            previous.push_back(tj);
+        }
+        for (auto face : {std::array{v[0], v[1], v[2], c}, std::array{v[0], v[1], c, v[3]},
+                          std::array{v[0], c, v[2], v[3]}, std::array{c, v[1], v[2], v[3]}})
+        {
+            tetras.emplace_back(face);
+            previous.push_back(-1);
+        }
+        check(rebuild(vertices, tetras), previous);
+    }
+};
+
+TEST_P(IncrementalMeshTest, MoveVertex)
+{
+    Box3 bounds;
+    for (const auto &v : mesh.vertices)
+        bounds.extend(v);
+    const Real step = bounds.diagonal().norm() / std::cbrt(static_cast<Real>(mesh.tetras.size()));
+    for (int vi : {3, static_cast<int>(mesh.vertices.size() / 2), static_cast<int>(mesh.vertices.size()) - 5})
+        moveVertex(vi, Vector3(0.2f, -0.1f, 0.15f) * step);
+}
+
+TEST_P(IncrementalMeshTest, SplitTetra)
+{
+    splitTetra(1);
+    splitTetra(mesh.tetras.size() / 3);
+    splitTetra(mesh.tetras.size() - 1);
+}
+
+TEST_P(IncrementalMeshTest, Reindex)
+{
+    std::vector<int> previous(mesh.tetras.size());
+    std::iota(previous.begin(), previous.end(), 0);
+    std::ranges::shuffle(previous, std::mt19937(7));
+    std::vector<Tetrahedron> tetras;
+    for (int ti : previous)
+        tetras.push_back(mesh.tetras[ti]);
+    check(rebuild(mesh.vertices, tetras), previous);
+}
+
+INSTANTIATE_TEST_SUITE_P(Meshes, IncrementalMeshTest, ::testing::Values("basic", "1000points", "socket", "mage"));
+
+TEST(IncrementalTest, RejectsMismatchedIndices)
+{
+    CavityAlgorithm algorithm;
+    algorithm(BASIC_MESH);
+    EXPECT_THROW(algorithm.update(BASIC_MESH, {0, 1}), std::runtime_error);
+    EXPECT_THROW(algorithm.update(BASIC_MESH, {0, 0, 1, 2, 3}), std::runtime_error);
+}
+
+TEST(IncrementalTest, StopsWhenCancelled)
+{
+    CavityAlgorithm algorithm;
+    algorithm(BASIC_MESH);
+    std::stop_source stop;
+    stop.request_stop();
+    algorithm.context.stop = stop.get_token();
+    std::vector<int> previous(BASIC_MESH.tetras.size());
+    std::iota(previous.begin(), previous.end(), 0);
+    EXPECT_THROW(algorithm.update(BASIC_MESH, previous), CancelledError);
+}
@@ -0,0 +1,89 @@
+#include "utils.h"
+#include <gpolylla/merge.h>
+#include <numeric>
+
+using namespace Polylla;
+
+namespace
+{
+// Plain sequential sets to check the concurrent ones against
+int findRoot(std::vector<int> &parents, int x)
+{
+    while (parents[x] != x)
+        x = parents[x] = parents[parents[x]];
+    return x;
+}
+} // namespace
+
+TEST(MergeTest, AllFacesGiveOnePolyhedron)
+{
+    MergeAlgorithm algorithm([](int) { return true; });
+    PolyMesh result = algorithm(BASIC_MESH);
+    checkSimilar(result.cells, BASIC_POLY_MESH.cells, "Cells");
+}
+
+TEST(MergeTest, NoFacesGiveTheTetrahedra)
+{
+    PolyhedraCsr csr = mergeFaces(BASIC_MESH, [](int) { return false; });
+    ASSERT_EQ(csr.size(), BASIC_MESH.tetras.size());
+    for (int pi = 0; pi < csr.size(); ++pi)
+    {
+        EXPECT_EQ(csr.tetras[pi], pi);
+        EXPECT_EQ(csr.faceOffsets[pi + 1] - csr.faceOffsets[pi], 4);
+        EXPECT_EQ(csr.vertexOffsets[pi + 1] - csr.vertexOffsets[pi], 4);
+    }
+}
+
+TEST(MergeTest, MatchesSequentialSets)
+{
+    Mesh mesh = readData("mage");
+    auto merge = [](int fi) { return (fi * 2654435761u >> 7) % 3 != 0; };
+    PolyhedraCsr csr = mergeFaces(mesh, merge);
+
+    std::vector<int> parents(mesh.tetras.size());
+    std::iota(parents.begin(), parents.end(), 0);
+    for (int fi = 0; fi < mesh.faces.size(); ++fi)
+    {
+        const Face &face = mesh.faces[fi];
+        if (face.tetras[1] != -1 && merge(fi))
+            parents[findRoot(parents, face.tetras[0])] = findRoot(parents, face.tetras[1]);
+    }
+
+    // Same partition, polyhedra ordered by their first tetrahedron
+    std::vector<int> firsts;
+    for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+    {
+        const int pi = csr.owners[ti];
+        ASSERT_EQ(csr.owners[csr.tetras[csr.tetraOffsets[pi]]], pi);
+        EXPECT_EQ(findRoot(parents, ti), findRoot(parents, csr.tetras[csr.tetraOffsets[pi]])) << "Tetrahedron " << ti;
+        if (csr.tetras[csr.tetraOffsets[pi]] == ti)
+            firsts.push_back(pi);
+    }
+    ASSERT_EQ(firsts.size(), csr.size());
+    for (int i = 0; i < firsts.size(); ++i)
+        EXPECT_EQ(firsts[i], i);
+
+    // Faces between polyhedra are listed by both, boundary faces by one
+    std::vector<int> uses(mesh.faces.size(), 0);
+    for (int fi : csr.faces)
+        ++uses[fi];
+    for (int fi = 0; fi < mesh.faces.size(); ++fi)
+    {
+        const Face &face = mesh.faces[fi];
+        const bool inside = face.tetras[1] != -1 && csr.owners[face.tetras[0]] == csr.owners[face.tetras[1]];
+        EXPECT_EQ(uses[fi], inside ? 0 : (face.tetras[1] == -1 ? 1 : 2)) << "Face " << fi;
+    }
+}
+
+TEST(MergeTest, FollowsTheGivenOrder)
+{
+    UnionFind sets(static_cast<int>(BASIC_MESH.tetras.size()));
+    sets.unite(0, 4);
+    sets.unite(1, 2);
+    PolyhedraCsr csr = assemblePolyhedra(BASIC_MESH, sets, {3, 2, 4});
+    EXPECT_EQ(csr.owners, std::vector<int>({2, 1, 1, 0, 2}));
+    EXPECT_EQ(csr.tetras, std::vector<int>({3, 1, 2, 0, 4}));
+
+    EXPECT_THROW(assemblePolyhedra(BASIC_MESH, sets, {3, 2}), std::invalid_argument);
+    EXPECT_THROW(assemblePolyhedra(BASIC_MESH, sets, {3, 2, 4, 0}), std::invalid_argument);
+}
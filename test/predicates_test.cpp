@@ -0,0 +1,108 @@
+#include "utils.h"
+#include <cmath>
+#include "io.h"
+#include <predicates.h>
+#include <random>
+
+using namespace Polylla;
+
+// Differences of integer coordinates below 2^20 fit in 20 bits, so every product of the determinant fits in 60
+static int exactOrientSign(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3)
+{
+    auto diff = [](const Vertex &a, const Vertex &b, int i) {
+        return static_cast<long long>(a[i]) - static_cast<long long>(b[i]);
+    };
+    long long u[3], v[3], w[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        u[i] = diff(v1, v0, i);
+        v[i] = diff(v2, v0, i);
+        w[i] = diff(v3, v0, i);
+    }
+    long long det = u[0] * (v[1] * w[2] - v[2] * w[1]) + u[1] * (v[2] * w[0] - v[0] * w[2]) +
+                   u[2] * (v[0] * w[1] - v[1] * w[0]);
+    return (det > 0) - (det < 0);
+}
+
+static int sign(double value)
+{
+    return (value > 0) - (value < 0);
+}
+
+TEST(PredicatesTest, OrientationOfUnitTetrahedron)
+{
+    Vertex v0(0, 0, 0), v1(1, 0, 0), v2(0, 1, 0), v3(0, 0, 1);
+    EXPECT_DOUBLE_EQ(orient3d(v0, v1, v2, v3), 1.0);
+    EXPECT_DOUBLE_EQ(orient3d(v0, v2, v1, v3), -1.0);
+    EXPECT_EQ(orient3d(v0, v1, v2, Vertex(0.25f, 0.5f, 0)), 0.0);
+}
+
+TEST(PredicatesTest, NearlyCoplanarSignsAreExact)
+{
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> coordinate(1 << 17, 1 << 18);
+    std::uniform_int_distribution<int> jitter(-1, 1);
+    std::uniform_int_distribution<int> weight(-1, 2);
+
+    predicateCounters() = {};
+    int zeros = 0;
+    for (int i = 0; i < 20000; ++i)
+    {
+        Vertex v0(coordinate(random), coordinate(random), coordinate(random));
+        Vertex v1(coordinate(random), coordinate(random), coordinate(random));
+        Vertex v2(coordinate(random), coordinate(random), coordinate(random));
+        // On the plane of the others, moved by at most one unit
+        Vector3 p = v0 + Real(weight(random)) * (v1 - v0) + Real(weight(random)) * (v2 - v0);
+        Vertex v3(p.x() + jitter(random), p.y(), p.z());
+
+        int expected = exactOrientSign(v0, v1, v2, v3);
+        zeros += expected == 0;
+        ASSERT_EQ(sign(orient3d(v0, v1, v2, v3)), expected) << "iteration " << i;
+    }
+    EXPECT_GT(zeros, 0);
+    EXPECT_GT(predicateCounters().exact, 0);
+}
+
+TEST(PredicatesTest, SphereSideOnTheSphere)
+{
+    Vertex center(0, 0, 0);
+    EXPECT_EQ(sphereSide(center, 5.0, Vertex(3, 4, 0)), 0.0);
+    EXPECT_GT(sphereSide(center, 5.0, Vertex(3, std::nextafter(4.0f, 5.0f), 0)), 0.0);
+    EXPECT_LT(sphereSide(center, 5.0, Vertex(3, std::nextafter(4.0f, 3.0f), 0)), 0.0);
+
+    CavityAlgorithm::Cavity cavity{5.0, center.cast<double>(), 0};
+    EXPECT_TRUE(cavity.isInside(Vertex(3, 4, 0)));
+    EXPECT_FALSE(cavity.isInside(Vertex(3, std::nextafter(4.0f, 5.0f), 0)));
+}
+
+TEST(PredicatesTest, FlatTetrahedronHasNoSphere)
+{
+    Mesh mesh;
+    mesh.vertices = {Vertex(0, 0, 0), Vertex(1, 0, 0), Vertex(0, 1, 0), Vertex(1, 1, 0)};
+    mesh.tetras = {Tetrahedron(0, 1, 2, 3)};
+    mesh.faces = buildFaces(mesh.vertices, mesh.tetras);
+    buildConnectivity(&mesh);
+    CavityAlgorithm algorithm;
+    algorithm(mesh);
+    EXPECT_TRUE(std::isinf(algorithm.cavities()[0].radius));
+    EXPECT_FALSE(algorithm.cavities()[0].isInside(Vertex(0.5f, 0.5f, 0)));
+}
+
+TEST(PredicatesTest, FastPathOnDataMeshes)
+{
+    for (const std::string name : {"socket", "1000points", "mage"})
+    {
+        Mesh mesh = readData(name);
+
+        predicateCounters() = {};
+        PolyMesh result = CavityAlgorithm()(mesh);
+        VisFWriter writer;
+        writer.outputFile = std::string(TEMP_DIR) + name + "_predicates.visf";
+        writer.writeMesh(result);
+        std::remove(writer.outputFile.c_str());
+
+        const auto counters = predicateCounters();
+        ASSERT_GT(counters.calls, 0);
+        EXPECT_LT(static_cast<double>(counters.exact) / counters.calls, 0.01) << name;
+    }
+}
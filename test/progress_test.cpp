@@ -0,0 +1,67 @@
+#include "utils.h"
+#include <gpolylla/progress.h>
+#include <gpolylla/stat.h>
+
+using namespace Polylla;
+
+TEST(ProgressTest, ReportsAndCancels)
+{
+    Progress progress;
+    progress.phase("first");
+    progress.report(0.5);
+    EXPECT_EQ(progress.currentPhase(), "first");
+    EXPECT_EQ(progress.fraction(), 0.5);
+    progress.phase("second");
+    EXPECT_EQ(progress.fraction(), 0);
+
+    progress.cancel();
+    EXPECT_TRUE(progress.cancelled());
+    EXPECT_THROW(progress.report(0.75), CancelledError);
+    // The fraction reached is kept for the one watching
+    EXPECT_EQ(progress.fraction(), 0.75);
+}
+
+TEST(ProgressTest, RunsEndComplete)
+{
+    Progress progress;
+    TetgenReader reader;
+    reader.context.progress = &progress;
+    reader.nodeFile = DATA_DIR "mage.node";
+    reader.eleFile = DATA_DIR "mage.ele";
+    Mesh mesh = reader.readMesh();
+    EXPECT_EQ(progress.currentPhase(), "connectivity");
+    EXPECT_EQ(progress.fraction(), 1);
+
+    CavityAlgorithm algorithm;
+    algorithm.context.progress = &progress;
+    PolyMesh result = algorithm(mesh);
+    EXPECT_EQ(progress.currentPhase(), "cavities");
+    EXPECT_EQ(progress.fraction(), 1);
+
+    // Reporting does not change the result
+    CavityAlgorithm plain;
+    EXPECT_EQ(plain(mesh).cells.size(), result.cells.size());
+}
+
+TEST(ProgressTest, CancelStopsTheRun)
+{
+    Mesh mesh = readData("mage");
+    Progress progress;
+    CavityAlgorithm algorithm;
+    algorithm.context.progress = &progress;
+    // Cancelled from inside, the seed loop stops at its next report
+    int grown = 0;
+    algorithm.onPolyhedron = [&](const Polyhedron &) {
+        if (++grown == 1)
+            progress.cancel();
+    };
+    EXPECT_THROW(algorithm(mesh), CancelledError);
+    EXPECT_LT(grown, mesh.tetras.size() / 2);
+
+    Progress cancelled;
+    cancelled.cancel();
+    PolyMesh result = CavityAlgorithm()(mesh);
+    ExecutionContext context;
+    context.progress = &cancelled;
+    EXPECT_THROW(computeStats(result, context), CancelledError);
+}
@@ -0,0 +1,314 @@
+#include "utils.h"
+#include <gpolylla/render.h>
+#include <gpolylla/stat.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace Polylla;
+
+namespace
+{
+Vector3 toVector(const float (&values)[3])
+{
+    return Vector3(values[0], values[1], values[2]);
+}
+
+// Sides expected on the surface, straight from the definition
+std::vector<int> expectedSides(const Mesh &mesh, const std::vector<char> &visible, const std::vector<int> &groups)
+{
+    std::vector<int> sides;
+    for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            const Face &face = mesh.faces[mesh.tetras[ti].faces[k]];
+            const int next = face.tetras[0] == ti ? face.tetras[1] : face.tetras[0];
+            if (visible[ti] && (next == -1 || !visible[next] || (!groups.empty() && groups[next] != groups[ti])))
+                sides.push_back(4 * ti + k);
+        }
+    }
+    return sides;
+}
+
+std::vector<int> sorted(std::vector<int> values)
+{
+    std::ranges::sort(values);
+    return values;
+}
+
+// Column major perspective projection as glm::perspective builds it, the eye at the origin looking down -z
+std::array<float, 16> perspective(float fovY, float aspect, float near, float far)
+{
+    const float f = 1 / std::tan(fovY / 2);
+    std::array<float, 16> m{};
+    m[0] = f / aspect;
+    m[5] = f;
+    m[10] = (far + near) / (near - far);
+    m[11] = -1;
+    m[14] = 2 * far * near / (near - far);
+    return m;
+}
+
+Box3 cube(const Vector3 &center, Real half)
+{
+    return Box3(center - Vector3::Constant(half), center + Vector3::Constant(half));
+}
+} // namespace
+
+TEST(CellBufferTest, PacksEveryFaceOfEveryCell)
+{
+    CellBuffer buffer = buildCellBuffer(BASIC_MESH);
+    ASSERT_EQ(buffer.cellCount(), BASIC_MESH.tetras.size());
+    ASSERT_EQ(buffer.vertices.size(), BASIC_MESH.tetras.size() * CellBuffer::VERTICES_PER_CELL);
+
+    for (int ti = 0; ti < BASIC_MESH.tetras.size(); ++ti)
+    {
+        const Tetrahedron &tetra = BASIC_MESH.tetras[ti];
+        Vector3 center = Vector3::Zero();
+        for (int vi : tetra.vertices)
+            center += BASIC_MESH.vertices[vi] / 4;
+
+        for (int k = 0; k < 4; ++k)
+        {
+            const CellVertex *triangle = buffer.vertices.data() + CellBuffer::first(ti) + 3 * k;
+            const Vector3 a = toVector(triangle[0].position), b = toVector(triangle[1].position),
+                          c = toVector(triangle[2].position);
+            const Vector3 normal = toVector(triangle[0].normal);
+            EXPECT_NEAR(normal.norm(), 1, 1e-5) << "Cell " << ti;
+            // Counter-clockwise from outside, and the normal points away from the cell
+            EXPECT_GT((b - a).cross(c - a).dot(normal), 0) << "Cell " << ti;
+            EXPECT_GT((a - center).dot(normal), 0) << "Cell " << ti;
+            for (int j = 0; j < 3; ++j)
+            {
+                EXPECT_EQ(triangle[j].cell, ti);
+                EXPECT_EQ(toVector(triangle[j].normal), normal);
+            }
+        }
+    }
+}
+
+TEST(CellBufferTest, TrianglesAreTheFacesOfTheCell)
+{
+    CellBuffer buffer = buildCellBuffer(BASIC_MESH);
+    for (int ti = 0; ti < BASIC_MESH.tetras.size(); ++ti)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            const Face &face = BASIC_MESH.faces[BASIC_MESH.tetras[ti].faces[k]];
+            for (int j = 0; j < 3; ++j)
+            {
+                const Vector3 p = toVector(buffer.vertices[CellBuffer::first(ti) + 3 * k + j].position);
+                bool found = false;
+                for (int vi : face.vertices)
+                    found = found || p == BASIC_MESH.vertices[vi];
+                EXPECT_TRUE(found) << "Cell " << ti << " face " << k;
+            }
+        }
+    }
+}
+
+TEST(VisibleSurfaceTest, BoundaryOfTheCube)
+{
+    VisibleSurface surface(BASIC_MESH);
+    ASSERT_EQ(surface.sides().size(), 12);
+    ASSERT_EQ(surface.triangles().size(), 12);
+    const Vector3 center(0.5, 0.5, 0.5);
+    for (int i = 0; i < surface.sides().size(); ++i)
+    {
+        const int side = surface.sides()[i];
+        EXPECT_EQ(BASIC_MESH.faces[BASIC_MESH.tetras[side / 4].faces[side % 4]].tetras[1], -1);
+        const auto &t = surface.triangles()[i];
+        const Vector3 a = BASIC_MESH.vertices[t[0]], b = BASIC_MESH.vertices[t[1]], c = BASIC_MESH.vertices[t[2]];
+        EXPECT_GT((b - a).cross(c - a).dot(a - center), 0) << "Side " << side;
+    }
+
+    // Every tetrahedron its own group shows both sides of the four inner faces
+    VisibleSurface apart(BASIC_MESH, {0, 1, 2, 3, 4});
+    EXPECT_EQ(apart.sides().size(), 20);
+}
+
+TEST(VisibleSurfaceTest, HidingUpdatesTheSides)
+{
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "mage.node";
+    reader.eleFile = DATA_DIR "mage.ele";
+    Mesh mesh = reader.readMesh();
+    std::vector<int> groups(mesh.tetras.size());
+    for (int ti = 0; ti < groups.size(); ++ti)
+        groups[ti] = ti / 7;
+
+    for (const auto &grouping : {std::vector<int>(), groups})
+    {
+        VisibleSurface surface(mesh, grouping);
+        std::vector<char> visible(mesh.tetras.size(), 1);
+        ASSERT_EQ(sorted(surface.sides()), expectedSides(mesh, visible, grouping));
+
+        std::mt19937 random(3);
+        std::uniform_int_distribution<int> pick(0, mesh.tetras.size() - 1);
+        for (int round = 0; round < 5; ++round)
+        {
+            for (int i = 0; i < 2000; ++i)
+            {
+                const int ti = pick(random);
+                visible[ti] = round % 2 == 0 ? 0 : random() % 2;
+                surface.setVisible(ti, visible[ti]);
+            }
+            ASSERT_EQ(sorted(surface.sides()), expectedSides(mesh, visible, grouping)) << "Round " << round;
+            for (int i = 0; i < surface.sides().size(); ++i)
+            {
+                const int side = surface.sides()[i];
+                const auto &corners = mesh.faces[mesh.tetras[side / 4].faces[side % 4]].vertices;
+                EXPECT_TRUE(std::ranges::is_permutation(surface.triangles()[i], corners)) << "Side " << side;
+            }
+        }
+    }
+}
+
+TEST(HullBufferTest, HullOfTheCube)
+{
+    HullBuffer buffer = buildHullBuffer(BASIC_POLY_MESH);
+    ASSERT_EQ(buffer.offsets.size(), 2);
+    ASSERT_EQ(buffer.offsets[1], buffer.vertices.size());
+    // Two triangles per side, whatever way QuickHull splits them
+    ASSERT_EQ(buffer.vertices.size(), 12 * 3);
+    const Vector3 center(0.5, 0.5, 0.5);
+    for (int i = 0; i < buffer.vertices.size(); i += 3)
+    {
+        const Vector3 a = toVector(buffer.vertices[i].position), b = toVector(buffer.vertices[i + 1].position),
+                      c = toVector(buffer.vertices[i + 2].position);
+        EXPECT_GT((b - a).cross(c - a).dot(a - center), 0) << "Triangle " << i / 3;
+        EXPECT_GT(toVector(buffer.vertices[i].normal).dot(a - center), 0) << "Triangle " << i / 3;
+        EXPECT_EQ(buffer.vertices[i].cell, BASIC_POLY_MESH.cells[0].cells.front());
+    }
+
+    // The hulls of the stats give the same buffer
+    HullBuffer fromStats = buildHullBuffer(BASIC_POLY_MESH, computeStats(BASIC_POLY_MESH));
+    EXPECT_EQ(fromStats.offsets, buffer.offsets);
+}
+
+TEST(FrustumTest, KeepsTheBoxesInView)
+{
+    const auto projection = perspective(1.0f, 1.5f, 0.1f, 100.0f);
+    Frustum frustum = Frustum::fromMatrix(projection.data());
+    EXPECT_TRUE(frustum.intersects(cube(Vector3(0, 0, -5), 0.5f)));
+    // Straddling the left plane
+    EXPECT_TRUE(frustum.intersects(cube(Vector3(-4, 0, -5), 1.5f)));
+    // Behind the eye, beside the view and past the far plane
+    EXPECT_FALSE(frustum.intersects(cube(Vector3(0, 0, 5), 0.5f)));
+    EXPECT_FALSE(frustum.intersects(cube(Vector3(20, 0, -5), 0.5f)));
+    EXPECT_FALSE(frustum.intersects(cube(Vector3(0, 0, -200), 0.5f)));
+    EXPECT_FALSE(frustum.intersects(Box3()));
+}
+
+TEST(CellClustersTest, ClustersAreCompactAndCullLikeTheirBoxes)
+{
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "1000points.node";
+    reader.eleFile = DATA_DIR "1000points.ele";
+    Mesh mesh = reader.readMesh();
+    PolyMesh result = FaceAlgorithm()(mesh);
+    std::vector<Box3> boxes(mesh.tetras.size());
+    std::vector<int> groups(mesh.tetras.size());
+    Box3 bounds;
+    for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+    {
+        for (int vi : mesh.tetras[ti].vertices)
+            boxes[ti].extend(mesh.vertices[vi]);
+        groups[ti] = result.tetras[ti].polyhedron;
+        bounds.extend(boxes[ti]);
+    }
+
+    for (const auto &grouping : {std::vector<int>(), groups})
+    {
+        CellClusters clusters(boxes, grouping, 64);
+        ASSERT_GT(clusters.size(), 1);
+        std::vector<int> sizes(clusters.size(), 0);
+        for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+        {
+            const int c = clusters.clusterOf(ti);
+            ASSERT_TRUE(c >= 0 && c < clusters.size());
+            EXPECT_TRUE(clusters.box(c).contains(boxes[ti]));
+            ++sizes[c];
+            if (!grouping.empty())
+            {
+                for (int other : result.cells[grouping[ti]].cells)
+                    ASSERT_EQ(clusters.clusterOf(other), c);
+            }
+        }
+        for (int size : sizes)
+            EXPECT_GT(size, 0);
+
+        // Looking at the mesh from outside, only some clusters are in view and they are those of the boxes
+        const auto projection = perspective(0.3f, 1, 0.01f, 1000);
+        Frustum frustum = Frustum::fromMatrix(projection.data());
+        const Vector3 offset = -bounds.center() + Vector3(bounds.sizes().x() / 2, 0, -2 * bounds.sizes().norm());
+        std::vector<Box3> moved(mesh.tetras.size());
+        for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+            moved[ti] = boxes[ti].translated(offset);
+        CellClusters view(moved, grouping, 64);
+        std::vector<int> expected;
+        for (int c = 0; c < view.size(); ++c)
+        {
+            if (frustum.intersects(view.box(c)))
+                expected.push_back(c);
+        }
+        EXPECT_EQ(view.visible(frustum), expected);
+        EXPECT_FALSE(expected.empty());
+        EXPECT_LT(expected.size(), view.size());
+    }
+}
+
+TEST(SphereInstancesTest, FiltersTheCircumspheres)
+{
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "1000points.node";
+    reader.eleFile = DATA_DIR "1000points.ele";
+    Mesh mesh = reader.readMesh();
+    CavityAlgorithm algorithm;
+    PolyMesh result = algorithm(mesh);
+    const auto &cavities = algorithm.cavities();
+    std::vector<int> polyhedra(result.tetras.size());
+    for (int ti = 0; ti < polyhedra.size(); ++ti)
+        polyhedra[ti] = result.tetras[ti].polyhedron;
+
+    std::vector<SphereInstance> instances;
+    fillSphereInstances(cavities, polyhedra, {}, &instances);
+    ASSERT_EQ(instances.size(), std::ranges::count_if(cavities, [](const auto &c) { return std::isfinite(c.radius); }));
+    for (int i = 0; i < instances.size(); ++i)
+    {
+        EXPECT_EQ(instances[i].radius, static_cast<float>(cavities[i].radius));
+        EXPECT_EQ(instances[i].center[0], static_cast<float>(cavities[i].center.x()));
+    }
+
+    // A radius range keeps the order of the tetrahedra, and refilling reuses the storage
+    std::vector<Real> radii;
+    for (const auto &c : cavities)
+        radii.push_back(c.radius);
+    std::ranges::sort(radii);
+    SphereFilter range;
+    range.minRadius = radii[radii.size() / 4];
+    range.maxRadius = radii[radii.size() / 2];
+    const SphereInstance *storage = instances.data();
+    fillSphereInstances(cavities, polyhedra, range, &instances);
+    EXPECT_EQ(instances.data(), storage);
+    std::vector<float> expected;
+    for (const auto &c : cavities)
+    {
+        if (c.radius >= range.minRadius && c.radius <= range.maxRadius)
+            expected.push_back(static_cast<float>(c.radius));
+    }
+    ASSERT_EQ(instances.size(), expected.size());
+    for (int i = 0; i < instances.size(); ++i)
+        EXPECT_EQ(instances[i].radius, expected[i]);
+
+    // The spheres of one polyhedron are those of its tetrahedra
+    const Polyhedron &poly = result.cells[result.cells.size() / 2];
+    SphereFilter owned;
+    owned.owner = result.tetras[poly.cells.front()].polyhedron;
+    fillSphereInstances(cavities, polyhedra, owned, &instances);
+    std::vector<int> tetras = sorted(poly.cells);
+    ASSERT_EQ(instances.size(), tetras.size());
+    for (int i = 0; i < tetras.size(); ++i)
+        EXPECT_EQ(instances[i].radius, static_cast<float>(cavities[tetras[i]].radius));
+}
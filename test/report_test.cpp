@@ -0,0 +1,94 @@
+#include "io.h"
+#include "utils.h"
+#include <gpolylla/report.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+using namespace Polylla;
+
+TEST(ReportTest, MeasureSummary)
+{
+    auto summary = MeasureSummary::of({2, 0, std::nan(""), 8, 3}, 4);
+    EXPECT_DOUBLE_EQ(summary.min, 0);
+    EXPECT_DOUBLE_EQ(summary.max, 8);
+    EXPECT_DOUBLE_EQ(summary.mean, 3.25);
+    EXPECT_EQ(summary.argMin, 1);
+    EXPECT_EQ(summary.argMax, 3);
+    EXPECT_EQ(summary.histogram, std::vector<int>({1, 2, 0, 1}));
+
+    auto flat = MeasureSummary::of({2, 2, 2});
+    EXPECT_EQ(std::accumulate(flat.histogram.begin(), flat.histogram.end(), 0), 3);
+    EXPECT_EQ(MeasureSummary::of({}).argMin, -1);
+}
+
+TEST(ReportTest, WritesPhasesAndQuality)
+{
+    RunReport report;
+    report.input = DATA_DIR "socket.ele";
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "socket.node";
+    reader.eleFile = DATA_DIR "socket.ele";
+    Mesh mesh = report.measure("read", [&] { return reader.readMesh(); });
+    PolyMesh result = report.measure("cavities", [&] { return CavityAlgorithm()(mesh); });
+    report.phase("cavities").tetras = mesh.tetras.size();
+    auto stats = report.measure("stats", [&] { return computeStats(result); });
+    ASSERT_EQ(report.phases.size(), 3);
+    EXPECT_GE(report.phase("cavities").wallMs, 0);
+    EXPECT_THROW(report.phase("write"), std::runtime_error);
+
+    report.setMesh(mesh);
+    report.setResult(result);
+    report.setStats(stats);
+    std::filesystem::create_directories(TEMP_DIR);
+    const std::string file = std::string(TEMP_DIR) + "report.json";
+    report.write(file);
+
+    std::ifstream in(file);
+    std::stringstream content;
+    content << in.rdbuf();
+    const std::string json = content.str();
+    EXPECT_NE(json.find("\"tetras\": " + std::to_string(mesh.tetras.size())), std::string::npos);
+    EXPECT_NE(json.find("\"polyhedra\": " + std::to_string(result.cells.size())), std::string::npos);
+    EXPECT_NE(json.find("\"tetrasPerSecond\""), std::string::npos);
+    EXPECT_NE(json.find("\"peakResidentBytes\""), std::string::npos);
+    for (const char *key : {"\"volumeRatio\"", "\"surfaceRatio\"", "\"edgeRatio\"", "\"histogram\""})
+        EXPECT_NE(json.find(key), std::string::npos) << key;
+    EXPECT_EQ(std::ranges::count(json, '{'), std::ranges::count(json, '}'));
+    EXPECT_EQ(std::ranges::count(json, '['), std::ranges::count(json, ']'));
+}
+
+TEST(ReportTest, EscapesControlCharacters)
+{
+    EXPECT_EQ(jsonString("a\"b\\c"), "\"a\\\"b\\\\c\"");
+    EXPECT_EQ(jsonString("line\nnext\ttab\r"), "\"line\\nnext\\ttab\\r\"");
+    EXPECT_EQ(jsonString(std::string("\x01\x1f", 2)), "\"\\u0001\\u001f\"");
+}
+
+TEST(ReportTest, TotalIsMeasuredAndThreadsComeFromTheContext)
+{
+    RunReport report;
+    report.measure("first", [] {});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    report.measure("second", [] {});
+    CavityAlgorithm algorithm;
+    algorithm.context.threads = 1;
+    report.threads = algorithm.context.threadCount();
+    EXPECT_EQ(report.threads, 1);
+
+    std::filesystem::create_directories(TEMP_DIR);
+    const std::string file = std::string(TEMP_DIR) + "report_total.json";
+    report.write(file);
+    std::ifstream in(file);
+    std::stringstream content;
+    content << in.rdbuf();
+    const std::string json = content.str();
+    const auto at = json.find("\"total\": {\"wallMs\": ");
+    ASSERT_NE(at, std::string::npos);
+    // The gap between the phases is part of the total, not of any phase
+    EXPECT_GE(std::stod(json.substr(at + 20)), 20);
+    EXPECT_NE(json.find("\"threads\": 1,"), std::string::npos);
+}
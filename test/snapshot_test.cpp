@@ -0,0 +1,117 @@
+#include "utils.h"
+#include <gpolylla/render.h>
+#include <gpolylla/snapshot.h>
+#include <fstream>
+#include <iterator>
+
+using namespace Polylla;
+
+namespace
+{
+bool isBackground(const Image &image, int x, int y)
+{
+    const std::uint8_t *p = image.pixel(x, y);
+    return p[0] == 255 && p[1] == 255 && p[2] == 255;
+}
+
+std::vector<std::uint8_t> readBytes(const std::string &file)
+{
+    std::ifstream in(file, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+} // namespace
+
+TEST(SnapshotTest, FramesTheCube)
+{
+    Snapshot snapshot;
+    snapshot.camera = Camera::framing(BASIC_MESH);
+    snapshot.width = 64;
+    snapshot.height = 48;
+    Image image = snapshot(BASIC_MESH);
+    ASSERT_EQ(image.pixels.size(), 64 * 48 * 3);
+    EXPECT_FALSE(isBackground(image, 32, 24));
+    EXPECT_TRUE(isBackground(image, 0, 0));
+    EXPECT_TRUE(isBackground(image, 63, 47));
+
+    // Looking away there is nothing
+    snapshot.camera.target = snapshot.camera.eye * 2;
+    image = snapshot(BASIC_MESH);
+    for (int y = 0; y < image.height; ++y)
+    {
+        for (int x = 0; x < image.width; ++x)
+            ASSERT_TRUE(isBackground(image, x, y));
+    }
+}
+
+TEST(SnapshotTest, PixelsShowTheNearestPolyhedron)
+{
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "mage.node";
+    reader.eleFile = DATA_DIR "mage.ele";
+    Mesh mesh = reader.readMesh();
+    PolyMesh result = FaceAlgorithm()(mesh);
+
+    Snapshot snapshot;
+    snapshot.camera = Camera::framing(result, Vector3(-1, 0.5f, 0.3f));
+    snapshot.width = 160;
+    snapshot.height = 120;
+    Image image = snapshot(result);
+
+    // Every tile on one thread paints the same image
+    Snapshot serial = snapshot;
+    serial.context.threads = 1;
+    EXPECT_EQ(serial(result).pixels, image.pixels);
+
+    // The color of a pixel is that of the polyhedron hit by its ray, up to shading, or the background on a miss
+    const auto colors = cellColors(static_cast<int>(result.cells.size()), snapshot.seed);
+    TetraIndex index(result);
+    int samples = 0, hits = 0, matches = 0;
+    for (int y = 0; y < image.height; y += 3)
+    {
+        for (int x = 0; x < image.width; x += 3)
+        {
+            const auto hit = index.pick(snapshot.camera.eye, snapshot.camera.ray(x, y, image.width, image.height));
+            ++samples;
+            if (hit.tetra == -1)
+            {
+                matches += isBackground(image, x, y);
+                continue;
+            }
+            ++hits;
+            const auto &color = colors[result.tetras[hit.tetra].polyhedron];
+            const std::uint8_t *p = image.pixel(x, y);
+            const Vector3 expected(color[0], color[1], color[2]), actual(p[0], p[1], p[2]);
+            matches += expected.normalized().cross(actual.normalized()).norm() < 0.03f;
+        }
+    }
+    EXPECT_GT(hits, 200);
+    // Pixels on edges between polyhedra may go either way
+    EXPECT_GT(matches, samples * 9 / 10);
+}
+
+TEST(SnapshotTest, WritesPngAndPpm)
+{
+    Image image;
+    image.width = 3;
+    image.height = 2;
+    image.pixels = {255, 0, 0, 0, 255, 0, 0, 0, 255, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    image.write(TEMP_DIR "snapshot.ppm");
+    std::vector<std::uint8_t> ppm = readBytes(TEMP_DIR "snapshot.ppm");
+    const std::string header = "P6\n3 2\n255\n";
+    ASSERT_EQ(ppm.size(), header.size() + image.pixels.size());
+    EXPECT_EQ(std::string(ppm.begin(), ppm.begin() + header.size()), header);
+    EXPECT_TRUE(std::equal(image.pixels.begin(), image.pixels.end(), ppm.begin() + header.size()));
+
+    image.write(TEMP_DIR "snapshot.png");
+    std::vector<std::uint8_t> png = readBytes(TEMP_DIR "snapshot.png");
+    const std::vector<std::uint8_t> signature = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    ASSERT_GT(png.size(), 33);
+    EXPECT_TRUE(std::equal(signature.begin(), signature.end(), png.begin()));
+    EXPECT_EQ(std::string(png.begin() + 12, png.begin() + 16), "IHDR");
+    EXPECT_EQ(png[19], 3);
+    EXPECT_EQ(png[23], 2);
+    EXPECT_EQ(std::string(png.end() - 8, png.end() - 4), "IEND");
+
+    EXPECT_THROW(image.write(TEMP_DIR "snapshot.bmp"), std::invalid_argument);
+}
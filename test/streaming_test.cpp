@@ -0,0 +1,86 @@
+#include "utils.h"
+#include <algorithm>
+#include <filesystem>
+#include <set>
+
+using namespace Polylla;
+
+class StreamingTest : public ::testing::TestWithParam<std::string>
+{
+  protected:
+    static std::set<std::vector<int>> inMemoryCells(const std::string &name)
+    {
+        PolyMesh result = CavityAlgorithm()(readData(name));
+
+        std::set<std::vector<int>> cells;
+        for (auto poly : result.cells)
+        {
+            std::ranges::sort(poly.cells);
+            cells.insert(poly.cells);
+        }
+        return cells;
+    }
+
+    // Runs the streaming algorithm and returns its cells, checking that none is written twice
+    static std::set<std::vector<int>> streamedCells(const std::string &name, int blockSize, float haloFactor = 2.0f)
+    {
+        StreamingCavityAlgorithm algorithm;
+        algorithm.nodeFile = DATA_DIR + name + ".node";
+        algorithm.eleFile = DATA_DIR + name + ".ele";
+        algorithm.outputFile = std::string(TEMP_DIR) + name + "_streaming.visf";
+        algorithm.blockSize = blockSize;
+        algorithm.haloFactor = haloFactor;
+
+        std::set<std::vector<int>> cells;
+        size_t written = 0;
+        algorithm.onPolyhedron = [&](const std::vector<int> &tetras) {
+            auto sorted = tetras;
+            std::ranges::sort(sorted);
+            cells.insert(sorted);
+            written++;
+        };
+        algorithm();
+
+        EXPECT_EQ(written, cells.size()) << "A polyhedron was written twice";
+        EXPECT_TRUE(std::filesystem::exists(algorithm.outputFile));
+        EXPECT_FALSE(std::filesystem::exists(algorithm.outputFile + ".blocks"));
+        std::filesystem::remove(algorithm.outputFile);
+        return cells;
+    }
+
+    // With many blocks the polyhedra near block boundaries may differ from the in-core ones, only the partition
+    // is guaranteed
+    static void expectPartition(const std::string &name, const std::set<std::vector<int>> &cells)
+    {
+        std::vector<int> streamed, expected;
+        for (const auto &cell : cells)
+            streamed.insert(streamed.end(), cell.begin(), cell.end());
+        for (const auto &cell : inMemoryCells(name))
+            expected.insert(expected.end(), cell.begin(), cell.end());
+        std::ranges::sort(streamed);
+        std::ranges::sort(expected);
+        EXPECT_EQ(streamed, expected);
+    }
+};
+
+TEST_P(StreamingTest, EveryTetrahedronInOnePolyhedron)
+{
+    const std::string name = GetParam();
+    // Small blocks so that most polyhedra touch a block boundary
+    expectPartition(name, streamedCells(name, 128));
+}
+
+// Tiny blocks without initial halo reach the halo cap and leave tetrahedra over
+TEST_P(StreamingTest, LeftoversInOnePolyhedron)
+{
+    const std::string name = GetParam();
+    expectPartition(name, streamedCells(name, 8, 0.0f));
+}
+
+TEST_P(StreamingTest, OneBlockSameCellsAsInMemory)
+{
+    const std::string name = GetParam();
+    EXPECT_EQ(streamedCells(name, 1 << 30), inMemoryCells(name));
+}
+
+INSTANTIATE_TEST_SUITE_P(DataMeshes, StreamingTest, ::testing::Values("basic", "3D_100", "socket", "1000points"));
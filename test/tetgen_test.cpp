@@ -15,7 +15,7 @@ TEST_F(TetgenReaderTest, BasicReadMesh)
     Mesh mesh = reader.readMesh();
 
     ASSERT_EQ(mesh.vertices.size(), BASIC_MESH.vertices.size());
-    ASSERT_EQ(mesh.cells.size(), BASIC_MESH.cells.size());
+    ASSERT_EQ(mesh.tetras.size(), BASIC_MESH.tetras.size());
     ASSERT_EQ(mesh.faces.size(), BASIC_MESH.faces.size());
 
     /*
@@ -50,7 +50,7 @@ TEST_F(TetgenReaderTest, BasicReadMesh)
     // checkIn(mesh.cells, BASIC_MESH.cells[2]);
     // checkIn(mesh.cells, BASIC_MESH.cells[3]);
     // checkIn(mesh.cells, BASIC_MESH.cells[4]);
-    checkSimilar(mesh.cells, BASIC_MESH.cells, "Cells");
+    checkSimilar(mesh.tetras, BASIC_MESH.tetras, "Cells");
 
     /*
       0 0 1 2
@@ -0,0 +1,107 @@
+#include "utils.h"
+#include <limits>
+#include <random>
+
+using namespace Polylla;
+
+namespace
+{
+constexpr Real INF = std::numeric_limits<Real>::infinity();
+
+// Distance along the ray to the triangle by solving for the barycentric coordinates, infinity on a miss
+Real crossing(const Vector3 &origin, const Vector3 &direction, const Vector3 &a, const Vector3 &b, const Vector3 &c)
+{
+    Eigen::Matrix<Real, 3, 3> system;
+    system << -direction, b - a, c - a;
+    if (std::abs(system.determinant()) < 1e-12)
+        return INF;
+    const Vector3 tuv = system.partialPivLu().solve(origin - a);
+    const Real eps = 1e-5;
+    if (tuv[0] < 0 || tuv[1] < -eps || tuv[2] < -eps || tuv[1] + tuv[2] > 1 + eps)
+        return INF;
+    return tuv[0];
+}
+
+// Nearest crossing over every face of the accepted tetrahedra
+Real scan(const Mesh &mesh, const Vector3 &origin, const Vector3 &direction, int skip = -1)
+{
+    Real best = INF;
+    for (int ti = 0; ti < mesh.tetras.size(); ++ti)
+    {
+        if (ti == skip)
+            continue;
+        for (int fi : mesh.tetras[ti].faces)
+        {
+            const auto &v = mesh.faces[fi].vertices;
+            best = std::min(best, crossing(origin, direction, mesh.vertices[v[0]], mesh.vertices[v[1]],
+                                           mesh.vertices[v[2]]));
+        }
+    }
+    return best;
+}
+} // namespace
+
+TEST(TetraIndexTest, PicksTheCubeFromOutside)
+{
+    TetraIndex index(BASIC_MESH);
+    TetraIndex::Hit hit = index.pick(Vector3(-1, 0.3f, 0.6f), Vector3(1, 0, 0));
+    ASSERT_NE(hit.tetra, -1);
+    EXPECT_NEAR(hit.distance, 1, 1e-5);
+    // The face hit is on the boundary of the cube, at x = 0
+    const Face &face = BASIC_MESH.faces[hit.face];
+    EXPECT_EQ(face.tetras[1], -1);
+    for (int vi : face.vertices)
+        EXPECT_EQ(BASIC_MESH.vertices[vi].x(), 0);
+    checkIn(std::vector<int>(BASIC_MESH.tetras[hit.tetra].faces.begin(), BASIC_MESH.tetras[hit.tetra].faces.end()),
+            hit.face, "Face of the tetrahedron");
+
+    EXPECT_EQ(index.pick(Vector3(-1, 0.3f, 0.6f), Vector3(-1, 0, 0)).tetra, -1);
+    EXPECT_EQ(index.pick(Vector3(-1, 2, 0.6f), Vector3(1, 0, 0)).tetra, -1);
+    EXPECT_EQ(TetraIndex().pick(Vector3::Zero(), Vector3(1, 0, 0)).tetra, -1);
+}
+
+TEST(TetraIndexTest, MatchesScan)
+{
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "1000points.node";
+    reader.eleFile = DATA_DIR "1000points.ele";
+    Mesh mesh = reader.readMesh();
+    TetraIndex index(mesh);
+
+    Box3 bounds;
+    for (const auto &v : mesh.vertices)
+        bounds.extend(v);
+    std::mt19937 random(7);
+    std::uniform_real_distribution<Real> unit(0, 1), signed_(-1, 1);
+    int hits = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        // From outside the mesh towards a point inside it
+        const Vector3 target = bounds.min() + bounds.sizes().cwiseProduct(Vector3(unit(random), unit(random),
+                                                                                  unit(random)));
+        const Vector3 origin = target + 2 * bounds.sizes().norm() *
+                                            Vector3(signed_(random), signed_(random), signed_(random)).normalized();
+        const Vector3 direction = (target - origin).normalized();
+
+        const TetraIndex::Hit hit = index.pick(origin, direction);
+        const Real expected = scan(mesh, origin, direction);
+        if (expected == INF)
+        {
+            EXPECT_EQ(hit.tetra, -1) << "Ray " << i;
+            continue;
+        }
+        ASSERT_NE(hit.tetra, -1) << "Ray " << i;
+        EXPECT_NEAR(hit.distance, expected, 1e-3) << "Ray " << i;
+        ++hits;
+
+        // Skipping the picked tetrahedron hits the next one, never a closer one
+        const TetraIndex::Hit next = index.pick(origin, direction, [&](int ti) { return ti != hit.tetra; });
+        ASSERT_NE(next.tetra, hit.tetra);
+        if (next.tetra != -1)
+        {
+            EXPECT_GE(next.distance, hit.distance - 1e-4) << "Ray " << i;
+            EXPECT_NEAR(next.distance, scan(mesh, origin, direction, hit.tetra), 1e-3) << "Ray " << i;
+        }
+    }
+    EXPECT_GT(hits, 50);
+}
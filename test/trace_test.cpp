@@ -0,0 +1,75 @@
+#include "trace.h"
+#include "utils.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace Polylla;
+
+static std::string readFile(const std::string &file)
+{
+    std::ifstream in(file);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+TEST(TraceTest, WritesChromeTrace)
+{
+    std::filesystem::create_directories(TEMP_DIR);
+    const std::string file = std::string(TEMP_DIR) + "trace.json";
+
+    clearTrace();
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR "socket.node";
+    reader.eleFile = DATA_DIR "socket.ele";
+    CavityAlgorithm algorithm;
+    algorithm(reader.readMesh());
+    writeTrace(file);
+
+    std::string trace = readFile(file);
+    EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0);
+    EXPECT_EQ(trace.substr(trace.size() - 3), "]}\n");
+    if (!tracingEnabled())
+    {
+        EXPECT_EQ(trace.find("\"ph\""), std::string::npos);
+        return;
+    }
+    for (const char *name : {"TetgenReader::readMesh", "buildFaces", "labelCavities", "buildCavities"})
+        EXPECT_NE(trace.find(std::string("{\"name\":\"") + name + "\",\"ph\":\"X\""), std::string::npos) << name;
+    EXPECT_NE(trace.find("{\"name\":\"tetras visited\",\"ph\":\"C\""), std::string::npos);
+    EXPECT_NE(trace.find("\"allocations\":"), std::string::npos);
+
+    clearTrace();
+    writeTrace(file);
+    EXPECT_EQ(readFile(file).find("\"ph\""), std::string::npos);
+}
+
+TEST(TraceTest, WritesWhileThreadsRecord)
+{
+    std::filesystem::create_directories(TEMP_DIR);
+    const std::string file = std::string(TEMP_DIR) + "trace_concurrent.json";
+
+    std::atomic<bool> stop = false;
+    std::thread recording([&] {
+        while (!stop)
+        {
+            GPOLYLLA_TRACE_SCOPE("recording");
+            GPOLYLLA_TRACE_COUNTER("recorded", 1);
+        }
+    });
+    for (int i = 0; i < 20; ++i)
+    {
+        writeTrace(file);
+        clearTrace();
+    }
+    stop = true;
+    recording.join();
+
+    writeTrace(file);
+    std::string trace = readFile(file);
+    EXPECT_EQ(trace.substr(trace.size() - 3), "]}\n");
+    clearTrace();
+}
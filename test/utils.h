@@ -21,19 +21,16 @@ void checkSimilar(const std::vector<T> &subject, const std::vector<T> &expected,
     }
 }
 
-const Mesh BASIC_MESH = {
-    .vertices = {Vertex(0, 0, 0), Vertex(0, 0, 1), Vertex(1, 0, 1), Vertex(1, 0, 0), Vertex(0, 1, 0), Vertex(0, 1, 1),
-                 Vertex(1, 1, 1), Vertex(1, 1, 0)},
-    .faces = {Face({0, 1, 2}, {0, -1}), Face({0, 1, 5}, {0, -1}), Face({2, 3, 0}, {1, -1}), Face({0, 5, 2}, {0, 4}),
-              Face({0, 7, 2}, {1, 4}), Face({7, 3, 0}, {1, -1}), Face({5, 4, 0}, {3, -1}), Face({0, 4, 7}, {3, -1}),
-              Face({0, 5, 7}, {3, 4}), Face({2, 1, 5}, {0, -1}), Face({2, 3, 7}, {1, -1}), Face({5, 6, 2}, {2, -1}),
-              Face({5, 2, 7}, {2, 4}), Face({7, 6, 2}, {2, -1}), Face({7, 4, 5}, {3, -1}), Face({5, 6, 7}, {2, -1})},
-    .cells = {Tetrahedron({1, 0, 2, 5}, {0, 1, 3, 9}), Tetrahedron({0, 2, 3, 7}, {2, 5, 4, 10}),
-              Tetrahedron({2, 5, 6, 7}, {11, 12, 13, 15}), Tetrahedron({5, 7, 0, 4}, {8, 6, 7, 14}),
-              Tetrahedron({5, 2, 0, 7}, {3, 4, 8, 12})},
-};
+// Tetgen mesh of the data directory, by its name without extension
+inline Mesh readData(const std::string &name)
+{
+    TetgenReader reader;
+    reader.nodeFile = DATA_DIR + name + ".node";
+    reader.eleFile = DATA_DIR + name + ".ele";
+    return reader.readMesh();
+}
 
-const PolyMesh BASIC_POLY_MESH = {
+const Mesh BASIC_MESH = {
     .vertices = {Vertex(0, 0, 0), Vertex(0, 0, 1), Vertex(1, 0, 1), Vertex(1, 0, 0), Vertex(0, 1, 0), Vertex(0, 1, 1),
                  Vertex(1, 1, 1), Vertex(1, 1, 0)},
     .faces = {Face({0, 1, 2}, {0, -1}), Face({0, 1, 5}, {0, -1}), Face({2, 3, 0}, {1, -1}), Face({0, 5, 2}, {0, 4}),
@@ -43,8 +40,12 @@ const PolyMesh BASIC_POLY_MESH = {
     .tetras = {Tetrahedron({1, 0, 2, 5}, {0, 1, 3, 9}), Tetrahedron({0, 2, 3, 7}, {2, 5, 4, 10}),
                Tetrahedron({2, 5, 6, 7}, {11, 12, 13, 15}), Tetrahedron({5, 7, 0, 4}, {8, 6, 7, 14}),
                Tetrahedron({5, 2, 0, 7}, {3, 4, 8, 12})},
-    .cells = {Polyhedron({0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 5, 6, 7, 9, 10, 11, 13, 14, 15}, {0, 1, 2, 3, 4})}
+};
 
+// PolyMesh has a base class, so designated initializers cannot reach the Mesh members
+const PolyMesh BASIC_POLY_MESH = {
+    BASIC_MESH,
+    {Polyhedron({0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 5, 6, 7, 9, 10, 11, 13, 14, 15}, {0, 1, 2, 3, 4})},
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "io.h"
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <gpolylla/polylla.h>
+#include <gtest/gtest.h>
+
+using namespace Polylla;
+
+namespace
+{
+// Binary VisF of a mesh read back, in the given byte order
+void writeBinary(const PolyMesh &mesh, const std::string &file, bool bigEndian)
+{
+    std::ofstream out(file, std::ios::binary);
+    out << (bigEndian ? 0 : 1) << " " << 2 << "\n";
+    auto put = [&](auto value) {
+        auto bytes = std::bit_cast<std::array<char, sizeof(value)>>(value);
+        if (bigEndian != (std::endian::native == std::endian::big))
+            std::ranges::reverse(bytes);
+        out.write(bytes.data(), bytes.size());
+    };
+    put(static_cast<int32_t>(mesh.vertices.size()));
+    for (const auto &v : mesh.vertices)
+    {
+        put(static_cast<double>(v.x()));
+        put(static_cast<double>(v.y()));
+        put(static_cast<double>(v.z()));
+    }
+    put(static_cast<int32_t>(mesh.faces.size()));
+    for (const auto &f : mesh.faces)
+    {
+        put(int32_t(3));
+        for (int vi : f.vertices)
+            put(static_cast<int32_t>(vi));
+    }
+    put(int32_t(0));
+    put(static_cast<int32_t>(mesh.cells.size()));
+    for (const auto &poly : mesh.cells)
+    {
+        put(static_cast<int32_t>(poly.faces.size()));
+        for (int fi : poly.faces)
+            put(static_cast<int32_t>(fi));
+    }
+}
+
+void expectSame(const PolyMesh &subject, const PolyMesh &expected)
+{
+    ASSERT_EQ(subject.vertices.size(), expected.vertices.size());
+    for (int vi = 0; vi < subject.vertices.size(); ++vi)
+        EXPECT_EQ(subject.vertices[vi], expected.vertices[vi]) << vi;
+    ASSERT_EQ(subject.faces.size(), expected.faces.size());
+    for (int fi = 0; fi < subject.faces.size(); ++fi)
+        EXPECT_EQ(subject.faces[fi].vertices, expected.faces[fi].vertices) << fi;
+    ASSERT_EQ(subject.cells.size(), expected.cells.size());
+    for (int pi = 0; pi < subject.cells.size(); ++pi)
+    {
+        EXPECT_EQ(subject.cells[pi].faces, expected.cells[pi].faces) << pi;
+        EXPECT_EQ(subject.cells[pi].vertices, expected.cells[pi].vertices) << pi;
+    }
+}
+} // namespace
+
+TEST(VisFReaderTest, ReadsWhatTheWriterWrote)
+{
+    TetgenReader tetgen;
+    tetgen.nodeFile = DATA_DIR "1000points.node";
+    tetgen.eleFile = DATA_DIR "1000points.ele";
+    CavityAlgorithm algorithm;
+    PolyMesh result = algorithm(tetgen.readMesh());
+    VisFWriter writer;
+    writer.outputFile = TEMP_DIR "reader_roundtrip.visf";
+    writer.writeMesh(result);
+
+    VisFReader reader;
+    reader.inputFile = writer.outputFile;
+    PolyMesh read = reader.readMesh();
+    ASSERT_EQ(read.vertices.size(), result.vertices.size());
+    for (int vi = 0; vi < read.vertices.size(); ++vi)
+        EXPECT_LT((read.vertices[vi] - result.vertices[vi]).norm(), 1e-4 * (1 + result.vertices[vi].norm())) << vi;
+    EXPECT_TRUE(read.tetras.empty());
+
+    // Every polyhedron gets its directed faces back, in order
+    ASSERT_EQ(read.cells.size(), result.cells.size());
+    for (int pi = 0; pi < read.cells.size(); ++pi)
+    {
+        auto faces = directedFaces(result.cells[pi], result);
+        ASSERT_EQ(read.cells[pi].faces.size(), faces.size()) << pi;
+        std::vector<int> vertices;
+        for (int k = 0; k < faces.size(); ++k)
+        {
+            EXPECT_EQ(read.faces[read.cells[pi].faces[k]].vertices, faces[k]) << pi;
+            vertices.insert(vertices.end(), faces[k].begin(), faces[k].end());
+        }
+        std::ranges::sort(vertices);
+        vertices.erase(std::ranges::unique(vertices).begin(), vertices.end());
+        EXPECT_EQ(read.cells[pi].vertices, vertices) << pi;
+    }
+}
+
+TEST(VisFReaderTest, ReadsBinaryInBothByteOrders)
+{
+    VisFReader reader;
+    reader.inputFile = DATA_DIR "socket.visf";
+    PolyMesh ascii = reader.readMesh();
+    ASSERT_FALSE(ascii.cells.empty());
+
+    for (bool bigEndian : {false, true})
+    {
+        reader.inputFile = TEMP_DIR "socket_binary.visf";
+        writeBinary(ascii, reader.inputFile, bigEndian);
+        expectSame(reader.readMesh(), ascii);
+    }
+}
+
+TEST(VisFReaderTest, ReadsWhatTheBinaryWriterWrote)
+{
+    TetgenReader tetgen;
+    tetgen.nodeFile = DATA_DIR "socket.node";
+    tetgen.eleFile = DATA_DIR "socket.ele";
+    CavityAlgorithm algorithm;
+    PolyMesh result = algorithm(tetgen.readMesh());
+    VisFWriter writer;
+    writer.outputFile = TEMP_DIR "writer_text.visf";
+    writer.writeMesh(result);
+    VisFReader reader;
+    reader.inputFile = writer.outputFile;
+    PolyMesh text = reader.readMesh();
+
+    writer.binary = true;
+    writer.outputFile = TEMP_DIR "writer_binary.visf";
+    writer.writeMesh(result);
+    reader.inputFile = writer.outputFile;
+    PolyMesh binary = reader.readMesh();
+
+    // Coordinates are kept exactly, unlike in text
+    text.vertices = result.vertices;
+    expectSame(binary, text);
+}
+
+TEST(VisFReaderTest, RejectsBrokenFiles)
+{
+    VisFReader reader;
+    reader.inputFile = TEMP_DIR "missing.visf";
+    EXPECT_THROW(reader.readMesh(), FileNotFoundError);
+
+    auto write = [&](const std::string &text) {
+        reader.inputFile = TEMP_DIR "broken.visf";
+        std::ofstream(reader.inputFile) << text;
+    };
+    // A face over a vertex that does not exist, on the seventh line
+    write("2 2\n3\n0 0 0\n1 0 0\n0 1 0\n1\n3 0 1 3\n0\n1\n1 0\n");
+    try
+    {
+        reader.readMesh();
+        FAIL() << "Read a face out of range";
+    }
+    catch (const std::runtime_error &e)
+    {
+        EXPECT_NE(std::string(e.what()).find("line 7"), std::string::npos) << e.what();
+    }
+    write("2 2\n3\n0 0 0\n1 0 0\n");
+    EXPECT_THROW(reader.readMesh(), std::runtime_error);
+    write("2 1\n");
+    EXPECT_THROW(reader.readMesh(), std::runtime_error);
+
+    // Without a final newline the last polyhedron is still read
+    write("2 2\n3\n0 0 0\n1 0 0\n0 1 0\n1\n3 0 1 2\n0\n1\n1 0");
+    PolyMesh mesh = reader.readMesh();
+    ASSERT_EQ(mesh.cells.size(), 1);
+    EXPECT_EQ(mesh.cells[0].vertices, std::vector<int>({0, 1, 2}));
+}